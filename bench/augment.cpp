@@ -0,0 +1,103 @@
+// range aggregates and interval overlap queries answered from the
+// augmentation against scanning the same tree, plus what maintaining the
+// aggregates costs on insert.
+//
+// usage: bench/augment [entries] [queries]
+
+#include "./bench.hpp"
+#include "../map/RBTree.hpp"
+#include "../map/interval_map.hpp"
+
+typedef ft::RBTree<int, long> plain_tree;
+typedef ft::RBTree<int, long, std::less<int>, std::allocator<ft::pair<const int, long> >, ft::subtree_sum<long> > sum_tree;
+typedef ft::interval_map<int, int> intervals;
+
+// sum of the values in [lo, hi) by walking from lower_bound
+template <typename Tree>
+static long scan_sum(const Tree &tree, int lo, int hi) {
+	long sum = 0;
+	for (typename Tree::const_iterator it = tree.lower_bound(lo); it != tree.end() && it->first < hi; ++it)
+		sum += it->second;
+	return sum;
+}
+
+template <typename Tree>
+static void fill(const char *name, Tree &tree, const std::vector<int> &keys) {
+	bench::timer t;
+	for (std::size_t i = 0; i < keys.size(); ++i)
+		tree.insert(ft::pair<const int, long>(keys[i], keys[i] % 1000));
+	bench::report(name, "insert", keys.size(), t.seconds(), 0);
+}
+
+static void range_sums(const sum_tree &tree, const std::vector<int> &keys, std::size_t queries, std::size_t width) {
+	char op[32];
+	long sum = 0;
+
+	std::snprintf(op, sizeof(op), "range_sum/%zu", width);
+	bench::timer t;
+	for (std::size_t i = 0; i < queries; ++i)
+		sum += tree.range_sum(keys[i % keys.size()], keys[i % keys.size()] + static_cast<int>(width));
+	bench::report("RBTree<subtree_sum>", op, queries, t.seconds(), 0);
+
+	std::snprintf(op, sizeof(op), "scan/%zu", width);
+	t.reset();
+	for (std::size_t i = 0; i < queries; ++i)
+		sum -= scan_sum(tree, keys[i % keys.size()], keys[i % keys.size()] + static_cast<int>(width));
+	bench::report("RBTree<subtree_sum>", op, queries, t.seconds(), 0);
+	// both loops add up the same ranges
+	if (sum != 0)
+		std::printf("mismatch\n");
+}
+
+// intervals [k, k + 1 + k % 64) for every key, so about 32 of them
+// cover any point
+static void overlaps(const std::vector<int> &keys, std::size_t queries) {
+	intervals im;
+	std::vector<intervals::const_iterator> out;
+	std::size_t found = 0;
+
+	bench::timer t;
+	for (std::size_t i = 0; i < keys.size(); ++i)
+		im.insert(keys[i], keys[i] + 1 + keys[i] % 64, keys[i]);
+	bench::report("interval_map", "insert", keys.size(), t.seconds(), 0);
+
+	t.reset();
+	for (std::size_t i = 0; i < queries; ++i) {
+		out.clear();
+		im.find_overlaps(keys[i % keys.size()], keys[i % keys.size()] + 16, std::back_inserter(out));
+		found += out.size();
+	}
+	bench::report("interval_map", "find_overlaps", queries, t.seconds(), 0);
+
+	t.reset();
+	for (std::size_t i = 0; i < queries; ++i) {
+		int lo = keys[i % keys.size()];
+		int hi = lo + 16;
+		out.clear();
+		for (intervals::const_iterator it = im.begin(); it != im.end() && it->first.low < hi; ++it)
+			if (lo < it->first.high)
+				out.push_back(it);
+		found -= out.size();
+	}
+	bench::report("interval_map", "scan_overlaps", queries, t.seconds(), 0);
+	if (found != 0)
+		std::printf("mismatch\n");
+}
+
+int main(int argc, char **argv) {
+	std::size_t n = bench::arg_size(argc, argv, 1, 1000000);
+	std::size_t queries = bench::arg_size(argc, argv, 2, 1000);
+	std::vector<int> keys = bench::shuffled_keys(n);
+
+	plain_tree plain;
+	sum_tree sums;
+	fill("RBTree<no_augment>", plain, keys);
+	fill("RBTree<subtree_sum>", sums, keys);
+
+	range_sums(sums, keys, queries, 16);
+	range_sums(sums, keys, queries, 1024);
+	range_sums(sums, keys, queries, n / 4);
+
+	overlaps(keys, queries);
+	return 0;
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+// tiny helpers shared by the benchmark programs, every bench/*.cpp is a
+// single translation unit so the replacement operator new below is
+// defined exactly once per binary.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstddef>
+#include <new>
+#include <vector>
+#include <random>
+#include <string>
+#ifdef __GLIBC__
+# include <malloc.h>
+#endif
+
+namespace bench {
+	// bumped by every operator new of any thread, a relaxed counter:
+	// only the total matters, not its order with other memory
+	inline std::atomic<std::size_t> &allocationCount() {
+		static std::atomic<std::size_t> count(0);
+		return count;
+	}
+
+	// number of calls to the global operator new since program start
+	inline std::size_t allocations() {
+		return allocationCount().load(std::memory_order_relaxed);
+	}
+
+	// bytes of heap currently in use, 0 where the C library can't tell
+	inline std::size_t heap_in_use() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+		return mallinfo2().uordblks;
+#else
+		return 0;
+#endif
+	}
+
+	class timer {
+		private:
+			std::chrono::steady_clock::time_point _start;
+
+		public:
+			timer() : _start(std::chrono::steady_clock::now()) {}
+
+			void reset() { _start = std::chrono::steady_clock::now(); }
+
+			double seconds() const {
+				return std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+			}
+	};
+
+	// keys 0..n-1 in a random order
+	inline std::vector<int> shuffled_keys(std::size_t n, unsigned seed = 42) {
+		std::vector<int> keys(n);
+		for (std::size_t i = 0; i < n; ++i)
+			keys[i] = static_cast<int>(i);
+		std::shuffle(keys.begin(), keys.end(), std::mt19937(seed));
+		return keys;
+	}
+
+	// size from the command line, default otherwise
+	inline std::size_t arg_size(int argc, char **argv, int i, std::size_t def) {
+		return argc > i ? static_cast<std::size_t>(std::strtoull(argv[i], NULL, 10)) : def;
+	}
+
+	// one result line: what, how many ops, ns per op, allocations per op
+	inline void report(const char *container, const char *op, std::size_t n, double secs, std::size_t allocs) {
+		std::printf("%-24s %-16s n=%-10zu %10.2f ns/op %8.3f allocs/op\n",
+			container, op, n, secs * 1e9 / n, static_cast<double>(allocs) / n);
+	}
+
+	// malloc behind every replacement operator new below, counted, with
+	// alignment 0 for the default one. NULL when out of memory
+	inline void *tryAllocate(std::size_t size, std::size_t alignment = 0) {
+		allocationCount().fetch_add(1, std::memory_order_relaxed);
+		if (size == 0)
+			size = 1;
+		if (alignment == 0)
+			return std::malloc(size);
+		// aligned_alloc wants a multiple of the alignment
+		return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+	}
+
+	inline void *allocate(std::size_t size, std::size_t alignment = 0) {
+		if (void *p = tryAllocate(size, alignment))
+			return p;
+		throw std::bad_alloc();
+	}
+
+	// keep the optimizer from dropping a computed value
+	template <typename T>
+	inline void do_not_optimize(const T &value) {
+		asm volatile("" : : "r,m"(value) : "memory");
+	}
+}
+
+// every form of the global operators, so that all allocations are counted
+// and each free goes back to the C library that made it
+void *operator new(std::size_t size) { return bench::allocate(size); }
+void *operator new[](std::size_t size) { return bench::allocate(size); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept { return bench::tryAllocate(size); }
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept { return bench::tryAllocate(size); }
+void *operator new(std::size_t size, std::align_val_t al) { return bench::allocate(size, static_cast<std::size_t>(al)); }
+void *operator new[](std::size_t size, std::align_val_t al) { return bench::allocate(size, static_cast<std::size_t>(al)); }
+void *operator new(std::size_t size, std::align_val_t al, const std::nothrow_t &) noexcept { return bench::tryAllocate(size, static_cast<std::size_t>(al)); }
+void *operator new[](std::size_t size, std::align_val_t al, const std::nothrow_t &) noexcept { return bench::tryAllocate(size, static_cast<std::size_t>(al)); }
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t, const std::nothrow_t &) noexcept { std::free(p); }
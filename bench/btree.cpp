@@ -0,0 +1,50 @@
+// ft::btree_map against ft::map and std::map from 1K entries up: random
+// insert, random find and a full in-order scan, at every power of ten up
+// to the largest size asked for.
+//
+// usage: bench/btree [max_entries] [queries]
+// (100M entries need about 10 GB for the three containers together)
+
+#include "./bench.hpp"
+#include "../map/map.hpp"
+#include "../map/btree_map.hpp"
+#include <map>
+
+template <typename Map>
+static void run(const char *name, const std::vector<int> &keys, std::size_t queries) {
+	std::size_t n = keys.size();
+	Map map;
+
+	bench::timer t;
+	for (std::size_t i = 0; i < n; ++i)
+		map.insert(typename Map::value_type(keys[i], keys[i]));
+	bench::report(name, "insert", n, t.seconds(), 0);
+
+	// queries in an order unrelated to the insertion order
+	std::size_t found = 0;
+	t.reset();
+	for (std::size_t i = 0; i < queries; ++i)
+		found += map.find(keys[(i * 7919) % n]) != map.end();
+	bench::report(name, "find", queries, t.seconds(), 0);
+
+	long sum = 0;
+	t.reset();
+	for (typename Map::const_iterator it = map.begin(); it != map.end(); ++it)
+		sum += it->second;
+	bench::report(name, "scan", n, t.seconds(), 0);
+	bench::do_not_optimize(found);
+	bench::do_not_optimize(sum);
+}
+
+int main(int argc, char **argv) {
+	std::size_t max_n = bench::arg_size(argc, argv, 1, 1000000);
+	std::size_t queries = bench::arg_size(argc, argv, 2, 1000000);
+
+	for (std::size_t n = 1000; n <= max_n; n *= 10) {
+		std::vector<int> keys = bench::shuffled_keys(n);
+		run<ft::btree_map<int, int> >("ft::btree_map", keys, queries);
+		run<ft::map<int, int> >("ft::map", keys, queries);
+		run<std::map<int, int> >("std::map", keys, queries);
+	}
+	return 0;
+}
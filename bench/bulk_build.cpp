@@ -0,0 +1,49 @@
+// cold start from a sorted snapshot: O(n) range construction against
+// repeated insert, hinted insert and std::map's range constructor.
+//
+// usage: bench/bulk_build [entries]
+
+#include "./bench.hpp"
+#include "../map/map.hpp"
+#include <map>
+
+int main(int argc, char **argv) {
+	std::size_t n = bench::arg_size(argc, argv, 1, 10000000);
+	std::vector<ft::pair<int, int> > snapshot;
+	std::vector<std::pair<int, int> > std_snapshot;
+	for (std::size_t i = 0; i < n; ++i) {
+		snapshot.push_back(ft::pair<int, int>(static_cast<int>(i), static_cast<int>(i)));
+		std_snapshot.push_back(std::pair<int, int>(static_cast<int>(i), static_cast<int>(i)));
+	}
+
+	bench::timer t;
+	{
+		std::size_t allocs = bench::allocations();
+		t.reset();
+		ft::map<int, int> map(snapshot.begin(), snapshot.end());
+		bench::report("ft::map<int,int>", "range ctor", n, t.seconds(), bench::allocations() - allocs);
+	}
+	{
+		std::size_t allocs = bench::allocations();
+		t.reset();
+		ft::map<int, int> map;
+		for (std::size_t i = 0; i < n; ++i)
+			map.insert(snapshot[i]);
+		bench::report("ft::map<int,int>", "insert", n, t.seconds(), bench::allocations() - allocs);
+	}
+	{
+		std::size_t allocs = bench::allocations();
+		t.reset();
+		ft::map<int, int> map;
+		for (std::size_t i = 0; i < n; ++i)
+			map.insert(map.end(), snapshot[i]);
+		bench::report("ft::map<int,int>", "insert(end)", n, t.seconds(), bench::allocations() - allocs);
+	}
+	{
+		std::size_t allocs = bench::allocations();
+		t.reset();
+		std::map<int, int> map(std_snapshot.begin(), std_snapshot.end());
+		bench::report("std::map<int,int>", "range ctor", n, t.seconds(), bench::allocations() - allocs);
+	}
+	return 0;
+}
@@ -0,0 +1,94 @@
+// ft::concurrent_map against an ft::map behind one mutex, with 1, 2, 4 ...
+// up to max_threads threads running a 90/10 and a 50/50 mix of finds and
+// writes (half inserts, half erases) on random keys of a prefilled map.
+//
+// usage: bench/concurrent [entries] [ops_per_thread] [max_threads]
+
+#include "./bench.hpp"
+#include "../map/concurrent_map.hpp"
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+// the baseline: every operation takes the one lock
+class locked_map {
+	public:
+		bool find(int k, int &out) const {
+			std::lock_guard<std::mutex> guard(_lock);
+			ft::map<int, int>::const_iterator it = _map.find(k);
+			if (it == _map.end())
+				return false;
+			out = it->second;
+			return true;
+		}
+		bool insert(const ft::pair<const int, int> &x) {
+			std::lock_guard<std::mutex> guard(_lock);
+			return _map.insert(x).second;
+		}
+		std::size_t erase(int k) {
+			std::lock_guard<std::mutex> guard(_lock);
+			return _map.erase(k);
+		}
+
+	private:
+		mutable std::mutex _lock;
+		ft::map<int, int> _map;
+};
+
+template <typename Map>
+static void run(const char *container, Map &map, std::size_t n, std::size_t ops, std::size_t threads, unsigned read_percent) {
+	for (std::size_t i = 0; i < n; i += 2)
+		map.insert(ft::pair<const int, int>(static_cast<int>(i), 0));
+
+	std::vector<std::thread> pool;
+	bench::timer t;
+	for (std::size_t id = 0; id < threads; ++id) {
+		pool.push_back(std::thread([&map, n, ops, read_percent, id] {
+			// xorshift, cheaper than the operations it drives
+			std::uint64_t x = 0x9e3779b97f4a7c15ull * (id + 1);
+			std::size_t found = 0;
+			for (std::size_t i = 0; i < ops; ++i) {
+				x ^= x << 13;
+				x ^= x >> 7;
+				x ^= x << 17;
+				int k = static_cast<int>(x % n);
+				int v;
+				if ((x >> 40) % 100 < read_percent)
+					found += map.find(k, v);
+				else if ((x >> 32) & 1)
+					map.insert(ft::pair<const int, int>(k, 0));
+				else
+					map.erase(k);
+			}
+			bench::do_not_optimize(found);
+		}));
+	}
+	for (std::size_t i = 0; i < pool.size(); ++i)
+		pool[i].join();
+
+	char op[32];
+	std::snprintf(op, sizeof(op), "%u/%u t=%zu", read_percent, 100 - read_percent, threads);
+	bench::report(container, op, ops * threads, t.seconds(), 0);
+}
+
+int main(int argc, char **argv) {
+	std::size_t n = bench::arg_size(argc, argv, 1, 1000000);
+	std::size_t ops = bench::arg_size(argc, argv, 2, 1000000);
+	std::size_t hw = std::thread::hardware_concurrency();
+	std::size_t max_threads = bench::arg_size(argc, argv, 3, hw ? hw : 1);
+
+	const unsigned mixes[] = { 90, 50 };
+	for (std::size_t m = 0; m < 2; ++m) {
+		for (std::size_t threads = 1; threads <= max_threads; threads *= 2) {
+			{
+				ft::concurrent_map<int, int> map;
+				run("ft::concurrent_map", map, n, ops, threads, mixes[m]);
+			}
+			{
+				locked_map map;
+				run("mutex + ft::map", map, n, ops, threads, mixes[m]);
+			}
+		}
+	}
+	return 0;
+}
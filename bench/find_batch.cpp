@@ -0,0 +1,55 @@
+// ft::map::find_batch against a loop of single find calls, for request
+// sized batches of 16 to 256 random keys, on maps from 100K entries up to
+// the largest size asked for (the default, 10M entries, is far past any
+// last level cache).
+//
+// usage: bench/find_batch [max_entries] [queries]
+
+#include "./bench.hpp"
+#include "../map/map.hpp"
+
+int main(int argc, char **argv) {
+	std::size_t max_n = bench::arg_size(argc, argv, 1, 10000000);
+	std::size_t queries = bench::arg_size(argc, argv, 2, 1 << 20);
+	const std::size_t batches[] = {16, 64, 256};
+
+	for (std::size_t n = 100000; n <= max_n; n *= 10) {
+		std::vector<int> keys = bench::shuffled_keys(n);
+		ft::map<int, int> map;
+		for (std::size_t i = 0; i < n; ++i)
+			map.insert(ft::make_pair(keys[i], keys[i]));
+		// every batch is a fresh set of random keys
+		std::vector<int> probes = bench::shuffled_keys(n, 7);
+		probes.resize(std::min(n, queries));
+
+		for (std::size_t b = 0; b < sizeof(batches) / sizeof(*batches); ++b) {
+			std::size_t batch = batches[b];
+			std::size_t total = probes.size() / batch * batch;
+			std::vector<ft::map<int, int>::const_iterator> out(batch);
+			const ft::map<int, int> &m = map;
+			char label[32];
+			std::snprintf(label, sizeof(label), "batch=%zu", batch);
+
+			long sum = 0;
+			bench::timer t;
+			for (std::size_t i = 0; i < total; i += batch) {
+				for (std::size_t j = 0; j < batch; ++j)
+					out[j] = m.find(probes[i + j]);
+				sum += out[batch - 1]->second;
+			}
+			double single = t.seconds();
+			bench::report("find loop", label, total, single, 0);
+
+			t.reset();
+			for (std::size_t i = 0; i < total; i += batch) {
+				m.find_batch(probes.begin() + i, probes.begin() + i + batch, out.begin());
+				sum += out[batch - 1]->second;
+			}
+			double batched = t.seconds();
+			bench::report("find_batch", label, total, batched, 0);
+			std::printf("%-24s %-16s n=%-10zu %10.2fx speedup\n", "find_batch", label, n, single / batched);
+			bench::do_not_optimize(sum);
+		}
+	}
+	return 0;
+}
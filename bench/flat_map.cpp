@@ -0,0 +1,73 @@
+// ft::flat_map lookups against the tree maps on the same keys, from 1K
+// entries up to the largest size asked for, plus the cost of building
+// the flat map from unsorted input and from an ft::map.
+//
+// usage: bench/flat_map [max_entries] [queries]
+// build with -march=native to get the AVX2 compare paths
+
+#include "./bench.hpp"
+#include "../map/map.hpp"
+#include "../map/btree_map.hpp"
+#include "../map/flat_map.hpp"
+#include <map>
+
+template <typename Map>
+static void lookups(const char *name, const Map &map, const std::vector<int> &keys, std::size_t queries) {
+	std::size_t n = keys.size();
+	std::size_t found = 0;
+	bench::timer t;
+	for (std::size_t i = 0; i < queries; ++i)
+		found += map.find(keys[(i * 7919) % n]) != map.end();
+	bench::report(name, "find", queries, t.seconds(), 0);
+
+	// half of these miss: odd keys are never inserted below
+	std::size_t hits = 0;
+	t.reset();
+	for (std::size_t i = 0; i < queries; ++i)
+		hits += map.count(static_cast<int>((i * 7919) % (2 * n)));
+	bench::report(name, "count", queries, t.seconds(), 0);
+	bench::do_not_optimize(found);
+	bench::do_not_optimize(hits);
+}
+
+template <typename Map>
+static void build_and_lookup(const char *name, const std::vector<int> &keys, std::size_t queries) {
+	Map map;
+	for (std::size_t i = 0; i < keys.size(); ++i)
+		map.insert(typename Map::value_type(keys[i], keys[i]));
+	lookups(name, map, keys, queries);
+}
+
+int main(int argc, char **argv) {
+	std::size_t max_n = bench::arg_size(argc, argv, 1, 1000000);
+	std::size_t queries = bench::arg_size(argc, argv, 2, 1000000);
+
+	for (std::size_t n = 1000; n <= max_n; n *= 10) {
+		std::vector<int> keys = bench::shuffled_keys(n);
+		for (std::size_t i = 0; i < n; ++i)
+			keys[i] *= 2;
+
+		std::vector<ft::pair<int, int> > input;
+		input.reserve(n);
+		for (std::size_t i = 0; i < n; ++i)
+			input.push_back(ft::make_pair(keys[i], keys[i]));
+		bench::timer t;
+		ft::flat_map<int, int> flat(input.begin(), input.end());
+		bench::report("ft::flat_map", "batch build", n, t.seconds(), 0);
+
+		ft::map<int, int> tree(flat.begin(), flat.end());
+		t.reset();
+		ft::flat_map<int, int> from_tree(tree);
+		bench::report("ft::flat_map", "from ft::map", n, t.seconds(), 0);
+		t.reset();
+		ft::map<int, int> back = from_tree.to_map();
+		bench::report("ft::flat_map", "to ft::map", n, t.seconds(), 0);
+		bench::do_not_optimize(back.size());
+
+		lookups("ft::flat_map", flat, keys, queries);
+		lookups("ft::map", tree, keys, queries);
+		build_and_lookup<ft::btree_map<int, int> >("ft::btree_map", keys, queries);
+		build_and_lookup<std::map<int, int> >("std::map", keys, queries);
+	}
+	return 0;
+}
@@ -0,0 +1,72 @@
+// lookup latency of an ft::frozen_map snapshot against the live ft::map
+// it was frozen from (RBTree::searchBST) and std::map, as p50/p99 of
+// single timed lookups plus the mean over a tight loop. the "clock" row
+// is the cost of the two clock reads around each lookup, which every
+// percentile includes.
+//
+// usage: bench/frozen [max_entries] [queries]
+
+#include "./bench.hpp"
+#include "../map/map.hpp"
+#include "../map/frozen_map.hpp"
+#include <map>
+
+static void percentiles(const char *name, std::vector<double> &ns) {
+	std::sort(ns.begin(), ns.end());
+	std::printf("%-24s %-16s n=%-10zu %10.2f p50 ns %9.2f p99 ns\n",
+		name, "find latency", ns.size(), ns[ns.size() / 2], ns[ns.size() * 99 / 100]);
+}
+
+template <typename Map>
+static void lookups(const char *name, const Map &map, const std::vector<int> &keys, std::size_t queries) {
+	std::size_t n = keys.size();
+	std::size_t found = 0;
+	bench::timer t;
+	for (std::size_t i = 0; i < queries; ++i)
+		found += map.find(keys[(i * 7919) % n]) != map.end();
+	bench::report(name, "find", queries, t.seconds(), 0);
+
+	std::vector<double> ns(queries);
+	for (std::size_t i = 0; i < queries; ++i) {
+		int key = keys[(i * 104729) % n];
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		found += map.find(key) != map.end();
+		ns[i] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+	}
+	percentiles(name, ns);
+	bench::do_not_optimize(found);
+}
+
+int main(int argc, char **argv) {
+	std::size_t max_n = bench::arg_size(argc, argv, 1, 1000000);
+	std::size_t queries = bench::arg_size(argc, argv, 2, 1000000);
+
+	std::vector<double> clock(queries);
+	for (std::size_t i = 0; i < queries; ++i) {
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		clock[i] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+	}
+	percentiles("clock", clock);
+
+	for (std::size_t n = 1000; n <= max_n; n *= 10) {
+		std::vector<int> keys = bench::shuffled_keys(n);
+		ft::map<int, int> live;
+		std::map<int, int> std_map;
+		for (std::size_t i = 0; i < n; ++i) {
+			live.insert(ft::make_pair(keys[i], keys[i]));
+			std_map.insert(std::make_pair(keys[i], keys[i]));
+		}
+
+		bench::timer t;
+		ft::frozen_map<int, int> frozen(live);
+		bench::report("ft::frozen_map", "freeze", n, t.seconds(), 0);
+		t.reset();
+		frozen.rebuild(live);
+		bench::report("ft::frozen_map", "rebuild", n, t.seconds(), 0);
+
+		lookups("ft::frozen_map", frozen, keys, queries);
+		lookups("ft::map", live, keys, queries);
+		lookups("std::map", std_map, keys, queries);
+	}
+	return 0;
+}
@@ -0,0 +1,71 @@
+// ft::map against std::map: random insert, find hits and misses, erase,
+// plus comparator calls per find with a counting comparator.
+//
+// usage: bench/map_vs_std [entries]
+
+#include "./bench.hpp"
+#include "../map/map.hpp"
+#include <map>
+
+static std::size_t comparisons = 0;
+
+struct counting_less {
+	bool operator()(int a, int b) const {
+		++comparisons;
+		return a < b;
+	}
+};
+
+template <typename Map>
+static void run(const char *name, const std::vector<int> &keys) {
+	std::size_t n = keys.size();
+	Map map;
+
+	std::size_t allocs = bench::allocations();
+	bench::timer t;
+	for (std::size_t i = 0; i < n; ++i)
+		map.insert(typename Map::value_type(keys[i] * 2, keys[i]));
+	bench::report(name, "insert", n, t.seconds(), bench::allocations() - allocs);
+
+	// even keys are present, odd keys are not
+	std::size_t found = 0;
+	t.reset();
+	for (std::size_t i = 0; i < n; ++i)
+		found += map.find(keys[i] * 2) != map.end();
+	bench::report(name, "find hit", n, t.seconds(), 0);
+
+	t.reset();
+	for (std::size_t i = 0; i < n; ++i)
+		found += map.find(keys[i] * 2 + 1) != map.end();
+	bench::report(name, "find miss", n, t.seconds(), 0);
+	bench::do_not_optimize(found);
+
+	allocs = bench::allocations();
+	t.reset();
+	for (std::size_t i = 0; i < n; ++i)
+		map.erase(keys[i] * 2);
+	bench::report(name, "erase", n, t.seconds(), bench::allocations() - allocs);
+}
+
+template <typename Map>
+static void count_comparisons(const char *name, const std::vector<int> &keys) {
+	Map map;
+	for (std::size_t i = 0; i < keys.size(); ++i)
+		map.insert(typename Map::value_type(keys[i], keys[i]));
+	comparisons = 0;
+	for (std::size_t i = 0; i < keys.size(); ++i)
+		bench::do_not_optimize(map.find(keys[i]));
+	std::printf("%-24s %-16s n=%-10zu %10.2f cmp/op\n", name, "find", keys.size(),
+		static_cast<double>(comparisons) / keys.size());
+}
+
+int main(int argc, char **argv) {
+	std::size_t n = bench::arg_size(argc, argv, 1, 1000000);
+	std::vector<int> keys = bench::shuffled_keys(n);
+
+	run<ft::map<int, int> >("ft::map<int,int>", keys);
+	run<std::map<int, int> >("std::map<int,int>", keys);
+	count_comparisons<ft::map<int, int, counting_less> >("ft::map<int,int>", keys);
+	count_comparisons<std::map<int, int, counting_less> >("std::map<int,int>", keys);
+	return 0;
+}
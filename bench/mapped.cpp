@@ -0,0 +1,124 @@
+// startup of a service holding n entries: re-inserting them into an
+// ft::map (what a restart from a text dump costs, without the parsing)
+// against mapping the file save_map() wrote, with and without checking
+// its checksum, and load_map() back into an ft::map. cold runs drop the
+// file from the page cache first (posix_fadvise, no root needed). each
+// line gives the startup time, the time of the first lookups after it
+// and the resident memory the map added.
+//
+// usage: bench/mapped [entries] [lookups] [file]
+
+#include "./bench.hpp"
+#include "../map/mapped_map.hpp"
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+typedef ft::map<long, long> map_type;
+typedef ft::mapped_map<long, long> mapped_type;
+
+// resident set size in bytes
+static double rss() {
+	long pages = 0, resident = 0;
+	std::FILE *f = std::fopen("/proc/self/statm", "r");
+	if (f != NULL) {
+		if (std::fscanf(f, "%ld %ld", &pages, &resident) != 2)
+			resident = 0;
+		std::fclose(f);
+	}
+	return static_cast<double>(resident) * sysconf(_SC_PAGESIZE);
+}
+
+static void dropCache(const char *path) {
+	int fd = open(path, O_RDONLY);
+	if (fd >= 0) {
+		posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+		close(fd);
+	}
+}
+
+template <typename Map>
+static void lookups(const char *container, const char *op, const Map &m, std::size_t n, std::size_t count, double startup, double before) {
+	std::uint64_t x = 0x9e3779b97f4a7c15ull;
+	std::size_t found = 0;
+	bench::timer t;
+	for (std::size_t i = 0; i < count; ++i) {
+		x ^= x << 13;
+		x ^= x >> 7;
+		x ^= x << 17;
+		found += m.count(static_cast<long>(x % (2 * n)));
+	}
+	double secs = t.seconds();
+	bench::do_not_optimize(found);
+	std::printf("%-24s %-16s n=%-10zu %10.2f ms startup %10.2f ns/lookup %8.1f MB rss\n",
+		container, op, n, startup * 1e3, secs * 1e9 / count, (rss() - before) / 1048576.0);
+}
+
+int main(int argc, char **argv) {
+	std::size_t n = bench::arg_size(argc, argv, 1, 1000000);
+	std::size_t count = bench::arg_size(argc, argv, 2, 100000);
+	const char *path = argc > 3 ? argv[3] : "/tmp/ft_mapped_bench.bin";
+
+	// the file is written by a child so that the heap of this process
+	// doesn't start out with the pages of a freed map
+	pid_t child = fork();
+	if (child == 0) {
+		std::vector<int> keys = bench::shuffled_keys(n);
+		map_type m;
+		for (std::size_t i = 0; i < n; ++i)
+			m.insert(ft::make_pair(2L * keys[i], static_cast<long>(i)));
+		bench::timer t;
+		ft::save_map(m, path);
+		std::printf("%-24s %-16s n=%-10zu %10.2f ms\n", "ft::save_map", "write", n, t.seconds() * 1e3);
+		std::fflush(stdout);
+		_exit(0);
+	}
+	int status = 0;
+	waitpid(child, &status, 0);
+	if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+		return 1;
+
+	const char *modes[] = { "cold", "warm" };
+	for (int warm = 0; warm < 2; ++warm) {
+		char op[32];
+		{
+			if (!warm)
+				dropCache(path);
+			double before = rss();
+			bench::timer t;
+			mapped_type m(path, false);
+			std::snprintf(op, sizeof(op), "open %s", modes[warm]);
+			lookups("ft::mapped_map", op, m, n, count, t.seconds(), before);
+		}
+		{
+			if (!warm)
+				dropCache(path);
+			double before = rss();
+			bench::timer t;
+			mapped_type m(path, true);
+			std::snprintf(op, sizeof(op), "verify %s", modes[warm]);
+			lookups("ft::mapped_map", op, m, n, count, t.seconds(), before);
+		}
+	}
+	// heap last, what it frees stays in this process
+	{
+		dropCache(path);
+		double before = rss();
+		bench::timer t;
+		map_type m;
+		ft::load_map(path, m);
+		lookups("ft::load_map", "cold", m, n, count, t.seconds(), before);
+	}
+	{
+		std::vector<int> keys = bench::shuffled_keys(n);
+		double before = rss();
+		bench::timer t;
+		map_type m;
+		for (std::size_t i = 0; i < n; ++i)
+			m.insert(ft::make_pair(2L * keys[i], static_cast<long>(i)));
+		lookups("ft::map", "re-insert", m, n, count, t.seconds(), before);
+	}
+	std::remove(path);
+	return 0;
+}
@@ -0,0 +1,62 @@
+// inserting heavyweight values into ft::map: copying insert against the
+// moving, emplacing and in-place paths. the value type counts its copies
+// and moves, and allocates a buffer of its own, so every copy also shows
+// up in allocs/op.
+//
+// usage: bench/move [entries]
+
+#include "./bench.hpp"
+#include "../map/map.hpp"
+
+struct heavy {
+	static std::size_t copies;
+	static std::size_t moves;
+	std::vector<int> payload;
+
+	heavy() {}
+	explicit heavy(int n) : payload(64, n) {}
+	heavy(const heavy &other) : payload(other.payload) { ++copies; }
+	heavy(heavy &&other) : payload(std::move(other.payload)) { ++moves; }
+	heavy &operator=(const heavy &other) { payload = other.payload; ++copies; return *this; }
+	heavy &operator=(heavy &&other) { payload = std::move(other.payload); ++moves; return *this; }
+};
+
+std::size_t heavy::copies = 0;
+std::size_t heavy::moves = 0;
+
+typedef ft::map<int, heavy> map_type;
+
+template <typename Insert>
+static void run(const char *op, const std::vector<int> &keys, Insert insert) {
+	map_type map;
+	heavy::copies = heavy::moves = 0;
+	std::size_t allocs = bench::allocations();
+	bench::timer t;
+	for (std::size_t i = 0; i < keys.size(); ++i)
+		insert(map, keys[i]);
+	double secs = t.seconds();
+	std::size_t n = keys.size();
+	bench::report("ft::map<int, heavy>", op, n, secs, bench::allocations() - allocs);
+	std::printf("%-24s %-16s n=%-10zu %10.2f copies/op %6.2f moves/op\n", "", "", n,
+		static_cast<double>(heavy::copies) / n, static_cast<double>(heavy::moves) / n);
+}
+
+static void copy_insert(map_type &map, int k) { heavy v(k); map.insert(map_type::value_type(k, v)); }
+static void move_insert(map_type &map, int k) { map.insert(ft::make_pair(k, heavy(k))); }
+static void emplace(map_type &map, int k) { map.emplace(k, heavy(k)); }
+static void try_emplace(map_type &map, int k) { map.try_emplace(k, k); }
+static void subscript(map_type &map, int k) { map[k] = heavy(k); }
+static void insert_or_assign(map_type &map, int k) { map.insert_or_assign(k, heavy(k)); }
+
+int main(int argc, char **argv) {
+	std::size_t n = bench::arg_size(argc, argv, 1, 200000);
+	std::vector<int> keys = bench::shuffled_keys(n);
+
+	run("insert(copy)", keys, copy_insert);
+	run("insert(move)", keys, move_insert);
+	run("emplace", keys, emplace);
+	run("try_emplace", keys, try_emplace);
+	run("operator[]", keys, subscript);
+	run("insert_or_assign", keys, insert_or_assign);
+	return 0;
+}
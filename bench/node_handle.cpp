@@ -0,0 +1,51 @@
+// moving every entry of one ft::map into another: erase and re-insert
+// (one node freed and one allocated, the element copied) against
+// extract / insert(node_type&&) and merge, which relink the same nodes.
+//
+// usage: bench/node_handle [entries]
+
+#include "./bench.hpp"
+#include "../map/map.hpp"
+
+typedef ft::map<int, std::string> map_type;
+
+static void fill(map_type &map, const std::vector<int> &keys) {
+	for (std::size_t i = 0; i < keys.size(); ++i)
+		map.insert(map_type::value_type(keys[i], "value that does not fit in place"));
+}
+
+int main(int argc, char **argv) {
+	std::size_t n = bench::arg_size(argc, argv, 1, 10000000);
+	std::vector<int> keys = bench::shuffled_keys(n);
+
+	{
+		map_type from, to;
+		fill(from, keys);
+		std::size_t allocs = bench::allocations();
+		bench::timer t;
+		for (std::size_t i = 0; i < n; ++i) {
+			map_type::iterator it = from.find(keys[i]);
+			to.insert(*it);
+			from.erase(it);
+		}
+		bench::report("ft::map", "erase+insert", n, t.seconds(), bench::allocations() - allocs);
+	}
+	{
+		map_type from, to;
+		fill(from, keys);
+		std::size_t allocs = bench::allocations();
+		bench::timer t;
+		for (std::size_t i = 0; i < n; ++i)
+			to.insert(from.extract(keys[i]));
+		bench::report("ft::map", "extract+insert", n, t.seconds(), bench::allocations() - allocs);
+	}
+	{
+		map_type from, to;
+		fill(from, keys);
+		std::size_t allocs = bench::allocations();
+		bench::timer t;
+		to.merge(from);
+		bench::report("ft::map", "merge", n, t.seconds(), bench::allocations() - allocs);
+	}
+	return 0;
+}
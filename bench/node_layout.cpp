@@ -0,0 +1,73 @@
+// memory per entry and random lookup latency of small-key trees, to see
+// what the node layout costs. bytes are counted by the allocator the
+// container is given, so they include pool slack and chunk headers.
+//
+// usage: bench/node_layout [entries] [queries] [with_std_map]
+// (100M entries need about 4 GB for RBTree<int, int>, pass 0 as the
+// third argument to skip std::map, which needs half as much again)
+
+#include "./bench.hpp"
+#include "../map/RBTree.hpp"
+#include <map>
+
+static std::size_t bytes_in_use = 0;
+
+// std::allocator that keeps track of the bytes it hands out
+template <typename T>
+struct counting_allocator {
+	typedef T value_type;
+
+	counting_allocator() {}
+	template <typename U>
+	counting_allocator(const counting_allocator<U> &) {}
+
+	T *allocate(std::size_t n) {
+		bytes_in_use += n * sizeof(T);
+		return std::allocator<T>().allocate(n);
+	}
+	void deallocate(T *p, std::size_t n) {
+		bytes_in_use -= n * sizeof(T);
+		std::allocator<T>().deallocate(p, n);
+	}
+
+	bool operator==(const counting_allocator &) const { return true; }
+	bool operator!=(const counting_allocator &) const { return false; }
+};
+
+typedef ft::RBTree<int, int, std::less<int>, counting_allocator<ft::pair<const int, int> > > ft_tree;
+typedef std::map<int, int, std::less<int>, counting_allocator<std::pair<const int, int> > > std_tree;
+
+template <typename Tree, typename Value>
+static void run(const char *name, const std::vector<int> &keys, std::size_t queries) {
+	std::size_t n = keys.size();
+	std::size_t before = bytes_in_use;
+	Tree tree;
+
+	bench::timer t;
+	for (std::size_t i = 0; i < n; ++i)
+		tree.insert(Value(keys[i], keys[i]));
+	bench::report(name, "insert", n, t.seconds(), 0);
+	std::printf("%-24s %-16s n=%-10zu %10.2f bytes/entry\n", name, "memory", n,
+		static_cast<double>(bytes_in_use - before) / n);
+
+	// queries in an order unrelated to the insertion order
+	std::size_t found = 0;
+	t.reset();
+	for (std::size_t i = 0; i < queries; ++i)
+		found += tree.find(keys[(i * 7919) % n]) != tree.end();
+	bench::report(name, "find", queries, t.seconds(), 0);
+	bench::do_not_optimize(found);
+}
+
+int main(int argc, char **argv) {
+	std::size_t n = bench::arg_size(argc, argv, 1, 1000000);
+	std::size_t queries = bench::arg_size(argc, argv, 2, 1000000);
+	bool with_std = bench::arg_size(argc, argv, 3, 1) != 0;
+	std::vector<int> keys = bench::shuffled_keys(n);
+
+	std::printf("sizeof(node) = %zu, payload = %zu\n", sizeof(ft_tree::node_type), sizeof(ft::pair<const int, int>));
+	run<ft_tree, ft::pair<const int, int> >("RBTree<int, int>", keys, queries);
+	if (with_std)
+		run<std_tree, std::pair<const int, int> >("std::map<int, int>", keys, queries);
+	return 0;
+}
@@ -0,0 +1,57 @@
+// insert/erase churn on ft::RBTree (pooled nodes) against std::map, which
+// does one operator new/delete per node like the tree used to.
+//
+// usage: bench/node_pool [entries] [churn ops]
+
+#include "./bench.hpp"
+#include "../map/RBTree.hpp"
+#include <map>
+
+template <typename Insert, typename Erase, typename Clear>
+static void run(const char *name, const std::vector<int> &keys, std::size_t churn,
+	Insert insert, Erase erase, Clear clear) {
+	std::size_t n = keys.size();
+	std::mt19937 rng(7);
+
+	std::size_t allocs = bench::allocations();
+	bench::timer t;
+	for (std::size_t i = 0; i < n; ++i)
+		insert(keys[i]);
+	bench::report(name, "insert", n, t.seconds(), bench::allocations() - allocs);
+
+	// erase a present key, put a fresh one back: the size stays constant
+	allocs = bench::allocations();
+	t.reset();
+	for (std::size_t i = 0; i < churn; ++i) {
+		erase(keys[rng() % n]);
+		insert(keys[rng() % n]);
+	}
+	bench::report(name, "erase+insert", churn, t.seconds(), bench::allocations() - allocs);
+
+	allocs = bench::allocations();
+	t.reset();
+	clear();
+	bench::report(name, "clear", n, t.seconds(), bench::allocations() - allocs);
+}
+
+int main(int argc, char **argv) {
+	std::size_t n = bench::arg_size(argc, argv, 1, 1000000);
+	std::size_t churn = bench::arg_size(argc, argv, 2, n);
+	std::vector<int> keys = bench::shuffled_keys(n);
+
+	{
+		ft::RBTree<int, int> tree;
+		run("ft::RBTree<int,int>", keys, churn,
+			[&](int k) { tree.insert(ft::make_pair(k, k)); },
+			[&](int k) { tree.remove(k); },
+			[&]() { tree.clear(); });
+	}
+	{
+		std::map<int, int> map;
+		run("std::map<int,int>", keys, churn,
+			[&](int k) { map.insert(std::make_pair(k, k)); },
+			[&](int k) { map.erase(k); },
+			[&]() { map.clear(); });
+	}
+	return 0;
+}
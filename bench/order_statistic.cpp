@@ -0,0 +1,48 @@
+// rank/select with the order_statistic policy against walking the tree,
+// and what keeping subtree sizes costs on insert and erase.
+//
+// usage: bench/order_statistic [entries] [queries]
+
+#include "./bench.hpp"
+#include "../map/RBTree.hpp"
+
+typedef ft::RBTree<int, int> plain_tree;
+typedef ft::RBTree<int, int, std::less<int>, std::allocator<ft::pair<const int, int> >, ft::order_statistic> sized_tree;
+
+template <typename Tree>
+static void run(const char *name, const std::vector<int> &keys, std::size_t queries) {
+	std::size_t n = keys.size();
+	Tree tree;
+
+	bench::timer t;
+	for (std::size_t i = 0; i < n; ++i)
+		tree.insert(ft::make_pair(keys[i], keys[i]));
+	bench::report(name, "insert", n, t.seconds(), 0);
+
+	std::size_t sum = 0;
+	t.reset();
+	for (std::size_t i = 0; i < queries; ++i)
+		sum += tree.rank(keys[i % n]);
+	bench::report(name, "rank", queries, t.seconds(), 0);
+
+	t.reset();
+	for (std::size_t i = 0; i < queries; ++i)
+		sum += tree.select(static_cast<std::size_t>(keys[i % n]))->second;
+	bench::report(name, "select", queries, t.seconds(), 0);
+	bench::do_not_optimize(sum);
+
+	t.reset();
+	for (std::size_t i = 0; i < n; ++i)
+		tree.remove(keys[i]);
+	bench::report(name, "erase", n, t.seconds(), 0);
+}
+
+int main(int argc, char **argv) {
+	std::size_t n = bench::arg_size(argc, argv, 1, 1000000);
+	std::size_t queries = bench::arg_size(argc, argv, 2, 1000);
+	std::vector<int> keys = bench::shuffled_keys(n);
+
+	run<sized_tree>("RBTree<order_statistic>", keys, queries);
+	run<plain_tree>("RBTree<no_augment>", keys, queries);
+	return 0;
+}
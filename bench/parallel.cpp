@@ -0,0 +1,62 @@
+// bulk build from sorted input, a full scan with parallel_for_each and
+// clear() of one large ft::map with string values, at 1, 2, 4 ... up to
+// max_threads threads, against the serial assign_sorted, iteration and
+// clear.
+//
+// usage: bench/parallel [entries] [max_threads]
+// (100M entries need about 12 GB)
+
+#include "./bench.hpp"
+#include "../map/map.hpp"
+#include <cstdio>
+#include <string>
+
+typedef ft::map<int, std::string> map_type;
+
+// a little work per element, so that the scan isn't only memory bound
+static void touch(map_type::value_type &v) {
+	v.second[0] = static_cast<char>('a' + (v.first * 2654435761u >> 28));
+}
+
+int main(int argc, char **argv) {
+	std::size_t n = bench::arg_size(argc, argv, 1, 4000000);
+	std::size_t max_threads = bench::arg_size(argc, argv, 2, 64);
+	char name[64];
+
+	std::vector<ft::pair<int, std::string> > sorted;
+	sorted.reserve(n);
+	for (std::size_t i = 0; i < n; ++i)
+		sorted.push_back(ft::pair<int, std::string>(static_cast<int>(i), "value that does not fit in place"));
+
+	{
+		map_type map;
+		bench::timer t;
+		map.assign_sorted(sorted.begin(), sorted.end());
+		bench::report("serial", "build", n, t.seconds(), 0);
+		t.reset();
+		for (map_type::iterator it = map.begin(); it != map.end(); ++it)
+			touch(*it);
+		bench::report("serial", "for_each", n, t.seconds(), 0);
+		// clear() alone would go parallel at this size
+		ft::thread_pool one(1);
+		t.reset();
+		map.clear(one);
+		bench::report("serial", "clear", n, t.seconds(), 0);
+	}
+
+	for (std::size_t threads = 1; threads <= max_threads; threads *= 2) {
+		ft::thread_pool workers(threads);
+		std::snprintf(name, sizeof(name), "ft::map t=%zu", threads);
+		map_type map;
+		bench::timer t;
+		map.assign_sorted(sorted.begin(), sorted.end(), workers);
+		bench::report(name, "build", n, t.seconds(), 0);
+		t.reset();
+		ft::parallel_for_each(map, touch, workers);
+		bench::report(name, "for_each", n, t.seconds(), 0);
+		t.reset();
+		map.clear(workers);
+		bench::report(name, "clear", n, t.seconds(), 0);
+	}
+	return 0;
+}
@@ -0,0 +1,68 @@
+// versioned updates: ft::persistent_map taking a snapshot() every k
+// updates against ft::map taking a full copy every k updates, for k from
+// every_max down to 1 (the full copies stop at k = 100). every version is
+// kept until the end; the MB line is the heap they hold on top of the
+// live map (allocs/op says little for ft::map, which takes its nodes from
+// a pool in blocks).
+//
+// usage: bench/persistent [entries] [updates] [every_max]
+
+#include "./bench.hpp"
+#include "../map/persistent_map.hpp"
+#include "../map/map.hpp"
+#include <cstdio>
+#include <vector>
+
+template <typename Map>
+static Map snapshot(const Map &m) { return m; }
+
+static ft::persistent_map<int, int> snapshot(const ft::persistent_map<int, int> &m) { return m.snapshot(); }
+
+template <typename Map>
+static void run(const char *container, std::size_t n, std::size_t updates, std::size_t every) {
+	Map map;
+	std::vector<int> keys = bench::shuffled_keys(n);
+	for (std::size_t i = 0; i < n; ++i)
+		map.insert_or_assign(keys[i], 0);
+
+	std::vector<Map> versions;
+	versions.reserve(every == 0 ? 0 : updates / every + 1);
+	std::uint64_t x = 0x9e3779b97f4a7c15ull;
+	std::size_t allocs = bench::allocations();
+	std::size_t bytes = bench::heap_in_use();
+	bench::timer t;
+	for (std::size_t i = 0; i < updates; ++i) {
+		x ^= x << 13;
+		x ^= x >> 7;
+		x ^= x << 17;
+		map.insert_or_assign(static_cast<int>(x % n), static_cast<int>(i));
+		if (every != 0 && i % every == 0)
+			versions.push_back(snapshot(map));
+	}
+	double secs = t.seconds();
+	allocs = bench::allocations() - allocs;
+	double mb = (static_cast<double>(bench::heap_in_use()) - bytes) / 1048576.0;
+
+	char op[32];
+	if (every == 0)
+		std::snprintf(op, sizeof(op), "update");
+	else
+		std::snprintf(op, sizeof(op), "update k=%zu", every);
+	bench::report(container, op, updates, secs, allocs);
+	std::printf("%-24s %-16s %10.1f MB for %zu versions\n", container, op, mb, versions.size());
+}
+
+int main(int argc, char **argv) {
+	std::size_t n = bench::arg_size(argc, argv, 1, 100000);
+	std::size_t updates = bench::arg_size(argc, argv, 2, 100000);
+	std::size_t every_max = bench::arg_size(argc, argv, 3, 10000);
+
+	run<ft::persistent_map<int, int> >("ft::persistent_map", n, updates, 0);
+	run<ft::map<int, int> >("ft::map", n, updates, 0);
+	for (std::size_t every = every_max; every >= 1; every /= 10) {
+		run<ft::persistent_map<int, int> >("ft::persistent_map", n, updates, every);
+		if (every >= 100)
+			run<ft::map<int, int> >("ft::map full copy", n, updates, every);
+	}
+	return 0;
+}
@@ -0,0 +1,54 @@
+// streaming a whole map out through a range_cursor in batches of 1 to
+// 64K elements into a caller buffer, ns per element. "resume" seeks again
+// before every batch, as a pagination job that lets the map change
+// between pages would, and the std::map rows are the reference.
+//
+// usage: bench/range_scan [entries]
+
+#include "./bench.hpp"
+#include "../map/map.hpp"
+#include "../map/range_cursor.hpp"
+#include <cstdio>
+#include <map>
+#include <utility>
+
+template <typename Map, typename Pair>
+static void run(const char *container, const Map &m, std::size_t batch, bool resume) {
+	std::vector<Pair> buffer(batch);
+	ft::range_cursor<Map> cursor(m);
+	long long sum = 0;
+	bench::timer t;
+	for (;;) {
+		if (resume)
+			cursor.resume();
+		std::size_t got = cursor.next(buffer.data(), batch);
+		for (std::size_t i = 0; i < got; ++i)
+			sum += buffer[i].second;
+		if (got < batch)
+			break;
+	}
+	bench::do_not_optimize(sum);
+
+	char op[32];
+	std::snprintf(op, sizeof(op), "%s b=%zu", resume ? "resume" : "next", batch);
+	bench::report(container, op, m.size(), t.seconds(), 0);
+}
+
+int main(int argc, char **argv) {
+	std::size_t n = bench::arg_size(argc, argv, 1, 1000000);
+
+	std::vector<int> keys = bench::shuffled_keys(n);
+	ft::map<int, int> m;
+	std::map<int, int> s;
+	for (std::size_t i = 0; i < n; ++i) {
+		m.insert(ft::make_pair(keys[i], keys[i]));
+		s.insert(std::make_pair(keys[i], keys[i]));
+	}
+
+	for (std::size_t batch = 1; batch <= 65536; batch *= 16) {
+		run<ft::map<int, int>, ft::pair<int, int> >("ft::map", m, batch, false);
+		run<ft::map<int, int>, ft::pair<int, int> >("ft::map", m, batch, true);
+		run<std::map<int, int>, std::pair<int, int> >("std::map", s, batch, false);
+	}
+	return 0;
+}
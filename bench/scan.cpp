@@ -0,0 +1,40 @@
+// full in-order scans: ns per element for ++ and -- over the tree,
+// std::map as reference.
+//
+// usage: bench/scan [entries]
+
+#include "./bench.hpp"
+#include "../map/RBTree.hpp"
+#include <map>
+
+template <typename Iterator>
+static void scan(const char *name, const char *op, std::size_t n, Iterator first, Iterator last) {
+	long long sum = 0;
+	bench::timer t;
+	for (; first != last; ++first)
+		sum += first->second;
+	bench::do_not_optimize(sum);
+	bench::report(name, op, n, t.seconds(), 0);
+}
+
+int main(int argc, char **argv) {
+	std::size_t n = bench::arg_size(argc, argv, 1, 10000000);
+	std::vector<int> keys = bench::shuffled_keys(n);
+
+	{
+		// random insertion order so nodes are not laid out in key order
+		ft::RBTree<int, int> tree;
+		for (std::size_t i = 0; i < n; ++i)
+			tree.insert(ft::make_pair(keys[i], keys[i]));
+		scan("ft::RBTree<int,int>", "forward", n, tree.begin(), tree.end());
+		scan("ft::RBTree<int,int>", "reverse", n, tree.rbegin(), tree.rend());
+	}
+	{
+		std::map<int, int> map;
+		for (std::size_t i = 0; i < n; ++i)
+			map.insert(std::make_pair(keys[i], keys[i]));
+		scan("std::map<int,int>", "forward", n, map.begin(), map.end());
+		scan("std::map<int,int>", "reverse", n, map.rbegin(), map.rend());
+	}
+	return 0;
+}
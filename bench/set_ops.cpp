@@ -0,0 +1,75 @@
+// union_with, intersect and difference of two ft::maps against inserting
+// or erasing the elements of the smaller map one at a time, at thread
+// counts from 1 up to the hardware's and at several size ratios.
+//
+// usage: bench/set_ops [entries] [max_threads]
+
+#include "./bench.hpp"
+#include "../map/map.hpp"
+#include <cstdio>
+#include <thread>
+
+typedef ft::map<int, int> map_type;
+
+// every stride-th key of [0, 2n), so that the two maps partly overlap
+static void fill(map_type &map, std::size_t n, std::size_t stride, std::size_t offset) {
+	std::vector<ft::pair<int, int> > sorted;
+	sorted.reserve(n);
+	for (std::size_t i = 0; i < n; ++i)
+		sorted.push_back(ft::pair<int, int>(static_cast<int>(offset + i * stride), 0));
+	map.assign_sorted(sorted.begin(), sorted.end());
+}
+
+int main(int argc, char **argv) {
+	std::size_t n = bench::arg_size(argc, argv, 1, 4000000);
+	std::size_t hw = std::thread::hardware_concurrency();
+	std::size_t max_threads = bench::arg_size(argc, argv, 2, hw ? hw : 1);
+	char name[64];
+
+	// the second map is n / ratio entries spread over the same key range
+	const std::size_t ratios[] = { 1, 10, 100 };
+	for (std::size_t r = 0; r < sizeof(ratios) / sizeof(ratios[0]); ++r) {
+		std::size_t m = n / ratios[r];
+		map_type a, b;
+		fill(a, n, 2, 0);
+		fill(b, m, 2 * ratios[r], 1 + (m / 2) * 2 * ratios[r] % 2);
+
+		// the serial baseline
+		std::snprintf(name, sizeof(name), "insert loop 1:%zu", ratios[r]);
+		{
+			map_type x(a), y(b);
+			bench::timer t;
+			for (map_type::const_iterator it = y.begin(); it != y.end(); ++it)
+				x.insert(*it);
+			bench::report(name, "union", m, t.seconds(), 0);
+			bench::do_not_optimize(x.size());
+		}
+
+		for (std::size_t threads = 1; threads <= max_threads; threads *= 2) {
+			ft::thread_pool workers(threads);
+			std::snprintf(name, sizeof(name), "ft::map 1:%zu t=%zu", ratios[r], threads);
+			{
+				map_type x(a), y(b);
+				bench::timer t;
+				x.union_with(y, workers);
+				bench::report(name, "union_with", m, t.seconds(), 0);
+				bench::do_not_optimize(x.size());
+			}
+			{
+				map_type x(a);
+				bench::timer t;
+				x.intersect(b, workers);
+				bench::report(name, "intersect", m, t.seconds(), 0);
+				bench::do_not_optimize(x.size());
+			}
+			{
+				map_type x(a);
+				bench::timer t;
+				x.difference(b, workers);
+				bench::report(name, "difference", m, t.seconds(), 0);
+				bench::do_not_optimize(x.size());
+			}
+		}
+	}
+	return 0;
+}
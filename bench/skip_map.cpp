@@ -0,0 +1,79 @@
+// ft::concurrent_skip_map against an RBTree behind one mutex, with 1, 2,
+// 4 ... up to max_threads threads running a 90/10 mix of lookups and
+// writes (half inserts, half removes) on random keys of a prefilled map.
+//
+// usage: bench/skip_map [entries] [ops_per_thread] [max_threads]
+
+#include "./bench.hpp"
+#include "../map/concurrent_skip_map.hpp"
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+// the baseline: every operation takes the one lock
+class locked_tree {
+	public:
+		bool contains(int k) const {
+			std::lock_guard<std::mutex> guard(_lock);
+			return _tree.contains(k);
+		}
+		bool insert(const ft::pair<const int, int> &x) {
+			std::lock_guard<std::mutex> guard(_lock);
+			return _tree.insert(x).second;
+		}
+		std::size_t remove(int k) {
+			std::lock_guard<std::mutex> guard(_lock);
+			return _tree.remove(k);
+		}
+
+	private:
+		mutable std::mutex _lock;
+		ft::RBTree<int, int> _tree;
+};
+
+template <typename Map>
+static void run(const char *container, std::size_t n, std::size_t ops, std::size_t threads) {
+	Map map;
+	for (std::size_t i = 0; i < n; i += 2)
+		map.insert(ft::pair<const int, int>(static_cast<int>(i), 0));
+
+	std::vector<std::thread> pool;
+	bench::timer t;
+	for (std::size_t id = 0; id < threads; ++id) {
+		pool.push_back(std::thread([&map, n, ops, id] {
+			std::uint64_t x = 0x9e3779b97f4a7c15ull * (id + 1);
+			std::size_t found = 0;
+			for (std::size_t i = 0; i < ops; ++i) {
+				x ^= x << 13;
+				x ^= x >> 7;
+				x ^= x << 17;
+				int k = static_cast<int>(x % n);
+				if ((x >> 40) % 100 < 90)
+					found += map.contains(k);
+				else if ((x >> 32) & 1)
+					map.insert(ft::pair<const int, int>(k, 0));
+				else
+					map.remove(k);
+			}
+			bench::do_not_optimize(found);
+		}));
+	}
+	for (std::size_t i = 0; i < pool.size(); ++i)
+		pool[i].join();
+
+	char op[32];
+	std::snprintf(op, sizeof(op), "90/10 t=%zu", threads);
+	bench::report(container, op, ops * threads, t.seconds(), 0);
+}
+
+int main(int argc, char **argv) {
+	std::size_t n = bench::arg_size(argc, argv, 1, 1000000);
+	std::size_t ops = bench::arg_size(argc, argv, 2, 1000000);
+	std::size_t max_threads = bench::arg_size(argc, argv, 3, 64);
+
+	for (std::size_t threads = 1; threads <= max_threads; threads *= 2) {
+		run<ft::concurrent_skip_map<int, int> >("ft::concurrent_skip_map", n, ops, threads);
+		run<locked_tree>("mutex + ft::RBTree", n, ops, threads);
+	}
+	return 0;
+}
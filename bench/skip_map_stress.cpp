@@ -0,0 +1,261 @@
+// correctness under contention for ft::concurrent_skip_map and the epoch
+// reclamation behind it, meant to run under ThreadSanitizer (make stress)
+// but a plain build checks the same things. exits 1 on any failure.
+//
+// phase 1: every thread runs a random mix of insert, remove, contains,
+// at and short lower_bound scans. writes to keys below the key count take
+// one of a set of striped locks and update a std::map reference behind
+// another lock, so every result can be checked against it. writes to the
+// keys above race freely, several threads on the same key. at the end the
+// map must hold exactly the reference in the low range, agree with its
+// own iteration in the high one, and size() must match.
+//
+// phase 2: half the threads insert and remove keys of their own and call
+// epoch::flush() often, so epochs advance and nodes are freed, while the
+// other half hold iterators and walk them slowly. a walk that sees the
+// number of freed nodes grow proves nodes were reclaimed while an
+// iterator was live, a value whose destructor ran is caught by its magic
+// (and by TSan as a race with the destructor's write).
+//
+// every scan checks that keys strictly increase and values belong to
+// their key.
+//
+// usage: bench/skip_map_stress [threads] [ops_per_thread] [keys]
+
+#include "./bench.hpp"
+#include "../map/concurrent_skip_map.hpp"
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
+static const int aliveMagic = 0x5a5a1234;
+
+// nodes freed so far, whichever way
+static std::atomic<std::size_t> reclaimed(0);
+static std::atomic<std::size_t> failures(0);
+
+static void check(bool ok, const char *what, int key) {
+	if (ok)
+		return;
+	if (failures.fetch_add(1) < 20)
+		std::fprintf(stderr, "FAIL: %s (key %d)\n", what, key);
+}
+
+// the value of a node: its key and a magic the destructor clears. only
+// the one built in the node counts as reclaimed, not copies from at()
+struct in_node {
+	int key;
+};
+struct tracked {
+	int key;
+	int magic;
+	bool owned;
+
+	tracked(in_node t) : key(t.key), magic(aliveMagic), owned(true) {}
+	tracked(const tracked &other) : key(other.key), magic(other.magic), owned(false) {}
+	~tracked() {
+		if (owned)
+			reclaimed.fetch_add(1, std::memory_order_relaxed);
+		magic = 0;
+	}
+};
+
+typedef ft::concurrent_skip_map<int, tracked> map_type;
+
+struct xorshift {
+	std::uint64_t x;
+
+	explicit xorshift(std::uint64_t seed) : x(0x9e3779b97f4a7c15ull * (seed + 1)) {}
+	std::uint64_t operator()() {
+		x ^= x << 13;
+		x ^= x >> 7;
+		x ^= x << 17;
+		return x;
+	}
+};
+
+// up to steps elements from it on: strictly increasing keys from at least
+// from, live values that belong to their key. yields every few steps
+static std::size_t scan(const map_type &map, map_type::const_iterator it, int from, std::size_t steps, bool slow) {
+	std::size_t seen = 0;
+	long previous = static_cast<long>(from) - 1;
+	for (; it != map.end() && seen < steps; ++it, ++seen) {
+		check(it->first > previous, "scan keys not strictly increasing", it->first);
+		check(it->second.magic == aliveMagic, "scan reached a destroyed value", it->first);
+		check(it->second.key == it->first, "scan value of another key", it->first);
+		previous = it->first;
+		if (slow && seen % 8 == 7)
+			std::this_thread::yield();
+	}
+	return seen;
+}
+
+static void mixed(map_type &map, std::mutex *stripes, std::size_t stripeCount, std::mutex &refLock, std::map<int, int> &ref, int keys, std::size_t ops, std::size_t id) {
+	xorshift rng(id);
+	for (std::size_t i = 0; i < ops; ++i) {
+		std::uint64_t r = rng();
+		int k = static_cast<int>(r % (2 * keys));
+		bool checked = k < keys;
+		switch ((r >> 32) % 8) {
+			case 0:
+			case 1: {
+				if (!checked) {
+					map.emplace(k, in_node{ k });
+					break;
+				}
+				std::lock_guard<std::mutex> stripe(stripes[k % stripeCount]);
+				bool inserted = map.emplace(k, in_node{ k });
+				std::lock_guard<std::mutex> guard(refLock);
+				check(inserted == ref.insert(std::make_pair(k, k)).second, "insert disagrees with the reference", k);
+				break;
+			}
+			case 2:
+			case 3: {
+				if (!checked) {
+					map.remove(k);
+					break;
+				}
+				std::lock_guard<std::mutex> stripe(stripes[k % stripeCount]);
+				std::size_t removed = map.remove(k);
+				std::lock_guard<std::mutex> guard(refLock);
+				check(removed == ref.erase(k), "remove disagrees with the reference", k);
+				break;
+			}
+			case 4:
+				map.contains(k);
+				break;
+			case 5:
+				try {
+					tracked v = map.at(k);
+					check(v.key == k && v.magic == aliveMagic, "at returned a wrong value", k);
+				} catch (const std::out_of_range &) {
+				}
+				break;
+			default:
+				scan(map, map.lower_bound(k), k, 32, false);
+		}
+	}
+}
+
+// every element of the map, in order, after all threads stopped
+static std::vector<int> contents(const map_type &map) {
+	std::vector<int> keys;
+	scan(map, map.begin(), -1, static_cast<std::size_t>(-1), false);
+	for (map_type::const_iterator it = map.begin(); it != map.end(); ++it)
+		keys.push_back(it->first);
+	return keys;
+}
+
+static void phase1(std::size_t threads, std::size_t ops, int keys) {
+	map_type map;
+	const std::size_t stripeCount = 64;
+	std::mutex stripes[stripeCount];
+	std::mutex refLock;
+	std::map<int, int> ref;
+
+	std::vector<std::thread> pool;
+	for (std::size_t id = 0; id < threads; ++id)
+		pool.push_back(std::thread(mixed, std::ref(map), stripes, stripeCount, std::ref(refLock), std::ref(ref), keys, ops, id));
+	for (std::size_t i = 0; i < pool.size(); ++i)
+		pool[i].join();
+
+	std::vector<int> in = contents(map);
+	std::set<int> seen(in.begin(), in.end());
+	std::size_t low = 0;
+	for (std::size_t i = 0; i < in.size(); ++i) {
+		if (in[i] < keys) {
+			check(ref.count(in[i]) == 1, "element missing from the reference", in[i]);
+			++low;
+		}
+	}
+	check(low == ref.size(), "reference element missing from the map", -1);
+	for (int k = 0; k < 2 * keys; ++k) {
+		bool present = seen.count(k) == 1;
+		check(map.contains(k) == present, "contains disagrees with iteration", k);
+		if (present) {
+			tracked v = map.at(k);
+			check(v.key == k && v.magic == aliveMagic, "at returned a wrong value", k);
+		}
+	}
+	check(map.size() == in.size(), "size disagrees with iteration", static_cast<int>(map.size()));
+	std::printf("phase 1: %zu threads, %zu ops each, %zu elements left, %zu checked\n", threads, ops, in.size(), ref.size());
+}
+
+static void phase2(std::size_t threads, std::size_t ops, int keys) {
+	map_type map;
+	std::size_t writers = threads / 2 > 0 ? threads / 2 : 1;
+	std::size_t readers = threads - writers > 0 ? threads - writers : 1;
+	std::atomic<std::size_t> writing(writers);
+	std::atomic<std::size_t> liveReclaims(0);
+	std::mutex refLock;
+	std::set<int> ref;
+
+	std::vector<std::thread> pool;
+	for (std::size_t id = 0; id < writers; ++id) {
+		pool.push_back(std::thread([&, id] {
+			// keys of this writer only, so every insert is of an absent key
+			// and every remove frees a node through the epochs
+			xorshift rng(100 + id);
+			std::set<int> mine;
+			for (std::size_t i = 0; i < ops; ++i) {
+				int k = static_cast<int>((rng() % keys) / writers * writers + id);
+				if (mine.count(k)) {
+					check(map.remove(k) == 1, "remove of an owned key failed", k);
+					mine.erase(k);
+				} else {
+					check(map.emplace(k, in_node{ k }), "insert of an owned key failed", k);
+					mine.insert(k);
+				}
+				if (i % 64 == 63)
+					ft::epoch::flush();
+			}
+			ft::epoch::flush();
+			std::lock_guard<std::mutex> guard(refLock);
+			ref.insert(mine.begin(), mine.end());
+			writing.fetch_sub(1);
+		}));
+	}
+	for (std::size_t id = 0; id < readers; ++id) {
+		pool.push_back(std::thread([&, id] {
+			xorshift rng(200 + id);
+			while (writing.load() != 0) {
+				int k = static_cast<int>(rng() % keys);
+				map_type::const_iterator it = map.lower_bound(k);
+				std::size_t before = reclaimed.load();
+				scan(map, it, k, 64, true);
+				if (reclaimed.load() != before)
+					liveReclaims.fetch_add(1);
+			}
+		}));
+	}
+	for (std::size_t i = 0; i < pool.size(); ++i)
+		pool[i].join();
+
+	std::vector<int> in = contents(map);
+	check(in.size() == ref.size() && std::equal(in.begin(), in.end(), ref.begin()), "map disagrees with the writers' keys", -1);
+	check(map.size() == ref.size(), "size disagrees with the writers' keys", static_cast<int>(map.size()));
+	check(liveReclaims.load() > 0, "no node was reclaimed while an iterator was live", -1);
+	std::printf("phase 2: %zu writers, %zu readers, %zu reclaimed, %zu walks saw reclamation\n", writers, readers, reclaimed.load(), liveReclaims.load());
+}
+
+int main(int argc, char **argv) {
+	std::size_t threads = bench::arg_size(argc, argv, 1, 8);
+	std::size_t ops = bench::arg_size(argc, argv, 2, 20000);
+	int keys = static_cast<int>(bench::arg_size(argc, argv, 3, 1024));
+	if (threads == 0 || ops == 0 || keys <= 0) {
+		std::fprintf(stderr, "usage: %s [threads] [ops_per_thread] [keys]\n", argv[0]);
+		return 1;
+	}
+
+	phase1(threads, ops, keys);
+	phase2(threads, ops, keys);
+	if (failures.load() != 0) {
+		std::fprintf(stderr, "%zu failures\n", failures.load());
+		return 1;
+	}
+	std::printf("ok\n");
+	return 0;
+}
@@ -0,0 +1,56 @@
+// ingesting keys that arrive in ascending order: plain insert against
+// insert(end(), value) and insert(last inserted, value), std::map as reference.
+//
+// usage: bench/sorted_ingest [entries]
+
+#include "./bench.hpp"
+#include "../map/RBTree.hpp"
+#include <map>
+
+int main(int argc, char **argv) {
+	std::size_t n = bench::arg_size(argc, argv, 1, 1000000);
+	bench::timer t;
+
+	{
+		ft::RBTree<int, int> tree;
+		std::size_t allocs = bench::allocations();
+		t.reset();
+		for (std::size_t i = 0; i < n; ++i)
+			tree.insert(ft::make_pair(static_cast<int>(i), 0));
+		bench::report("ft::RBTree<int,int>", "insert", n, t.seconds(), bench::allocations() - allocs);
+	}
+	{
+		ft::RBTree<int, int> tree;
+		std::size_t allocs = bench::allocations();
+		t.reset();
+		for (std::size_t i = 0; i < n; ++i)
+			tree.insert(tree.end(), ft::make_pair(static_cast<int>(i), 0));
+		bench::report("ft::RBTree<int,int>", "insert(end)", n, t.seconds(), bench::allocations() - allocs);
+	}
+	{
+		ft::RBTree<int, int> tree;
+		ft::RBTree<int, int>::iterator hint = tree.end();
+		std::size_t allocs = bench::allocations();
+		t.reset();
+		for (std::size_t i = 0; i < n; ++i)
+			hint = tree.insert(hint, ft::make_pair(static_cast<int>(i), 0));
+		bench::report("ft::RBTree<int,int>", "insert(last)", n, t.seconds(), bench::allocations() - allocs);
+	}
+	{
+		std::map<int, int> map;
+		std::size_t allocs = bench::allocations();
+		t.reset();
+		for (std::size_t i = 0; i < n; ++i)
+			map.insert(std::make_pair(static_cast<int>(i), 0));
+		bench::report("std::map<int,int>", "insert", n, t.seconds(), bench::allocations() - allocs);
+	}
+	{
+		std::map<int, int> map;
+		std::size_t allocs = bench::allocations();
+		t.reset();
+		for (std::size_t i = 0; i < n; ++i)
+			map.insert(map.end(), std::make_pair(static_cast<int>(i), 0));
+		bench::report("std::map<int,int>", "insert(end)", n, t.seconds(), bench::allocations() - allocs);
+	}
+	return 0;
+}
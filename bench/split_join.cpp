@@ -0,0 +1,69 @@
+// splitting a large ft::map at a key and joining the halves back, against
+// moving the greater half of a std::map into a new one by hand, and
+// erasing a short range out of the middle of both.
+//
+// usage: bench/split_join [entries] [rounds]
+// (100M entries need about 6 GB for the two containers together)
+
+#include "./bench.hpp"
+#include "../map/map.hpp"
+#include <map>
+
+int main(int argc, char **argv) {
+	std::size_t n = bench::arg_size(argc, argv, 1, 10000000);
+	std::size_t rounds = bench::arg_size(argc, argv, 2, 1000);
+	std::vector<int> keys = bench::shuffled_keys(n);
+
+	std::vector<ft::pair<int, int> > sorted(n);
+	for (std::size_t i = 0; i < n; ++i)
+		sorted[i] = ft::pair<int, int>(static_cast<int>(i), static_cast<int>(i));
+	ft::map<int, int> map;
+	map.assign_sorted(sorted.begin(), sorted.end());
+
+	// split at a random key and join the two trees back
+	std::size_t allocs = bench::allocations();
+	bench::timer t;
+	for (std::size_t i = 0; i < rounds; ++i) {
+		ft::map<int, int> greater = map.split(keys[i % n]);
+		map.join(greater);
+	}
+	bench::report("ft::map", "split+join", rounds, t.seconds(), bench::allocations() - allocs);
+	bench::do_not_optimize(map.size());
+
+	// the same with std::map costs a copy of the greater half, so only a
+	// few rounds with splits close to the end are timed
+	std::map<int, int> std_map;
+	for (std::size_t i = 0; i < n; ++i)
+		std_map.insert(std_map.end(), std::pair<const int, int>(static_cast<int>(i), static_cast<int>(i)));
+	std::size_t std_rounds = rounds < 10 ? rounds : 10;
+	allocs = bench::allocations();
+	t.reset();
+	for (std::size_t i = 0; i < std_rounds; ++i) {
+		std::map<int, int>::iterator at = std_map.lower_bound(static_cast<int>(n - n / 10));
+		std::map<int, int> greater(at, std_map.end());
+		std_map.erase(at, std_map.end());
+		std_map.insert(greater.begin(), greater.end());
+	}
+	bench::report("std::map", "split+join", std_rounds, t.seconds(), bench::allocations() - allocs);
+
+	// erase 100 consecutive keys from the middle, then put them back
+	const std::size_t width = 100;
+	t.reset();
+	for (std::size_t i = 0; i < rounds; ++i) {
+		int lo = static_cast<int>(keys[i % n] % (n - width));
+		map.erase(map.find(lo), map.find(lo + static_cast<int>(width)));
+		for (std::size_t k = 0; k < width; ++k)
+			map.insert(ft::pair<int, int>(lo + static_cast<int>(k), 0));
+	}
+	bench::report("ft::map", "erase range+refill", rounds * width, t.seconds(), 0);
+	t.reset();
+	for (std::size_t i = 0; i < rounds; ++i) {
+		int lo = static_cast<int>(keys[i % n] % (n - width));
+		std_map.erase(std_map.find(lo), std_map.find(lo + static_cast<int>(width)));
+		for (std::size_t k = 0; k < width; ++k)
+			std_map.insert(std::pair<const int, int>(lo + static_cast<int>(k), 0));
+	}
+	bench::report("std::map", "erase range+refill", rounds * width, t.seconds(), 0);
+	bench::do_not_optimize(std_map.size());
+	return 0;
+}
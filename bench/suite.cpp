@@ -0,0 +1,372 @@
+// the regression suite: every container of the library against std::map
+// on the workloads below, for int keys with int values, string keys (17
+// characters, past the small string buffer) with int values and int keys
+// with 256 byte values, at each size asked for.
+//
+//   insert random/sorted/reverse   n inserts into an empty map
+//   find hit/miss                  lookups of present and absent keys
+//   erase                          every key, in random order
+//   iterate                        a full in-order scan
+//   mixed                          50% find, 25% insert, 25% erase
+//
+// each container runs what its API offers:
+//
+//   ft::map, ft::btree_map, ft::persistent_map   every workload
+//   ft::concurrent_map, concurrent_skip_map      every workload, from one
+//                                                thread: the cost of the
+//                                                locks and atomics alone
+//   ft::flat_map                                 every workload, the
+//                                                single element writes
+//                                                (O(n) each) only up to
+//                                                flat_write_max elements
+//   ft::frozen_map, ft::mapped_map               find and iterate, they
+//                                                are built from an ft::map
+//                                                (mapped_map through a
+//                                                file); mapped_map only
+//                                                for the trivially
+//                                                copyable int rows
+//
+// small sizes are repeated until a measurement covers min_ops operations.
+// every result carries its ratio to std::map on the same row, in text,
+// csv or json, e.g. make bench && bench/suite --format=csv > run.csv
+//
+// usage: bench/suite [--sizes=1000,10000,...] [--types=int,string,large]
+//                    [--format=text|csv|json] [--min-ops=N]
+
+#include "./bench.hpp"
+#include "../map/map.hpp"
+#include "../map/btree_map.hpp"
+#include "../map/flat_map.hpp"
+#include "../map/frozen_map.hpp"
+#include "../map/mapped_map.hpp"
+#include "../map/persistent_map.hpp"
+#include "../map/concurrent_map.hpp"
+#include "../map/concurrent_skip_map.hpp"
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <unistd.h>
+#include <utility>
+
+struct large_value {
+	long data[32];
+};
+
+struct result {
+	std::string container;
+	std::string types;
+	std::string workload;
+	std::size_t n;
+	double ns;
+	double allocs;
+};
+
+static std::vector<result> results;
+static std::size_t min_ops = 200000;
+// largest ft::flat_map the single element writes run on
+static const std::size_t flat_write_max = 10000;
+
+// keys and values from an int, the keys keep its order
+template <typename K> static K make_key(int i);
+template <> int make_key<int>(int i) { return i; }
+template <> std::string make_key<std::string>(int i) {
+	char buf[32];
+	std::snprintf(buf, sizeof(buf), "user:%012d", i);
+	return buf;
+}
+
+template <typename V> static V make_value(int i);
+template <> int make_value<int>(int i) { return i; }
+template <> large_value make_value<large_value>(int i) {
+	large_value v;
+	for (int j = 0; j < 32; ++j)
+		v.data[j] = i + j;
+	return v;
+}
+
+static long weight(int v) { return v; }
+static long weight(const large_value &v) { return v.data[0]; }
+
+// lookups and scans through the API each container has
+template <typename Map, typename K>
+static bool found(const Map &map, const K &k) { return map.find(k) != map.end(); }
+template <typename K, typename V>
+static bool found(const ft::concurrent_map<K, V> &map, const K &k) { return map.contains(k); }
+
+template <typename Map>
+static long scan(const Map &map) {
+	long sum = 0;
+	for (typename Map::const_iterator it = map.begin(); it != map.end(); ++it)
+		sum += weight(it->second);
+	return sum;
+}
+template <typename K, typename V>
+static long scan(const ft::concurrent_map<K, V> &map) {
+	long sum = 0;
+	map.for_each_ordered([&sum](const typename ft::concurrent_map<K, V>::value_type &x) { sum += weight(x.second); });
+	return sum;
+}
+
+static void record(const char *container, const char *types, const char *workload, std::size_t n, std::size_t ops, double secs, std::size_t allocs) {
+	result r = { container, types, workload, n, secs * 1e9 / ops, static_cast<double>(allocs) / ops };
+	results.push_back(r);
+}
+
+// each insert order from an empty map, until min_ops inserts were timed
+template <typename Map, typename K, typename V>
+static void inserts(const char *container, const char *types, const std::vector<int> &order, const char *workload) {
+	std::size_t n = order.size();
+	std::vector<typename Map::value_type> values;
+	values.reserve(n);
+	for (std::size_t i = 0; i < n; ++i)
+		values.push_back(typename Map::value_type(make_key<K>(2 * order[i]), make_value<V>(order[i])));
+
+	std::size_t ops = 0, allocs = 0;
+	double secs = 0;
+	do {
+		Map map;
+		std::size_t before = bench::allocations();
+		bench::timer t;
+		for (std::size_t i = 0; i < n; ++i)
+			map.insert(values[i]);
+		secs += t.seconds();
+		allocs += bench::allocations() - before;
+		ops += n;
+	} while (ops < min_ops);
+	record(container, types, workload, n, ops, secs, allocs);
+}
+
+// find hit/miss and iterate on a map holding the keys of hits
+template <typename Map, typename K>
+static void reads(const char *container, const char *types, const Map &map, const std::vector<K> &hits, const std::vector<K> &misses) {
+	std::size_t n = hits.size();
+	const char *finds[] = { "find hit", "find miss" };
+	for (int miss = 0; miss < 2; ++miss) {
+		const std::vector<K> &keys = miss ? misses : hits;
+		std::size_t ops = 0, found_keys = 0;
+		bench::timer t;
+		do {
+			for (std::size_t i = 0; i < n; ++i)
+				found_keys += found(map, keys[i]);
+			ops += n;
+		} while (ops < min_ops);
+		double secs = t.seconds();
+		bench::do_not_optimize(found_keys);
+		record(container, types, finds[miss], n, ops, secs, 0);
+	}
+
+	std::size_t ops = 0;
+	long sum = 0;
+	bench::timer t;
+	do {
+		sum += scan(map);
+		ops += n;
+	} while (ops < min_ops);
+	double secs = t.seconds();
+	bench::do_not_optimize(sum);
+	record(container, types, "iterate", n, ops, secs, 0);
+}
+
+// the mixed ops keep the size about constant: inserts use odd keys,
+// erases hit present and absent keys alike
+template <typename Map, typename K, typename V>
+static void mixed(const char *container, const char *types, Map &map, const std::vector<K> &hits, const std::vector<K> &misses) {
+	std::size_t n = hits.size();
+	std::size_t ops = 0, allocs = 0, found_keys = 0;
+	std::uint64_t x = 0x9e3779b97f4a7c15ull;
+	std::size_t before = bench::allocations();
+	bench::timer t;
+	do {
+		for (std::size_t i = 0; i < n; ++i) {
+			x ^= x << 13;
+			x ^= x >> 7;
+			x ^= x << 17;
+			std::size_t j = static_cast<std::size_t>(x % n);
+			switch ((x >> 40) & 3) {
+				case 0:
+					map.insert(typename Map::value_type(misses[j], make_value<V>(0)));
+					break;
+				case 1:
+					map.erase((x >> 42) & 1 ? misses[j] : hits[j]);
+					break;
+				default:
+					found_keys += found(map, hits[j]);
+			}
+		}
+		ops += n;
+	} while (ops < min_ops);
+	double secs = t.seconds();
+	allocs = bench::allocations() - before;
+	bench::do_not_optimize(found_keys);
+	record(container, types, "mixed", n, ops, secs, allocs);
+}
+
+template <typename Map, typename K, typename V>
+static void erases(const char *container, const char *types, const std::vector<K> &hits, const std::vector<int> &shuffled) {
+	std::size_t n = hits.size();
+	std::size_t ops = 0, allocs = 0;
+	double secs = 0;
+	do {
+		Map fresh;
+		for (std::size_t i = 0; i < n; ++i)
+			fresh.insert(typename Map::value_type(hits[i], make_value<V>(shuffled[i])));
+		std::size_t before = bench::allocations();
+		bench::timer t;
+		for (std::size_t i = 0; i < n; ++i)
+			fresh.erase(hits[i]);
+		secs += t.seconds();
+		allocs += bench::allocations() - before;
+		ops += n;
+	} while (ops < min_ops);
+	record(container, types, "erase", n, ops, secs, allocs);
+}
+
+// keys of the lookups: even ones are present, odd ones are not
+template <typename K>
+static void lookupKeys(const std::vector<int> &shuffled, std::vector<K> &hits, std::vector<K> &misses) {
+	hits.reserve(shuffled.size());
+	misses.reserve(shuffled.size());
+	for (std::size_t i = 0; i < shuffled.size(); ++i) {
+		hits.push_back(make_key<K>(2 * shuffled[i]));
+		misses.push_back(make_key<K>(2 * shuffled[i] + 1));
+	}
+}
+
+// every workload, writes reaching single element writes only up to
+// max_writes elements
+template <typename Map, typename K, typename V>
+static void run(const char *container, const char *types, std::size_t n, std::size_t max_writes = static_cast<std::size_t>(-1)) {
+	std::vector<int> shuffled = bench::shuffled_keys(n);
+	std::vector<int> sorted(n), reverse(n);
+	for (std::size_t i = 0; i < n; ++i) {
+		sorted[i] = static_cast<int>(i);
+		reverse[i] = static_cast<int>(n - 1 - i);
+	}
+	bool writes = n <= max_writes;
+	if (writes) {
+		inserts<Map, K, V>(container, types, shuffled, "insert random");
+		inserts<Map, K, V>(container, types, sorted, "insert sorted");
+		inserts<Map, K, V>(container, types, reverse, "insert reverse");
+	}
+
+	std::vector<K> hits, misses;
+	lookupKeys(shuffled, hits, misses);
+	Map map;
+	for (std::size_t i = 0; i < n; ++i)
+		map.insert(typename Map::value_type(hits[i], make_value<V>(shuffled[i])));
+	reads(container, types, map, hits, misses);
+	if (writes) {
+		mixed<Map, K, V>(container, types, map, hits, misses);
+		erases<Map, K, V>(container, types, hits, shuffled);
+	}
+}
+
+// find and iterate on the read-only containers, built from an ft::map
+template <typename K, typename V>
+static void runReadOnly(const char *types, std::size_t n) {
+	std::vector<int> shuffled = bench::shuffled_keys(n);
+	std::vector<K> hits, misses;
+	lookupKeys(shuffled, hits, misses);
+	ft::map<K, V> source;
+	for (std::size_t i = 0; i < n; ++i)
+		source.insert(typename ft::map<K, V>::value_type(hits[i], make_value<V>(shuffled[i])));
+
+	{
+		ft::frozen_map<K, V> frozen(source);
+		reads("ft::frozen_map", types, frozen, hits, misses);
+	}
+	if constexpr (std::is_trivially_copyable<K>::value && std::is_trivially_copyable<V>::value) {
+		char path[64];
+		std::snprintf(path, sizeof(path), "/tmp/ft_suite_%ld.bin", static_cast<long>(getpid()));
+		ft::save_map(source, path);
+		{
+			ft::mapped_map<K, V> mapped(path);
+			reads("ft::mapped_map", types, mapped, hits, misses);
+		}
+		std::remove(path);
+	}
+}
+
+template <typename K, typename V>
+static void run_all(const char *types, std::size_t n) {
+	run<ft::map<K, V>, K, V>("ft::map", types, n);
+	run<ft::btree_map<K, V>, K, V>("ft::btree_map", types, n);
+	run<ft::flat_map<K, V>, K, V>("ft::flat_map", types, n, flat_write_max);
+	run<ft::persistent_map<K, V>, K, V>("ft::persistent_map", types, n);
+	run<ft::concurrent_map<K, V>, K, V>("ft::concurrent_map", types, n);
+	run<ft::concurrent_skip_map<K, V>, K, V>("ft::concurrent_skip_map", types, n);
+	runReadOnly<K, V>(types, n);
+	run<std::map<K, V>, K, V>("std::map", types, n);
+}
+
+// time of the std::map row matching r, 0 if there is none
+static double baseline(const result &r) {
+	for (std::size_t i = 0; i < results.size(); ++i) {
+		const result &b = results[i];
+		if (b.container == "std::map" && b.types == r.types && b.workload == r.workload && b.n == r.n)
+			return b.ns;
+	}
+	return 0;
+}
+
+static void print(const std::string &format) {
+	if (format == "csv")
+		std::printf("container,types,workload,n,ns_per_op,allocs_per_op,vs_std_map\n");
+	else if (format == "json")
+		std::printf("[\n");
+	for (std::size_t i = 0; i < results.size(); ++i) {
+		const result &r = results[i];
+		double base = baseline(r);
+		double ratio = base > 0 ? r.ns / base : 0;
+		if (format == "csv")
+			std::printf("%s,%s,%s,%zu,%.3f,%.4f,%.4f\n", r.container.c_str(), r.types.c_str(), r.workload.c_str(), r.n, r.ns, r.allocs, ratio);
+		else if (format == "json")
+			std::printf("  {\"container\": \"%s\", \"types\": \"%s\", \"workload\": \"%s\", \"n\": %zu, \"ns_per_op\": %.3f, \"allocs_per_op\": %.4f, \"vs_std_map\": %.4f}%s\n",
+				r.container.c_str(), r.types.c_str(), r.workload.c_str(), r.n, r.ns, r.allocs, ratio, i + 1 < results.size() ? "," : "");
+		else
+			std::printf("%-24s %-12s %-16s n=%-10zu %10.2f ns/op %8.3f allocs/op %6.2fx std::map\n",
+				r.container.c_str(), r.types.c_str(), r.workload.c_str(), r.n, r.ns, r.allocs, ratio);
+	}
+	if (format == "json")
+		std::printf("]\n");
+}
+
+// the value of --name=value, def otherwise
+static std::string option(int argc, char **argv, const char *name, const char *def) {
+	std::size_t len = std::strlen(name);
+	for (int i = 1; i < argc; ++i)
+		if (std::strncmp(argv[i], name, len) == 0 && argv[i][len] == '=')
+			return argv[i] + len + 1;
+	return def;
+}
+
+int main(int argc, char **argv) {
+	std::string sizes = option(argc, argv, "--sizes", "1000,10000,100000,1000000");
+	std::string types = "," + option(argc, argv, "--types", "int,string,large") + ",";
+	std::string format = option(argc, argv, "--format", "text");
+	min_ops = std::strtoull(option(argc, argv, "--min-ops", "200000").c_str(), NULL, 10);
+	if (format != "text" && format != "csv" && format != "json") {
+		std::fprintf(stderr, "unknown format %s\n", format.c_str());
+		return 1;
+	}
+
+	for (const char *p = sizes.c_str(); *p != '\0'; ) {
+		char *end;
+		std::size_t n = std::strtoull(p, &end, 10);
+		if (n == 0 || end == p) {
+			std::fprintf(stderr, "bad size list %s\n", sizes.c_str());
+			return 1;
+		}
+		if (types.find(",int,") != std::string::npos)
+			run_all<int, int>("int/int", n);
+		if (types.find(",string,") != std::string::npos)
+			run_all<std::string, int>("string/int", n);
+		if (types.find(",large,") != std::string::npos)
+			run_all<int, large_value>("int/large", n);
+		p = *end == ',' ? end + 1 : end;
+	}
+	print(format);
+	return 0;
+}
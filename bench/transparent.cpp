@@ -0,0 +1,65 @@
+// string keyed lookups from string_views: ft::map<std::string, int> has to
+// build a std::string per lookup, with std::less<> the views are compared
+// directly. the keys are longer than any small string buffer, so every
+// temporary is a heap allocation, counted by bench.hpp's operator new.
+//
+// usage: bench/transparent [entries] [queries]
+
+#include "./bench.hpp"
+#include "../map/map.hpp"
+#include <string_view>
+
+template <typename Map>
+static void run(const char *name, const std::vector<std::string> &keys, std::size_t queries) {
+	Map map;
+	for (std::size_t i = 0; i < keys.size(); ++i)
+		map[keys[i]] = static_cast<int>(i);
+	std::vector<std::string_view> views(keys.begin(), keys.end());
+	std::size_t n = views.size();
+	const Map &m = map;
+
+	std::size_t found = 0;
+	std::size_t allocs = bench::allocations();
+	bench::timer t;
+	for (std::size_t i = 0; i < queries; ++i)
+		found += m.find(views[(i * 7919) % n]) != m.end();
+	bench::report(name, "find(sv)", queries, t.seconds(), bench::allocations() - allocs);
+
+	allocs = bench::allocations();
+	t.reset();
+	for (std::size_t i = 0; i < queries; ++i)
+		found += m.count(views[(i * 7919) % n]);
+	bench::report(name, "count(sv)", queries, t.seconds(), bench::allocations() - allocs);
+
+	allocs = bench::allocations();
+	t.reset();
+	for (std::size_t i = 0; i < queries; ++i)
+		found += m.lower_bound(views[(i * 7919) % n]) != m.end();
+	bench::report(name, "lower_bound(sv)", queries, t.seconds(), bench::allocations() - allocs);
+	bench::do_not_optimize(found);
+}
+
+// the plain map only takes key_type, the view is converted by the caller
+template <typename Map>
+struct explicit_key : Map {
+	template <typename K>
+	typename Map::const_iterator find(const K &k) const { return Map::find(typename Map::key_type(k)); }
+	template <typename K>
+	typename Map::size_type count(const K &k) const { return Map::count(typename Map::key_type(k)); }
+	template <typename K>
+	typename Map::const_iterator lower_bound(const K &k) const { return Map::lower_bound(typename Map::key_type(k)); }
+};
+
+int main(int argc, char **argv) {
+	std::size_t n = bench::arg_size(argc, argv, 1, 100000);
+	std::size_t queries = bench::arg_size(argc, argv, 2, 1000000);
+
+	std::vector<int> ids = bench::shuffled_keys(n);
+	std::vector<std::string> keys;
+	for (std::size_t i = 0; i < n; ++i)
+		keys.push_back("session/user-profile/" + std::to_string(ids[i]));
+
+	run<explicit_key<ft::map<std::string, int> > >("ft::map<less<string>>", keys, queries);
+	run<ft::map<std::string, int, std::less<> > >("ft::map<less<>>", keys, queries);
+	return 0;
+}
@@ -0,0 +1,73 @@
+// what the tree does per operation, from an RBTree instrumented with
+// tree_stats: comparisons, rotations, fixDoubleBlack steps and node
+// allocations per insert, find and erase of random keys, next to the time
+// of the same operations with and without the instrumentation (no_stats
+// must match a plain ft::map). ends with the shape of the full tree and the
+// counters in the form an exporter would serve them.
+//
+// usage: bench/tree_stats [entries]
+
+#include "./bench.hpp"
+#include "../map/RBTree.hpp"
+#include "../map/tree_stats.hpp"
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <memory>
+
+typedef std::allocator<ft::pair<const int, int> > allocator_type;
+typedef ft::RBTree<int, int, std::less<int>, allocator_type> plain_tree;
+typedef ft::RBTree<int, int, std::less<int>, allocator_type, ft::no_augment, ft::tree_stats> counted_tree;
+
+static void perOp(const char *op, const ft::tree_counters &d, std::size_t n) {
+	double ops = static_cast<double>(n);
+	std::printf("%-24s %-16s n=%-10zu %8.2f cmp/op %8.3f rot/op %8.3f fix/op %8.3f allocs/op (deepest fix %llu)\n",
+		"tree_stats", op, n, d.comparisons / ops, d.rotations / ops, d.double_black_steps / ops,
+		d.allocations / ops, static_cast<unsigned long long>(d.double_black_max_depth));
+}
+
+template <typename Tree>
+static void run(const char *container, const std::vector<int> &keys, bool counts) {
+	std::size_t n = keys.size();
+	Tree t((std::less<int>()));
+
+	ft::tree_counters before = ft::tree_stats::collect();
+	bench::timer insert;
+	for (std::size_t i = 0; i < n; ++i)
+		t.insert(ft::make_pair(keys[i], keys[i]));
+	bench::report(container, "insert", n, insert.seconds(), 0);
+	if (counts)
+		perOp("insert", ft::tree_stats::collect() - before, n);
+
+	before = ft::tree_stats::collect();
+	std::size_t found = 0;
+	bench::timer find;
+	for (std::size_t i = 0; i < n; ++i)
+		found += t.find(keys[n - 1 - i]) != t.end();
+	bench::report(container, "find", n, find.seconds(), 0);
+	bench::do_not_optimize(found);
+	if (counts)
+		perOp("find", ft::tree_stats::collect() - before, n);
+
+	if (counts)
+		std::printf("%-24s %-16s n=%-10zu height %zu, black height %zu, %s\n", "tree_stats", "shape", n,
+			t.height(), t.black_height(), t.validate() ? "valid" : "INVALID");
+
+	before = ft::tree_stats::collect();
+	bench::timer erase;
+	for (std::size_t i = 0; i < n; ++i)
+		t.remove(keys[i]);
+	bench::report(container, "erase", n, erase.seconds(), 0);
+	if (counts)
+		perOp("erase", ft::tree_stats::collect() - before, n);
+}
+
+int main(int argc, char **argv) {
+	std::size_t n = bench::arg_size(argc, argv, 1, 1000000);
+	std::vector<int> keys = bench::shuffled_keys(n);
+
+	run<plain_tree>("RBTree no_stats", keys, false);
+	run<counted_tree>("RBTree tree_stats", keys, true);
+	ft::tree_stats::dump(std::cout);
+	return 0;
+}
@@ -0,0 +1,1033 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <iterator>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include "./pair.hpp"
+#include "./node_pool.hpp"
+#include "./RBTree.hpp"
+
+namespace ft {
+	// key of a map entry
+	template <typename Key>
+	struct select_first {
+		template <typename Pair>
+		const Key& operator()(const Pair &p) const { return p.first; }
+	};
+
+	// key of a set entry, the entry itself
+	template <typename Key>
+	struct identity_key {
+		const Key& operator()(const Key &k) const { return k; }
+	};
+
+	// how BTree moves an element from one slot to another, the source is
+	// destroyed right after. a map entry hands over its const key as well,
+	// the way a node handle does, so that strings and the like are moved
+	// rather than copied
+	template <typename T>
+	struct slot_traits {
+		static const bool nothrow_move = std::is_nothrow_move_constructible<T>::value;
+
+		static void move(T *dst, T &src) { ::new (static_cast<void *>(dst)) T(std::move(src)); }
+	};
+
+	template <typename K, typename V>
+	struct slot_traits<ft::pair<const K, V> > {
+		static const bool nothrow_move = std::is_nothrow_move_constructible<K>::value && std::is_nothrow_move_constructible<V>::value;
+
+		static void move(ft::pair<const K, V> *dst, ft::pair<const K, V> &src) {
+			::new (static_cast<void *>(dst)) ft::pair<const K, V>(std::move(const_cast<K &>(src.first)), std::move(src.second));
+		}
+	};
+
+	// B+ tree of unique keys. elements live in leaves of about NodeSize
+	// bytes, stored contiguously and linked left to right for iteration,
+	// inner nodes hold contiguous separator keys and child pointers. a
+	// lookup touches one node per level and there are few levels: with
+	// 256 byte nodes a leaf holds 27 int->int entries and an inner node
+	// 18 int separators.
+	//
+	// the separator keys[i] of an inner node is greater than every key
+	// below children[i] and not greater than any key below children[i + 1],
+	// every node but the root is at least half full. keys must be copy
+	// assignable, separators are overwritten when elements move. keys and
+	// elements must be trivially copyable or nothrow move constructible:
+	// a move that could throw half way would leave a node with holes.
+	//
+	// unlike RBTree, inserting or erasing moves elements between nodes, so
+	// both invalidate every iterator except the one erase() returns.
+	template <typename Key, typename Value, typename KeyOfValue, typename Compare = std::less<Key>,
+		typename Allocator = std::allocator<Value>, std::size_t NodeSize = 256>
+	class BTree : private CompareHolder<Compare> {
+		public:
+			class iterator;
+			class const_iterator;
+			typedef Key key_type;
+			typedef Value value_type;
+			typedef Compare key_compare;
+			typedef Allocator allocator_type;
+			typedef std::size_t size_type;
+			typedef std::ptrdiff_t difference_type;
+			typedef std::reverse_iterator<iterator> reverse_iterator;
+			typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+			// elements per leaf and separators per inner node, from what is
+			// left of NodeSize once the links are accounted for. each node has
+			// one more slot so it can overflow by one before it is split
+			static const size_type leaf_slots = (NodeSize >= 4 * sizeof(void *) + 4 * sizeof(Value))
+				? (NodeSize - 4 * sizeof(void *)) / sizeof(Value) - 1 : 3;
+			static const size_type inner_slots = (NodeSize >= 4 * sizeof(void *) + 4 * (sizeof(Key) + sizeof(void *)))
+				? (NodeSize - 4 * sizeof(void *) - sizeof(Key)) / (sizeof(Key) + sizeof(void *)) : 3;
+
+		private:
+			static_assert(std::is_trivially_copyable<Value>::value || slot_traits<Value>::nothrow_move,
+				"BTree elements must be trivially copyable or nothrow move constructible");
+			static_assert(std::is_trivially_copyable<Key>::value || slot_traits<Key>::nothrow_move,
+				"BTree keys must be trivially copyable or nothrow move constructible");
+
+			struct InnerNode;
+
+			struct NodeBase {
+				InnerNode *parent;
+				unsigned int count;		// elements of a leaf, keys of an inner node
+				bool leaf;
+			};
+
+			struct LeafNode : NodeBase {
+				LeafNode *prev, *next;
+				typename std::aligned_storage<sizeof(Value), alignof(Value)>::type slots[leaf_slots + 1];
+
+				Value* values() { return reinterpret_cast<Value *>(slots); }
+				const Value* values() const { return reinterpret_cast<const Value *>(slots); }
+			};
+
+			struct InnerNode : NodeBase {
+				typename std::aligned_storage<sizeof(Key), alignof(Key)>::type keySlots[inner_slots + 1];
+				NodeBase *children[inner_slots + 2];
+
+				Key* keys() { return reinterpret_cast<Key *>(keySlots); }
+				const Key* keys() const { return reinterpret_cast<const Key *>(keySlots); }
+			};
+
+			typedef typename std::allocator_traits<Allocator>::template rebind_alloc<LeafNode> leaf_allocator;
+			typedef typename std::allocator_traits<Allocator>::template rebind_alloc<InnerNode> inner_allocator;
+
+			static const size_type minLeaf = leaf_slots / 2;
+			static const size_type minInner = inner_slots / 2;
+			// every level at least doubles the number of leaves
+			static const size_type maxDepth = sizeof(size_type) * 8;
+
+			NodeBase *root;
+			LeafNode *leftmost;
+			LeafNode *rightmost;
+			size_type elementCount;
+			ft::node_pool<LeafNode, leaf_allocator> leafPool;
+			ft::node_pool<InnerNode, inner_allocator> innerPool;
+
+			static const Key& keyOf(const Value &v) {
+				return KeyOfValue()(v);
+			}
+			bool keyLess(const Key &a, const Key &b) const {
+				return this->compare()(a, b);
+			}
+
+			// move n objects from src to dst one by one, the ranges may overlap
+			// and every dst slot outside src must be raw storage. never throws
+			template <typename T>
+			static void relocate(T *dst, T *src, size_type n);
+
+			LeafNode* createLeaf(InnerNode *parent);
+			InnerNode* createInner(InnerNode *parent);
+			void destroyLeaf(LeafNode *leaf) { leafPool.deallocate(leaf); }
+			void destroyInner(InnerNode *node) { innerPool.deallocate(node); }
+			// destroy the elements and keys of a subtree, the nodes are left to the pools
+			void destroyHelper(NodeBase *x);
+			// structural copy of a subtree, leaves are appended to the leaf list
+			NodeBase* copyHelper(const NodeBase *src, InnerNode *parent, LeafNode *&lastLeaf);
+
+			// first element of a leaf whose key is not less than key
+			size_type leafLowerBound(const LeafNode *leaf, const Key &key) const;
+			// first element of a leaf whose key is greater than key
+			size_type leafUpperBound(const LeafNode *leaf, const Key &key) const;
+			// child of an inner node that key belongs to
+			size_type childFor(const InnerNode *node, const Key &key) const;
+			// leaf key belongs to, NULL when the tree is empty
+			LeafNode* findLeaf(const Key &key) const;
+			// position of child among the children of its parent
+			static size_type childIndex(const InnerNode *parent, const NodeBase *child);
+
+			// put a copy of v at pos of leaf, splitting nodes on the way up as needed
+			iterator insertInLeaf(LeafNode *leaf, size_type pos, const Value &v);
+			// move the upper half of an overfull leaf to right
+			iterator splitLeaf(LeafNode *leaf, size_type pos, LeafNode *right, InnerNode **&spare);
+			// link right after left in the parent of left, splitting it if full
+			void insertSeparator(NodeBase *left, const Key &separator, NodeBase *right, InnerNode **&spare);
+
+			// remove the element at pos of leaf and rebalance
+			iterator eraseAt(LeafNode *leaf, size_type pos);
+			// refill a leaf that went below half full, leaf/pos follow the
+			// element that was after the erased one
+			void rebalanceLeaf(LeafNode *&leaf, size_type &pos);
+			void rebalanceInner(InnerNode *node);
+			void mergeLeaves(LeafNode *left, LeafNode *right, size_type separator);
+			void mergeInner(InnerNode *left, InnerNode *right, size_type separator);
+			// drop keys[i] and children[i + 1] of an inner node
+			void removeFromInner(InnerNode *node, size_type i);
+			// rebalance an inner node that lost a key, shrink the tree at the root
+			void fixInner(InnerNode *node);
+
+		public:
+			// constructor
+			explicit BTree(const key_compare &comp = key_compare(), const allocator_type &alloc = allocator_type())
+				: CompareHolder<Compare>(comp), root(NULL), leftmost(NULL), rightmost(NULL), elementCount(0),
+				  leafPool(leaf_allocator(alloc)), innerPool(inner_allocator(alloc)) {}
+			// copy constructor (deep copy)
+			BTree(const BTree &other);
+			// copy assignment operator
+			BTree &operator=(const BTree &other);
+			// destructor
+			~BTree() { clear(); }
+
+			// insert a copy of v, returns the element holding its key and
+			// whether it was inserted
+			ft::pair<iterator, bool> insert(const Value &v);
+			// insert v right before hint when that keeps the order, amortized
+			// O(1) when appending at end(), a full descent otherwise
+			iterator insert(const_iterator hint, const Value &v);
+			// remove the element pos points at, returns the one after it
+			iterator erase(const_iterator pos);
+			// remove the elements of [first, last), returns the one after them
+			iterator erase(const_iterator first, const_iterator last);
+			// remove the element with a given key, returns how many were removed
+			size_type remove(const Key &key);
+			// exchange the contents of two trees
+			void swap(BTree &other);
+			// remove all elements
+			void clear();
+
+			// element with a given key, end() if none
+			iterator find(const Key &key);
+			const_iterator find(const Key &key) const;
+			// first element whose key is not less than key
+			iterator lower_bound(const Key &key);
+			const_iterator lower_bound(const Key &key) const;
+			// first element whose key is greater than key
+			iterator upper_bound(const Key &key);
+			const_iterator upper_bound(const Key &key) const;
+			// check if the tree holds an element with a given key
+			bool contains(const Key &key) const { return find(key) != end(); }
+
+			size_type size() const { return elementCount; }
+			bool empty() const { return elementCount == 0; }
+			size_type max_size() const {
+				return std::allocator_traits<leaf_allocator>::max_size(leafPool.get_allocator()) * leaf_slots;
+			}
+			key_compare key_comp() const { return this->compare(); }
+			allocator_type get_allocator() const { return allocator_type(leafPool.get_allocator()); }
+
+		class iterator {
+			public:
+				typedef std::ptrdiff_t difference_type;
+				typedef Value value_type;
+				typedef value_type& reference;
+				typedef value_type* pointer;
+				typedef std::bidirectional_iterator_tag iterator_category;
+
+				// default constructor
+				iterator() : leaf(NULL), pos(0) {}
+
+				iterator& operator++() {
+					increment();
+					return *this;
+				}
+
+				iterator operator++(int) {
+					iterator tmp(*this);
+					increment();
+					return tmp;
+				}
+
+				iterator& operator--() {
+					decrement();
+					return *this;
+				}
+
+				iterator operator--(int) {
+					iterator tmp(*this);
+					decrement();
+					return tmp;
+				}
+
+				reference operator*() const {
+					return leaf->values()[pos];
+				}
+
+				pointer operator->() const {
+					return leaf->values() + pos;
+				}
+
+				bool operator==(const iterator &other) const {
+					return leaf == other.leaf && pos == other.pos;
+				}
+
+				bool operator!=(const iterator &other) const {
+					return !(*this == other);
+				}
+
+			private:
+				// end() is one past the last element of the rightmost leaf
+				LeafNode *leaf;
+				size_type pos;
+
+				iterator(LeafNode *leaf, size_type pos) : leaf(leaf), pos(pos) {}
+
+				void increment() {
+					if (++pos == leaf->count && leaf->next != NULL) {
+						leaf = leaf->next;
+						pos = 0;
+					}
+				}
+
+				void decrement() {
+					if (pos == 0) {
+						leaf = leaf->prev;
+						pos = leaf->count;
+					}
+					--pos;
+				}
+
+				friend class BTree;
+				friend class const_iterator;
+		};
+
+		class const_iterator {
+			public:
+				typedef std::ptrdiff_t difference_type;
+				typedef Value value_type;
+				typedef const value_type& reference;
+				typedef const value_type* pointer;
+				typedef std::bidirectional_iterator_tag iterator_category;
+
+				// default constructor
+				const_iterator() : leaf(NULL), pos(0) {}
+				const_iterator(const iterator &other) : leaf(other.leaf), pos(other.pos) {}
+
+				const_iterator& operator++() {
+					increment();
+					return *this;
+				}
+
+				const_iterator operator++(int) {
+					const_iterator tmp(*this);
+					increment();
+					return tmp;
+				}
+
+				const_iterator& operator--() {
+					decrement();
+					return *this;
+				}
+
+				const_iterator operator--(int) {
+					const_iterator tmp(*this);
+					decrement();
+					return tmp;
+				}
+
+				reference operator*() const {
+					return leaf->values()[pos];
+				}
+
+				pointer operator->() const {
+					return leaf->values() + pos;
+				}
+
+				bool operator==(const const_iterator &other) const {
+					return leaf == other.leaf && pos == other.pos;
+				}
+
+				bool operator!=(const const_iterator &other) const {
+					return !(*this == other);
+				}
+
+			private:
+				const LeafNode *leaf;
+				size_type pos;
+
+				const_iterator(const LeafNode *leaf, size_type pos) : leaf(leaf), pos(pos) {}
+
+				void increment() {
+					if (++pos == leaf->count && leaf->next != NULL) {
+						leaf = leaf->next;
+						pos = 0;
+					}
+				}
+
+				void decrement() {
+					if (pos == 0) {
+						leaf = leaf->prev;
+						pos = leaf->count;
+					}
+					--pos;
+				}
+
+				friend class BTree;
+		};
+
+		iterator begin() {
+			return iterator(leftmost, 0);
+		}
+
+		iterator end() {
+			return iterator(rightmost, rightmost != NULL ? rightmost->count : 0);
+		}
+
+		const_iterator begin() const {
+			return const_iterator(leftmost, 0);
+		}
+
+		const_iterator end() const {
+			return const_iterator(rightmost, rightmost != NULL ? rightmost->count : 0);
+		}
+
+		reverse_iterator rbegin() {
+			return reverse_iterator(end());
+		}
+
+		reverse_iterator rend() {
+			return reverse_iterator(begin());
+		}
+
+		const_reverse_iterator rbegin() const {
+			return const_reverse_iterator(end());
+		}
+
+		const_reverse_iterator rend() const {
+			return const_reverse_iterator(begin());
+		}
+	};
+
+	template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator, std::size_t NodeSize>
+	template <typename T>
+	void BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::relocate(T *dst, T *src, size_type n) {
+		if (n == 0 || dst == src)
+			return;
+		if (std::is_trivially_copyable<T>::value) {
+			std::memmove(static_cast<void *>(dst), static_cast<const void *>(src), n * sizeof(T));
+			return;
+		}
+		// walk away from the side the ranges overlap on
+		if (dst < src) {
+			for (size_type i = 0; i < n; ++i) {
+				slot_traits<T>::move(dst + i, src[i]);
+				src[i].~T();
+			}
+		} else {
+			for (size_type i = n; i-- > 0; ) {
+				slot_traits<T>::move(dst + i, src[i]);
+				src[i].~T();
+			}
+		}
+	}
+
+	template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator, std::size_t NodeSize>
+	typename BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::LeafNode*
+	BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::createLeaf(InnerNode *parent) {
+		LeafNode *leaf = ::new (static_cast<void *>(leafPool.allocate())) LeafNode;
+		leaf->parent = parent;
+		leaf->count = 0;
+		leaf->leaf = true;
+		leaf->prev = leaf->next = NULL;
+		return leaf;
+	}
+
+	template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator, std::size_t NodeSize>
+	typename BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::InnerNode*
+	BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::createInner(InnerNode *parent) {
+		InnerNode *node = ::new (static_cast<void *>(innerPool.allocate())) InnerNode;
+		node->parent = parent;
+		node->count = 0;
+		node->leaf = false;
+		return node;
+	}
+
+	template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator, std::size_t NodeSize>
+	void BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::destroyHelper(NodeBase *x) {
+		if (x->leaf) {
+			Value *values = static_cast<LeafNode *>(x)->values();
+			for (size_type i = 0; i < x->count; ++i)
+				values[i].~Value();
+			return;
+		}
+		InnerNode *node = static_cast<InnerNode *>(x);
+		for (size_type i = 0; i < node->count; ++i)
+			node->keys()[i].~Key();
+		for (size_type i = 0; i <= node->count; ++i)
+			destroyHelper(node->children[i]);
+	}
+
+	template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator, std::size_t NodeSize>
+	void BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::clear() {
+		// trivially destructible contents don't need a walk, the chunks
+		// are returned to the allocator in one go
+		if (root != NULL && !(std::is_trivially_destructible<Value>::value && std::is_trivially_destructible<Key>::value))
+			destroyHelper(root);
+		root = NULL;
+		leftmost = rightmost = NULL;
+		elementCount = 0;
+		leafPool.release();
+		innerPool.release();
+	}
+
+	template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator, std::size_t NodeSize>
+	BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::BTree(const BTree &other)
+		: CompareHolder<Compare>(other.compare()), root(NULL), leftmost(NULL), rightmost(NULL), elementCount(0),
+		  leafPool(std::allocator_traits<leaf_allocator>::select_on_container_copy_construction(other.leafPool.get_allocator())),
+		  innerPool(std::allocator_traits<inner_allocator>::select_on_container_copy_construction(other.innerPool.get_allocator())) {
+		if (other.root == NULL)
+			return;
+		LeafNode *lastLeaf = NULL;
+		try {
+			root = copyHelper(other.root, NULL, lastLeaf);
+		} catch (...) {
+			// copyHelper destroyed what it built, only the memory is left
+			leafPool.release();
+			innerPool.release();
+			throw;
+		}
+		rightmost = lastLeaf;
+		elementCount = other.elementCount;
+	}
+
+	template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator, std::size_t NodeSize>
+	BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>&
+	BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::operator=(const BTree &other) {
+		if (this != &other) {
+			BTree tmp(other);
+			swap(tmp);
+		}
+		return *this;
+	}
+
+	template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator, std::size_t NodeSize>
+	typename BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::NodeBase*
+	BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::copyHelper(const NodeBase *src, InnerNode *parent, LeafNode *&lastLeaf) {
+		if (src->leaf) {
+			const Value *from = static_cast<const LeafNode *>(src)->values();
+			LeafNode *leaf = createLeaf(parent);
+			try {
+				for (; leaf->count < src->count; ++leaf->count)
+					::new (static_cast<void *>(leaf->values() + leaf->count)) Value(from[leaf->count]);
+			} catch (...) {
+				destroyHelper(leaf);
+				throw;
+			}
+			leaf->prev = lastLeaf;
+			if (lastLeaf != NULL)
+				lastLeaf->next = leaf;
+			else
+				leftmost = leaf;
+			lastLeaf = leaf;
+			return leaf;
+		}
+		const InnerNode *from = static_cast<const InnerNode *>(src);
+		InnerNode *node = createInner(parent);
+		size_type keys = 0;
+		size_type children = 0;
+		try {
+			for (; keys < from->count; ++keys)
+				::new (static_cast<void *>(node->keys() + keys)) Key(from->keys()[keys]);
+			for (; children <= from->count; ++children)
+				node->children[children] = copyHelper(from->children[children], node, lastLeaf);
+		} catch (...) {
+			for (size_type i = 0; i < keys; ++i)
+				node->keys()[i].~Key();
+			for (size_type i = 0; i < children; ++i)
+				destroyHelper(node->children[i]);
+			throw;
+		}
+		node->count = from->count;
+		return node;
+	}
+
+	template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator, std::size_t NodeSize>
+	void BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::swap(BTree &other) {
+		std::swap(this->compare(), other.compare());
+		std::swap(root, other.root);
+		std::swap(leftmost, other.leftmost);
+		std::swap(rightmost, other.rightmost);
+		std::swap(elementCount, other.elementCount);
+		leafPool.swap(other.leafPool);
+		innerPool.swap(other.innerPool);
+	}
+
+	template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator, std::size_t NodeSize>
+	typename BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::size_type
+	BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::leafLowerBound(const LeafNode *leaf, const Key &key) const {
+		const Value *values = leaf->values();
+		size_type first = 0;
+		size_type n = leaf->count;
+
+		while (n > 0) {
+			size_type half = n / 2;
+			if (keyLess(keyOf(values[first + half]), key)) {
+				first += half + 1;
+				n -= half + 1;
+			} else {
+				n = half;
+			}
+		}
+		return first;
+	}
+
+	template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator, std::size_t NodeSize>
+	typename BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::size_type
+	BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::leafUpperBound(const LeafNode *leaf, const Key &key) const {
+		const Value *values = leaf->values();
+		size_type first = 0;
+		size_type n = leaf->count;
+
+		while (n > 0) {
+			size_type half = n / 2;
+			if (!keyLess(key, keyOf(values[first + half]))) {
+				first += half + 1;
+				n -= half + 1;
+			} else {
+				n = half;
+			}
+		}
+		return first;
+	}
+
+	template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator, std::size_t NodeSize>
+	typename BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::size_type
+	BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::childFor(const InnerNode *node, const Key &key) const {
+		// first separator greater than key: keys equal to a separator
+		// live in the subtree on its right
+		const Key *keys = node->keys();
+		size_type first = 0;
+		size_type n = node->count;
+
+		while (n > 0) {
+			size_type half = n / 2;
+			if (!keyLess(key, keys[first + half])) {
+				first += half + 1;
+				n -= half + 1;
+			} else {
+				n = half;
+			}
+		}
+		return first;
+	}
+
+	template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator, std::size_t NodeSize>
+	typename BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::LeafNode*
+	BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::findLeaf(const Key &key) const {
+		NodeBase *x = root;
+
+		if (x == NULL)
+			return NULL;
+		while (!x->leaf) {
+			const InnerNode *node = static_cast<const InnerNode *>(x);
+			x = node->children[childFor(node, key)];
+		}
+		return static_cast<LeafNode *>(x);
+	}
+
+	template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator, std::size_t NodeSize>
+	typename BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::size_type
+	BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::childIndex(const InnerNode *parent, const NodeBase *child) {
+		size_type i = 0;
+		while (parent->children[i] != child)
+			++i;
+		return i;
+	}
+
+	template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator, std::size_t NodeSize>
+	typename BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::iterator
+	BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::find(const Key &key) {
+		LeafNode *leaf = findLeaf(key);
+
+		if (leaf == NULL)
+			return end();
+		size_type pos = leafLowerBound(leaf, key);
+		if (pos == leaf->count || keyLess(key, keyOf(leaf->values()[pos])))
+			return end();
+		return iterator(leaf, pos);
+	}
+
+	template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator, std::size_t NodeSize>
+	typename BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::const_iterator
+	BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::find(const Key &key) const {
+		return const_cast<BTree *>(this)->find(key);
+	}
+
+	template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator, std::size_t NodeSize>
+	typename BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::iterator
+	BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::lower_bound(const Key &key) {
+		LeafNode *leaf = findLeaf(key);
+
+		if (leaf == NULL)
+			return end();
+		size_type pos = leafLowerBound(leaf, key);
+		// past the last element of a leaf is the first of the next one
+		if (pos == leaf->count && leaf->next != NULL)
+			return iterator(leaf->next, 0);
+		return iterator(leaf, pos);
+	}
+
+	template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator, std::size_t NodeSize>
+	typename BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::const_iterator
+	BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::lower_bound(const Key &key) const {
+		return const_cast<BTree *>(this)->lower_bound(key);
+	}
+
+	template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator, std::size_t NodeSize>
+	typename BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::iterator
+	BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::upper_bound(const Key &key) {
+		LeafNode *leaf = findLeaf(key);
+
+		if (leaf == NULL)
+			return end();
+		size_type pos = leafUpperBound(leaf, key);
+		if (pos == leaf->count && leaf->next != NULL)
+			return iterator(leaf->next, 0);
+		return iterator(leaf, pos);
+	}
+
+	template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator, std::size_t NodeSize>
+	typename BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::const_iterator
+	BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::upper_bound(const Key &key) const {
+		return const_cast<BTree *>(this)->upper_bound(key);
+	}
+
+	template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator, std::size_t NodeSize>
+	ft::pair<typename BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::iterator, bool>
+	BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::insert(const Value &v) {
+		const Key &key = keyOf(v);
+		LeafNode *leaf = findLeaf(key);
+
+		if (leaf == NULL) {
+			leaf = createLeaf(NULL);
+			root = leftmost = rightmost = leaf;
+		}
+		size_type pos = leafLowerBound(leaf, key);
+		if (pos < leaf->count && !keyLess(key, keyOf(leaf->values()[pos])))
+			return ft::pair<iterator, bool>(iterator(leaf, pos), false);
+		return ft::pair<iterator, bool>(insertInLeaf(leaf, pos, v), true);
+	}
+
+	template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator, std::size_t NodeSize>
+	typename BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::iterator
+	BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::insert(const_iterator hint, const Value &v) {
+		const Key &key = keyOf(v);
+		LeafNode *leaf = const_cast<LeafNode *>(hint.leaf);
+		size_type pos = hint.pos;
+
+		// only a slot between two elements of the same leaf, or the end of
+		// the rightmost leaf, is known to agree with the separators above
+		if (leaf != NULL && pos > 0 && keyLess(keyOf(leaf->values()[pos - 1]), key)
+			&& (pos == leaf->count ? leaf == rightmost : keyLess(key, keyOf(leaf->values()[pos]))))
+			return insertInLeaf(leaf, pos, v);
+		return insert(v).first;
+	}
+
+	template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator, std::size_t NodeSize>
+	typename BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::iterator
+	BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::insertInLeaf(LeafNode *leaf, size_type pos, const Value &v) {
+		LeafNode *right = NULL;
+		InnerNode *spares[maxDepth];
+		size_type needed = 0;
+
+		if (leaf->count == leaf_slots) {
+			// a split is coming: count the full ancestors it will split and
+			// get every node up front, so a failed allocation changes nothing
+			InnerNode *x = leaf->parent;
+			while (x != NULL && x->count == inner_slots) {
+				++needed;
+				x = x->parent;
+			}
+			if (x == NULL)
+				++needed;	// the root splits, the tree grows a level
+			size_type got = 0;
+			try {
+				right = createLeaf(NULL);
+				for (; got < needed; ++got)
+					spares[got] = createInner(NULL);
+			} catch (...) {
+				while (got > 0)
+					destroyInner(spares[--got]);
+				if (right != NULL)
+					destroyLeaf(right);
+				throw;
+			}
+		}
+
+		Value *values = leaf->values();
+		relocate(values + pos + 1, values + pos, leaf->count - pos);
+		try {
+			::new (static_cast<void *>(values + pos)) Value(v);
+		} catch (...) {
+			relocate(values + pos, values + pos + 1, leaf->count - pos);
+			for (size_type i = 0; i < needed; ++i)
+				destroyInner(spares[i]);
+			if (right != NULL)
+				destroyLeaf(right);
+			throw;
+		}
+		++leaf->count;
+		++elementCount;
+		if (right == NULL)
+			return iterator(leaf, pos);
+		InnerNode **spare = spares;
+		return splitLeaf(leaf, pos, right, spare);
+	}
+
+	template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator, std::size_t NodeSize>
+	typename BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::iterator
+	BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::splitLeaf(LeafNode *leaf, size_type pos, LeafNode *right, InnerNode **&spare) {
+		size_type mid = (leaf_slots + 1) / 2;
+
+		right->count = leaf->count - mid;
+		relocate(right->values(), leaf->values() + mid, right->count);
+		leaf->count = mid;
+
+		right->prev = leaf;
+		right->next = leaf->next;
+		if (leaf->next != NULL)
+			leaf->next->prev = right;
+		else
+			rightmost = right;
+		leaf->next = right;
+
+		insertSeparator(leaf, keyOf(right->values()[0]), right, spare);
+		if (pos < mid)
+			return iterator(leaf, pos);
+		return iterator(right, pos - mid);
+	}
+
+	template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator, std::size_t NodeSize>
+	void BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::insertSeparator(NodeBase *left, const Key &separator, NodeBase *right, InnerNode **&spare) {
+		InnerNode *parent = left->parent;
+
+		if (parent == NULL) {
+			// left was the root: the tree grows by one level
+			InnerNode *node = *spare++;
+			::new (static_cast<void *>(node->keys())) Key(separator);
+			node->count = 1;
+			node->children[0] = left;
+			node->children[1] = right;
+			left->parent = right->parent = node;
+			root = node;
+			return;
+		}
+
+		size_type i = childIndex(parent, left);
+		Key *keys = parent->keys();
+		relocate(keys + i + 1, keys + i, parent->count - i);
+		::new (static_cast<void *>(keys + i)) Key(separator);
+		std::memmove(parent->children + i + 2, parent->children + i + 1, (parent->count - i) * sizeof(NodeBase *));
+		parent->children[i + 1] = right;
+		right->parent = parent;
+		if (++parent->count <= inner_slots)
+			return;
+
+		// the parent overflowed: the middle key moves up, the keys and
+		// children after it move to a new sibling
+		InnerNode *sibling = *spare++;
+		size_type mid = (inner_slots + 1) / 2;
+		Key up(keys[mid]);
+
+		sibling->count = parent->count - mid - 1;
+		relocate(sibling->keys(), keys + mid + 1, sibling->count);
+		for (size_type j = 0; j <= sibling->count; ++j) {
+			sibling->children[j] = parent->children[mid + 1 + j];
+			sibling->children[j]->parent = sibling;
+		}
+		keys[mid].~Key();
+		parent->count = mid;
+		insertSeparator(parent, up, sibling, spare);
+	}
+
+	template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator, std::size_t NodeSize>
+	typename BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::iterator
+	BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::erase(const_iterator pos) {
+		return eraseAt(const_cast<LeafNode *>(pos.leaf), pos.pos);
+	}
+
+	template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator, std::size_t NodeSize>
+	typename BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::iterator
+	BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::erase(const_iterator first, const_iterator last) {
+		// erasing moves elements, so last can't be compared against:
+		// count the range first and erase that many
+		difference_type n = std::distance(first, last);
+		iterator it(const_cast<LeafNode *>(first.leaf), first.pos);
+
+		while (n-- > 0)
+			it = eraseAt(it.leaf, it.pos);
+		return it;
+	}
+
+	template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator, std::size_t NodeSize>
+	typename BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::size_type
+	BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::remove(const Key &key) {
+		iterator it = find(key);
+
+		if (it == end())
+			return 0;
+		eraseAt(it.leaf, it.pos);
+		return 1;
+	}
+
+	template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator, std::size_t NodeSize>
+	typename BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::iterator
+	BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::eraseAt(LeafNode *leaf, size_type pos) {
+		Value *values = leaf->values();
+
+		values[pos].~Value();
+		relocate(values + pos, values + pos + 1, leaf->count - pos - 1);
+		--leaf->count;
+		--elementCount;
+		if (leaf == root) {
+			if (leaf->count == 0) {
+				destroyLeaf(leaf);
+				root = leftmost = rightmost = NULL;
+				return end();
+			}
+		} else if (leaf->count < minLeaf) {
+			rebalanceLeaf(leaf, pos);
+		}
+		if (pos == leaf->count && leaf->next != NULL)
+			return iterator(leaf->next, 0);
+		return iterator(leaf, pos);
+	}
+
+	template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator, std::size_t NodeSize>
+	void BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::rebalanceLeaf(LeafNode *&leaf, size_type &pos) {
+		InnerNode *parent = leaf->parent;
+		size_type i = childIndex(parent, leaf);
+		LeafNode *left = (i > 0) ? static_cast<LeafNode *>(parent->children[i - 1]) : NULL;
+		LeafNode *right = (i < parent->count) ? static_cast<LeafNode *>(parent->children[i + 1]) : NULL;
+
+		if (left != NULL && left->count > minLeaf) {
+			// borrow the last element of the left sibling
+			relocate(leaf->values() + 1, leaf->values(), leaf->count);
+			relocate(leaf->values(), left->values() + left->count - 1, 1);
+			--left->count;
+			++leaf->count;
+			++pos;
+			parent->keys()[i - 1] = keyOf(leaf->values()[0]);
+		} else if (right != NULL && right->count > minLeaf) {
+			// borrow the first element of the right sibling
+			relocate(leaf->values() + leaf->count, right->values(), 1);
+			relocate(right->values(), right->values() + 1, right->count - 1);
+			--right->count;
+			++leaf->count;
+			parent->keys()[i] = keyOf(right->values()[0]);
+		} else if (left != NULL) {
+			pos += left->count;
+			mergeLeaves(left, leaf, i - 1);
+			leaf = left;
+		} else {
+			mergeLeaves(leaf, right, i);
+		}
+	}
+
+	template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator, std::size_t NodeSize>
+	void BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::mergeLeaves(LeafNode *left, LeafNode *right, size_type separator) {
+		InnerNode *parent = left->parent;
+
+		relocate(left->values() + left->count, right->values(), right->count);
+		left->count += right->count;
+		left->next = right->next;
+		if (right->next != NULL)
+			right->next->prev = left;
+		else
+			rightmost = left;
+		destroyLeaf(right);
+		removeFromInner(parent, separator);
+		fixInner(parent);
+	}
+
+	template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator, std::size_t NodeSize>
+	void BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::removeFromInner(InnerNode *node, size_type i) {
+		node->keys()[i].~Key();
+		relocate(node->keys() + i, node->keys() + i + 1, node->count - i - 1);
+		std::memmove(node->children + i + 1, node->children + i + 2, (node->count - i - 1) * sizeof(NodeBase *));
+		--node->count;
+	}
+
+	template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator, std::size_t NodeSize>
+	void BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::fixInner(InnerNode *node) {
+		if (node->parent == NULL) {
+			// a root left with a single child hands the root over to it
+			if (node->count == 0) {
+				root = node->children[0];
+				root->parent = NULL;
+				destroyInner(node);
+			}
+			return;
+		}
+		if (node->count < minInner)
+			rebalanceInner(node);
+	}
+
+	template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator, std::size_t NodeSize>
+	void BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::rebalanceInner(InnerNode *node) {
+		InnerNode *parent = node->parent;
+		size_type i = childIndex(parent, node);
+		InnerNode *left = (i > 0) ? static_cast<InnerNode *>(parent->children[i - 1]) : NULL;
+		InnerNode *right = (i < parent->count) ? static_cast<InnerNode *>(parent->children[i + 1]) : NULL;
+
+		if (left != NULL && left->count > minInner) {
+			// rotate through the parent: its separator comes down in front,
+			// the last key of the left sibling goes up
+			relocate(node->keys() + 1, node->keys(), node->count);
+			std::memmove(node->children + 1, node->children, (node->count + 1) * sizeof(NodeBase *));
+			::new (static_cast<void *>(node->keys())) Key(parent->keys()[i - 1]);
+			node->children[0] = left->children[left->count];
+			node->children[0]->parent = node;
+			++node->count;
+			parent->keys()[i - 1] = left->keys()[left->count - 1];
+			left->keys()[left->count - 1].~Key();
+			--left->count;
+		} else if (right != NULL && right->count > minInner) {
+			// the mirror image with the right sibling
+			::new (static_cast<void *>(node->keys() + node->count)) Key(parent->keys()[i]);
+			node->children[node->count + 1] = right->children[0];
+			node->children[node->count + 1]->parent = node;
+			++node->count;
+			parent->keys()[i] = right->keys()[0];
+			right->keys()[0].~Key();
+			relocate(right->keys(), right->keys() + 1, right->count - 1);
+			std::memmove(right->children, right->children + 1, right->count * sizeof(NodeBase *));
+			--right->count;
+		} else if (left != NULL) {
+			mergeInner(left, node, i - 1);
+		} else {
+			mergeInner(node, right, i);
+		}
+	}
+
+	template <typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator, std::size_t NodeSize>
+	void BTree<Key, Value, KeyOfValue, Compare, Allocator, NodeSize>::mergeInner(InnerNode *left, InnerNode *right, size_type separator) {
+		InnerNode *parent = left->parent;
+
+		// the separator comes down between the keys of the two nodes
+		::new (static_cast<void *>(left->keys() + left->count)) Key(parent->keys()[separator]);
+		relocate(left->keys() + left->count + 1, right->keys(), right->count);
+		for (size_type j = 0; j <= right->count; ++j) {
+			left->children[left->count + 1 + j] = right->children[j];
+			right->children[j]->parent = left;
+		}
+		left->count += right->count + 1;
+		destroyInner(right);
+		removeFromInner(parent, separator);
+		fixInner(parent);
+	}
+}
@@ -2,70 +2,577 @@
 
 #include <iostream>
 #include <cstdlib>
+#include <cstddef>
+#include <cstdint>
 #include <algorithm>
+#include <iterator>
 #include <cassert>
+#include <stdexcept>
+#include <type_traits>
+#include <functional>
+#include <tuple>
+#include <utility>
+#include <limits>
 #include "./pair.hpp"
+#include "./node_pool.hpp"
+#include "./tree_augment.hpp"
+#include "./tree_stats.hpp"
+#include "./thread_pool.hpp"
 
 namespace ft {
 	enum Color {RED, BLACK};
 
-	template <typename Key, typename Value>
-	struct Node {
+	// links and color of a node. the tree's header is a bare NodeBase: its
+	// parent is the root, its left/right are the smallest/largest nodes and
+	// it is the node end() points at (the root's parent is the header)
+	struct NodeBase {
+		NodeBase *left, *right;
+
+		NodeBase() : left(NULL), right(NULL), parentAndColor(RED) {}
+
+		NodeBase* parent() const {
+			return reinterpret_cast<NodeBase *>(parentAndColor & ~colorMask);
+		}
+		void setParent(NodeBase *p) {
+			parentAndColor = reinterpret_cast<std::uintptr_t>(p) | (parentAndColor & colorMask);
+		}
+		Color color() const {
+			return static_cast<Color>(parentAndColor & colorMask);
+		}
+		void setColor(Color c) {
+			parentAndColor = (parentAndColor & ~colorMask) | static_cast<std::uintptr_t>(c);
+		}
+
+	private:
+		// nodes are pointer aligned, so the low bit of the parent pointer is
+		// always zero and holds the color: no padding word next to the links
+		static const std::uintptr_t colorMask = 1;
+		std::uintptr_t parentAndColor;
+	};
+
+	template <typename Key, typename Value, typename Augment = no_augment>
+	struct Node : NodeBase, Augment::node_data {
 		ft::pair<const Key, Value> data;
-		Color color;
-		Node *left, *right, *parent;
 
-		// constructor for a new node
-		Node(const ft::pair<const Key, Value> &data) : data(data) {
-			color = RED;
-			left = right = parent = NULL;
+		// constructor for a new node, the pair is built from args in place
+		template <typename... Args>
+		explicit Node(Args&&... args) : NodeBase(), data(std::forward<Args>(args)...) {}
+	};
+
+	// find the minimum node of a subtree
+	inline NodeBase* treeMinimum(NodeBase *x) {
+		while (x->left != NULL)
+			x = x->left;
+		return x;
+	}
+
+	// find the maximum node of a subtree
+	inline NodeBase* treeMaximum(NodeBase *x) {
+		while (x->right != NULL)
+			x = x->right;
+		return x;
+	}
+
+	// find the next node in key order, the largest node goes to the header
+	inline NodeBase* treeIncrement(NodeBase *x) {
+		// if the node has a right child, its successor is the minimum of its right subtree
+		if (x->right != NULL)
+			return treeMinimum(x->right);
+
+		// otherwise it is the lowest ancestor whose left child is also an ancestor of x
+		NodeBase *y = x->parent();
+		while (x == y->right) {
+			x = y;
+			y = y->parent();
+		}
+		// we climbed from the largest node to the header through the root
+		// (the root is the header's parent and, when it is the largest
+		// node, also its right), stay on the header
+		if (x->right != y)
+			x = y;
+		return x;
+	}
+
+	// find the previous node in key order, the header goes to the largest node
+	inline NodeBase* treeDecrement(NodeBase *x) {
+		// the header is the only red node whose grandparent is itself
+		if (x->color() == RED && x->parent()->parent() == x)
+			return x->right;
+
+		// if the node has a left child, its predecessor is the maximum of its left subtree
+		if (x->left != NULL)
+			return treeMaximum(x->left);
+
+		// otherwise it is the lowest ancestor whose right child is also an ancestor of x
+		NodeBase *y = x->parent();
+		while (x == y->left) {
+			x = y;
+			y = y->parent();
 		}
+		return y;
+	}
+
+	inline const NodeBase* treeIncrement(const NodeBase *x) {
+		return treeIncrement(const_cast<NodeBase *>(x));
+	}
+
+	inline const NodeBase* treeDecrement(const NodeBase *x) {
+		return treeDecrement(const_cast<NodeBase *>(x));
+	}
+
+	// holds the comparator, stateless comparators are an empty base
+	// class so they add nothing to the size of the tree
+	template <typename Compare, bool Empty = std::is_empty<Compare>::value && !std::is_final<Compare>::value>
+	class CompareHolder : private Compare {
+		protected:
+			CompareHolder(const Compare &comp) : Compare(comp) {}
+
+			const Compare& compare() const { return *this; }
+			Compare& compare() { return *this; }
 	};
 
-	template <typename Key, typename Value>
-	class RBTree {
+	template <typename Compare>
+	class CompareHolder<Compare, false> {
 		private:
-			Node<Key, Value> *root;
+			Compare comp;
+
+		protected:
+			CompareHolder(const Compare &comp) : comp(comp) {}
+
+			const Compare& compare() const { return comp; }
+			Compare& compare() { return comp; }
+	};
+
+	// Result, only for comparators that declare is_transparent. the
+	// heterogeneous lookups then take any K the comparator orders against
+	// Key, without building a Key first
+	template <typename Compare, typename K, typename Result, typename = void>
+	struct transparent_lookup {};
+
+	template <typename Compare, typename K, typename Result>
+	struct transparent_lookup<Compare, K, Result, std::void_t<typename Compare::is_transparent> > {
+		typedef Result type;
+	};
+
+	template <typename Key, typename Value, typename Compare = std::less<Key>,
+		typename Allocator = std::allocator<ft::pair<const Key, Value> >, typename Augment = no_augment, typename Stats = no_stats>
+	class RBTree : private CompareHolder<Compare> {
+		public:
+			class iterator;
+			class const_iterator;
+			class node_handle;
+			struct insert_return_type;
+			typedef Key key_type;
+			typedef Value mapped_type;
+			typedef ft::pair<const Key, Value> value_type;
+			typedef Compare key_compare;
+			typedef Allocator allocator_type;
+			typedef std::size_t size_type;
+			typedef std::ptrdiff_t difference_type;
+			typedef Augment augment_type;
+			typedef Stats stats_type;
+			typedef Node<Key, Value, Augment> node_type;
+			typedef typename std::allocator_traits<Allocator>::template rebind_alloc<Node<Key, Value, Augment> > node_allocator;
+			typedef ft::node_pool<Node<Key, Value, Augment>, node_allocator> pool_type;
+			typedef std::reverse_iterator<iterator> reverse_iterator;
+			typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+		private:
+			// header.parent() is the root, header.left/right the leftmost/rightmost
+			// nodes, they point back at the header when the tree is empty
+			NodeBase header;
+			// unknownCount after a split or join of trees whose sizes can't
+			// be told without a walk, size() counts the nodes then
+			mutable size_type nodeCount;
+			static const size_type unknownCount = static_cast<size_type>(-1);
+			pool_type pool;
+
+			// get a node from the pool and construct its pair from args
+			template <typename... Args>
+			Node<Key, Value, Augment>* createNode(Args&&... args);
+			// destroy a node and give its storage back to the pool
+			void destroyNode(Node<Key, Value, Augment> *node);
+			// make the tree empty (links only)
+			void resetHeader();
+
+			// key of a node that is not the header
+			static const Key& keyOf(const NodeBase *x) {
+				return static_cast<const Node<Key, Value, Augment> *>(x)->data.first;
+			}
+			// the one place keys are compared, one side may be a K of a
+			// heterogeneous lookup
+			template <typename A, typename B>
+			bool keyLess(const A &a, const B &b) const {
+				Stats::comparison();
+				return this->compare()(a, b);
+			}
+
+			// recompute the augmentation of a node from its children
+			static void updateNode(NodeBase *x) {
+				Augment::update(static_cast<Node<Key, Value, Augment> *>(x));
+			}
+			// recompute the augmentation from x up to the root
+			void updatePath(NodeBase *x);
+			// nodes in a subtree (order statistic policies only)
+			static size_type subtreeSize(const NodeBase *x) {
+				return Augment::template size<Node<Key, Value, Augment> >(x);
+			}
+			// number of nodes before x, the header ranks after every node
+			static size_type rankOf(const NodeBase *x);
+			// aggregate of a whole subtree, the identity for NULL
+			static typename Augment::value_type subtreeAggregate(const NodeBase *x) {
+				return Augment::template get<Node<Key, Value, Augment> >(x);
+			}
+			// aggregate of a single node
+			static typename Augment::value_type nodeAggregate(const NodeBase *x) {
+				return Augment::lift(static_cast<const Node<Key, Value, Augment> *>(x));
+			}
+			// in-order walk for visit_pruned, false once visit asked to stop
+			template <typename Enter, typename Visit>
+			bool visitHelper(const NodeBase *x, Enter &enter, Visit &visit) const;
 
 			// left rotation helper function
-			void rotateLeft(Node<Key, Value> *&root, Node<Key, Value> *&pt);
+			void rotateLeft(NodeBase *pt);
 			// right rotation helper function
-			void rotateRight(Node<Key, Value> *&root, Node<Key, Value> *&pt);
-			// fix any violations of the Red-Black Tree properties
-			void fixViolation(Node<Key, Value> *&root, Node<Key, Value> *&pt);
-			// insert a new node to the tree (in a BST fashion)
-			Node<Key, Value>* insertBST(Node<Key, Value> *root, Node<Key, Value> *pt);
+			void rotateRight(NodeBase *pt);
+			// fix any violations of the Red-Black Tree properties, true when
+			// the root had to be blackened, i.e. the black height grew
+			bool fixViolation(NodeBase *pt);
+			// walk down once to where key belongs, returns the node holding key
+			// or NULL with parent/left telling where to link a new node
+			NodeBase* findInsertPos(const Key &key, NodeBase *&parent, bool &left) const;
+			// link a new node built from args as the left/right child of
+			// parent and rebalance
+			template <typename... Args>
+			NodeBase* insertAt(NodeBase *parent, bool left, Args&&... args) {
+				return linkNode(parent, left, createNode(std::forward<Args>(args)...));
+			}
+			// link pt as the left/right child of parent and rebalance
+			NodeBase* linkNode(NodeBase *parent, bool left, NodeBase *pt);
+			// insert with a hint, data is a pair to copy or move from
+			template <typename Pair>
+			iterator insertHint(iterator hint, Pair &&data);
+			// try_emplace for a key to copy or move from
+			template <typename K, typename... Args>
+			ft::pair<iterator, bool> tryEmplace(K &&key, Args&&... args);
+			// insert_or_assign for a key to copy or move from
+			template <typename K, typename M>
+			ft::pair<iterator, bool> insertOrAssign(K &&key, M &&obj);
 			// search for a node with a given key
-			Node<Key, Value>* searchBST(Node<Key, Value> *root, const Key &key) const;
-			// find the minimum key in the tree
-			Node<Key, Value>* minimum(Node<Key, Value> *root);
-			// find the maximum key in the tree
-			Node<Key, Value>* maximum(Node<Key, Value> *root);
-			// find the next largest key (successor)
-			Node<Key, Value>* successor(Node<Key, Value> *root);
-			// find the next smallest key (predecessor)
-			Node<Key, Value>* predecessor(Node<Key, Value> *root);
+			template <typename K>
+			Node<Key, Value, Augment>* searchBST(NodeBase *root, const K &key) const;
+			// searches find_batch runs in lockstep
+			static const size_type batchLanes = 16;
+			// searchBST for a range of keys, batchLanes at a time: every round
+			// moves each unfinished search down one level and prefetches the
+			// node it lands on, so the cache misses of the lanes overlap
+			template <typename Result, typename ForwardIterator, typename OutputIterator>
+			OutputIterator findBatch(ForwardIterator first, ForwardIterator last, OutputIterator out) const;
+			// first node whose key is not less than key, the header if none
+			template <typename K>
+			NodeBase* lowerBound(const K &key) const;
+			// first node whose key is greater than key, the header if none
+			template <typename K>
+			NodeBase* upperBound(const K &key) const;
+			// unlink a node and rebalance, z is left as a fresh unlinked node
+			void unlinkNode(NodeBase *z);
+			// unlink a node, rebalance and destroy it
+			void eraseNode(NodeBase *z) {
+				unlinkNode(z);
+				destroyNode(static_cast<Node<Key, Value, Augment> *>(z));
+			}
+			// structural copy of a subtree, colors included
+			NodeBase* copyHelper(const NodeBase *src, NodeBase *parent);
+			// perfectly balanced subtree from the next n elements of a sorted
+			// range, nodes at redDepth are red and every other node is black
+			template <typename ForwardIterator>
+			NodeBase* buildSorted(ForwardIterator &first, size_type n, size_type depth, size_type redDepth, NodeBase *parent);
+			// assign_sorted for single pass ranges: one hinted insert per element
+			template <typename InputIterator>
+			void assignRange(InputIterator first, InputIterator last, std::input_iterator_tag);
+			// assign_sorted for multi pass ranges: O(n) build when sorted
+			template <typename ForwardIterator>
+			void assignRange(ForwardIterator first, ForwardIterator last, std::forward_iterator_tag);
 			// helper function for in-order traversal
-			void inorderHelper(Node<Key, Value> *root);
+			void inorderHelper(NodeBase *root);
 			// helper function for clearing the tree
-			void clearHelper(Node<Key, Value> *root);
+			void clearHelper(NodeBase *root);
+			// nodes from which clear() destroys the elements on the shared pool
+			static const size_type parallelMin = 65536;
+			// clearHelper with the two subtrees of a node destroyed in
+			// parallel down to forkDepth
+			void clearParallel(NodeBase *root, size_type depth, thread_pool &workers);
+			// parallel_for_each below x: the subtrees are handed out down to
+			// forkDepth and walked in order below. refresh recomputes the
+			// augmentation of each node after fn, for fn that change values
+			template <typename Function>
+			static void forEachHelper(NodeBase *x, Function &fn, size_type depth, thread_pool &workers, bool refresh);
+			// depth of the red level of a tree of n nodes built by halving
+			static size_type redDepthOf(size_type n);
+			// buildSorted into a block of n consecutive pool slots, element i
+			// of the range goes to slot i so that the halves can be built in
+			// parallel without touching the pool
+			template <typename RandomAccessIterator>
+			NodeBase* buildBlock(RandomAccessIterator first, size_type n, size_type depth, size_type redDepth, node_type *block, thread_pool &workers);
+			// assign_sorted on workers, serial for ranges without random access
+			template <typename InputIterator>
+			void assignParallel(InputIterator first, InputIterator last, thread_pool &workers, std::input_iterator_tag);
+			template <typename RandomAccessIterator>
+			void assignParallel(RandomAccessIterator first, RandomAccessIterator last, thread_pool &workers, std::random_access_iterator_tag);
 			// fix the double black violation
-			void fixDoubleBlack(Node<Key, Value> *&root, Node<Key, Value> *&x, Node<Key, Value> *&parent);
-			void transplant(Node<Key, Value> *&root, Node<Key, Value> *u, Node<Key, Value> *v);
+			void fixDoubleBlack(NodeBase *x, NodeBase *parent);
+			// put v where u hangs, also when u is the root
+			void transplant(NodeBase *u, NodeBase *v);
+			// make newChild take the place of oldChild below parent
+			void replaceChild(NodeBase *parent, NodeBase *oldChild, NodeBase *newChild);
+
+			// a valid red-black tree that isn't hung anywhere, with a black
+			// root (or NULL) and the number of black nodes on any path down
+			struct Subtree {
+				NodeBase *root;
+				size_type blackHeight;
+			};
+			// black nodes on the leftmost path of x
+			static size_type blackHeightOf(const NodeBase *x);
+			// nodes on the longest path down from x
+			static size_type heightOf(const NodeBase *x) {
+				return x == NULL ? 0 : 1 + std::max(heightOf(x->left), heightOf(x->right));
+			}
+			// validate() below x, whose keys lie strictly between lo and hi
+			// (NULL for no bound), with its black height and node count
+			bool validateHelper(const NodeBase *x, const NodeBase *lo, const NodeBase *hi, size_type &blackHeight, size_type &count) const;
+			// cut x loose as a Subtree of black height bh, a red x is blackened
+			static Subtree detach(NodeBase *x, size_type bh);
+			// one tree of left, k and right, every key of left less than k's
+			// and every key of right greater. O(difference of black heights).
+			// header is used as scratch, it holds the result afterwards
+			Subtree joinAt(Subtree left, NodeBase *k, Subtree right);
+			// cut t into the keys less than and greater than key, returns the
+			// node holding key or NULL. O(log n)
+			NodeBase* splitAt(Subtree t, const Key &key, Subtree &less, Subtree &greater);
+			// hang t under the header with count nodes
+			void setRoot(Subtree t, size_type count);
+			// destroy every node of a detached subtree, returns how many
+			size_type destroySubtree(NodeBase *x);
+			// join this tree, pivot and greater, greater is left empty
+			void joinTrees(NodeBase *pivot, RBTree &greater);
+			// detached subtrees waiting to be destroyed, chained through
+			// their roots' parent links
+			struct Discarded {
+				NodeBase *head;
+				NodeBase *tail;
+
+				void push(NodeBase *x) {
+					if (x == NULL)
+						return;
+					x->setParent(head);
+					head = x;
+					if (tail == NULL)
+						tail = x;
+				}
+				void append(const Discarded &other) {
+					if (other.head == NULL)
+						return;
+					other.tail->setParent(head);
+					head = other.head;
+					if (tail == NULL)
+						tail = other.tail;
+				}
+			};
+			// a node cut off from the subtrees it still points at
+			static NodeBase* isolate(NodeBase *x) {
+				x->left = x->right = NULL;
+				return x;
+			}
+			// destroy every discarded subtree, returns how many nodes
+			size_type destroyDiscarded(const Discarded &discarded);
+			// one tree of left and right without a pivot, O(log n)
+			Subtree concat(Subtree left, Subtree right);
+			// recursion levels of the set operations that still fork, enough
+			// for a few tasks per thread to even out the load
+			static size_type forkDepth(const thread_pool &workers);
+			// union of a and b, the nodes of b whose keys are in a are
+			// discarded. the two halves below the root of a are done in
+			// parallel down to forkDepth, a forked half works in a scratch
+			// tree of its own since header is used by split and join
+			Subtree unionAt(Subtree a, Subtree b, size_type depth, thread_pool &workers, Discarded &discarded);
+			// the nodes of a whose keys are (keepCommon) or aren't in the
+			// read-only subtree b, the others are discarded
+			Subtree filterAt(Subtree a, const NodeBase *b, bool keepCommon, size_type depth, thread_pool &workers, Discarded &discarded);
+			// number of nodes below x, for size() after a split or join
+			static size_type countNodes(const NodeBase *x) {
+				return x == NULL ? 0 : countNodes(x->left) + countNodes(x->right) + 1;
+			}
 
 		public:
 			// constructor
-			RBTree() : root(NULL) {}
-			// insert a new node with a given key-value pair
-			void insert(const ft::pair<const Key, Value> &data);
-			// access the value of a node with a given key
-			Value& operator[](const Key &key);
-			// remove a node with a given key
-			void remove(const Key &key);
-			// remove all nodes from the tree
+			explicit RBTree(const key_compare &comp = key_compare(), const allocator_type &alloc = allocator_type())
+				: CompareHolder<Compare>(comp), header(), nodeCount(0), pool(node_allocator(alloc)) {
+				resetHeader();
+			}
+			// range constructor, linear time when the range is sorted
+			template <typename InputIterator>
+			RBTree(InputIterator first, InputIterator last, const key_compare &comp = key_compare(), const allocator_type &alloc = allocator_type())
+				: CompareHolder<Compare>(comp), header(), nodeCount(0), pool(node_allocator(alloc)) {
+				resetHeader();
+				assign_sorted(first, last);
+			}
+			// copy constructor (deep copy)
+			RBTree(const RBTree &other);
+			// move constructor, other is left empty
+			RBTree(RBTree &&other)
+				: CompareHolder<Compare>(other.compare()), header(), nodeCount(0), pool(other.pool.get_allocator()) {
+				resetHeader();
+				swap(other);
+			}
+			// copy assignment operator
+			RBTree &operator=(const RBTree &other);
+			// move assignment operator, other is left empty
+			RBTree &operator=(RBTree &&other) {
+				if (this != &other) {
+					clear();
+					swap(other);
+				}
+				return *this;
+			}
+			// destructor
+			~RBTree() { clear(); }
+			// insert a new node with a given key-value pair, returns the node
+			// holding the key and whether it was inserted
+			ft::pair<iterator, bool> insert(const ft::pair<const Key, Value> &data);
+			ft::pair<iterator, bool> insert(ft::pair<const Key, Value> &&data);
+			// insert as close as possible before hint, amortized O(1)
+			// when keys arrive in sorted order next to the hint
+			iterator insert(iterator hint, const ft::pair<const Key, Value> &data) { return insertHint(hint, data); }
+			iterator insert(iterator hint, ft::pair<const Key, Value> &&data) { return insertHint(hint, std::move(data)); }
+			// build the pair in a new node from args, then link it unless
+			// its key is already there (the node is destroyed then)
+			template <typename... Args>
+			ft::pair<iterator, bool> emplace(Args&&... args);
+			// if key is absent, insert it with a value built in place from
+			// args, args are left untouched otherwise
+			template <typename... Args>
+			ft::pair<iterator, bool> try_emplace(const Key &key, Args&&... args) {
+				return tryEmplace(key, std::forward<Args>(args)...);
+			}
+			template <typename... Args>
+			ft::pair<iterator, bool> try_emplace(Key &&key, Args&&... args) {
+				return tryEmplace(std::move(key), std::forward<Args>(args)...);
+			}
+			// assign obj to the value of key, or insert it
+			template <typename M>
+			ft::pair<iterator, bool> insert_or_assign(const Key &key, M &&obj) {
+				return insertOrAssign(key, std::forward<M>(obj));
+			}
+			template <typename M>
+			ft::pair<iterator, bool> insert_or_assign(Key &&key, M &&obj) {
+				return insertOrAssign(std::move(key), std::forward<M>(obj));
+			}
+			// access the value of a node with a given key, a missing key is
+			// inserted with a value initialized in place
+			Value& operator[](const Key &key) {
+				static_assert(!Augment::folds_values, "the policy folds the values, change them with update()");
+				return tryEmplace(key).first->second;
+			}
+			Value& operator[](Key &&key) {
+				static_assert(!Augment::folds_values, "the policy folds the values, change them with update()");
+				return tryEmplace(std::move(key)).first->second;
+			}
+			// call fn(value_type&) on the element of key and refresh the
+			// augmentation above it, false if key is absent. the way to
+			// change a value when Augment::folds_values
+			template <typename Function>
+			bool update(const Key &key, Function fn);
+			// remove a node with a given key, returns how many were removed
+			size_type remove(const Key &key);
+			// remove the node an iterator points at
+			void erase(const_iterator pos);
+			// remove [first, last) by splitting out the range and joining
+			// the rest back, O(log n + k) for k removed nodes
+			void erase(const_iterator first, const_iterator last);
+			// split and join: keep the keys less than key and return a tree
+			// with the others, in O(log n). nodes are moved, not copied, both
+			// trees share the node storage afterwards. the halves' sizes are
+			// only known with a sized augment, otherwise size() counts them
+			RBTree split(const Key &key);
+			// append greater, whose keys must all be greater than this
+			// tree's, in O(log n). greater is left empty
+			void join(RBTree &greater);
+			// the same with pivot inserted between the two
+			void join(const ft::pair<const Key, Value> &pivot, RBTree &greater);
+			// bulk set operations by divide and conquer on split and join,
+			// O(m log(n / m + 1)) work for trees of m <= n nodes, spread over
+			// the threads of workers. the comparator must not throw.
+			// add the nodes of other whose keys aren't here yet, other is
+			// left empty and its duplicates are destroyed
+			void union_with(RBTree &other, thread_pool &workers = thread_pool::shared());
+			// keep only the keys that are also in other
+			void intersect(const RBTree &other, thread_pool &workers = thread_pool::shared());
+			// remove the keys that are in other
+			void difference(const RBTree &other, thread_pool &workers = thread_pool::shared());
+			// node handles: take a node out of the tree without destroying
+			// it, and link it into this or another tree of the same type
+			// without allocating or copying the element. empty handle if
+			// key is absent
+			node_handle extract(const_iterator pos);
+			node_handle extract(const Key &key);
+			// inserted is false, and node keeps the element, when its key is
+			// already there
+			insert_return_type insert(node_handle &&nh);
+			// move every node of other whose key is not in this tree here,
+			// nodes are relinked, not copied. other keeps the duplicates
+			void merge(RBTree &other);
+			// exchange the contents of two trees
+			void swap(RBTree &other);
+			// remove all nodes from the tree. large trees with elements
+			// that need destroying are walked on the shared pool
 			void clear();
+			// the same on workers whatever the size
+			void clear(thread_pool &workers);
+			// replace the contents with a range. strictly increasing input is
+			// detected and built bottom-up in O(n) out of a single pool chunk,
+			// anything else is inserted element by element
+			template <typename InputIterator>
+			void assign_sorted(InputIterator first, InputIterator last);
+			// the same with the subtrees of a sorted random access range
+			// built in parallel on workers
+			template <typename InputIterator>
+			void assign_sorted(InputIterator first, InputIterator last, thread_pool &workers) {
+				clear(workers);
+				assignParallel(first, last, workers, typename std::iterator_traits<InputIterator>::iterator_category());
+			}
+			// call fn on every element from the threads of workers, in no
+			// particular order. fn must be safe to call concurrently. values
+			// a policy folds may be changed, the folds are redone on the way
+			template <typename Function>
+			void parallel_for_each(Function fn, thread_pool &workers = thread_pool::shared()) {
+				forEachHelper(header.parent(), fn, 0, workers, Augment::folds_values);
+			}
+			template <typename Function>
+			void parallel_for_each(Function fn, thread_pool &workers = thread_pool::shared()) const {
+				auto visit = [&fn](ft::pair<const Key, Value> &data) { fn(static_cast<const ft::pair<const Key, Value> &>(data)); };
+				forEachHelper(const_cast<NodeBase *>(header.parent()), visit, 0, workers, false);
+			}
 			// check if the tree contains a node with a given key
 			bool contains(const Key &key) const;
+			// order statistics, O(log n) with the order_statistic policy:
+			// number of keys less than key
+			size_type rank(const Key &key) const;
+			// k-th smallest element (from 0), end() if k >= size()
+			iterator select(size_type k);
+			const_iterator select(size_type k) const;
+			// fold of the augmentation over the keys in [lo, hi), O(log n)
+			// with an aggregate policy (subtree_sum, subtree_min, ...)
+			typename Augment::value_type range_aggregate(const Key &lo, const Key &hi) const;
+			// sum of the values in [lo, hi) with the subtree_sum policy
+			typename Augment::value_type range_sum(const Key &lo, const Key &hi) const {
+				return range_aggregate(lo, hi);
+			}
+			// in-order walk that skips every subtree whose root enter(node)
+			// rejects, and stops as soon as visit(node) returns false.
+			// both take a const node_type&, so they can read the policy data
+			template <typename Enter, typename Visit>
+			void visit_pruned(Enter enter, Visit visit) const;
 			// access the value of a node with a given key
 			Value& at(const Key &key);
 			// access the value of a node with a given
@@ -73,91 +580,208 @@ namespace ft {
 			const Value& at(const Key &key) const;
 			// in-order traversal of the tree
 			void inorder();
+			// allocator the nodes are obtained from
+			allocator_type get_allocator() const { return allocator_type(pool.get_allocator()); }
+			// comparator the keys are ordered by
+			key_compare key_comp() const { return this->compare(); }
+			// number of nodes, O(1) but for the first call after a split
+			// without a sized augment, or a join or range erase of such a
+			// split tree: that one counts the nodes, O(n)
+			size_type size() const {
+				if (nodeCount == unknownCount)
+					nodeCount = countNodes(header.parent());
+				return nodeCount;
+			}
+			bool empty() const { return header.parent() == NULL; }
+			// nodes on the longest path from the root to a leaf, O(n)
+			size_type height() const { return heightOf(header.parent()); }
+			// black nodes on every path from the root to a leaf, O(log n)
+			size_type black_height() const { return blackHeightOf(header.parent()); }
+			// check every invariant, O(n): key order, parent and header
+			// links, a black root, no red node with a red child, one black
+			// height, the node count and the sizes of sized policies
+			bool validate() const;
+			size_type max_size() const {
+				return std::allocator_traits<node_allocator>::max_size(pool.get_allocator());
+			}
+			// node holding key, end() if none
+			iterator find(const Key &key);
+			const_iterator find(const Key &key) const;
+			// find every key of [first, last) and write one iterator per key
+			// to out, end() for the missing ones. faster than calling find
+			// in a loop once the tree no longer fits in cache
+			template <typename ForwardIterator, typename OutputIterator>
+			OutputIterator find_batch(ForwardIterator first, ForwardIterator last, OutputIterator out) {
+				return findBatch<iterator>(first, last, out);
+			}
+			template <typename ForwardIterator, typename OutputIterator>
+			OutputIterator find_batch(ForwardIterator first, ForwardIterator last, OutputIterator out) const {
+				return findBatch<const_iterator>(first, last, out);
+			}
+			// first element whose key is not less than key
+			iterator lower_bound(const Key &key) { return iterator(lowerBound(key)); }
+			const_iterator lower_bound(const Key &key) const { return const_iterator(lowerBound(key)); }
+			// first element whose key is greater than key
+			iterator upper_bound(const Key &key) { return iterator(upperBound(key)); }
+			const_iterator upper_bound(const Key &key) const { return const_iterator(upperBound(key)); }
+			// range of elements whose key is equal to key (at most one)
+			ft::pair<iterator, iterator> equal_range(const Key &key);
+			ft::pair<const_iterator, const_iterator> equal_range(const Key &key) const;
+			// heterogeneous versions of the lookups, for comparators with
+			// is_transparent: key is anything Compare orders against Key
+			template <typename K>
+			typename transparent_lookup<Compare, K, iterator>::type find(const K &key) {
+				NodeBase *result = searchBST(header.parent(), key);
+				return iterator(result != NULL ? result : &header);
+			}
+			template <typename K>
+			typename transparent_lookup<Compare, K, const_iterator>::type find(const K &key) const {
+				const NodeBase *result = searchBST(header.parent(), key);
+				return const_iterator(result != NULL ? result : &header);
+			}
+			template <typename K>
+			typename transparent_lookup<Compare, K, bool>::type contains(const K &key) const {
+				return searchBST(header.parent(), key) != NULL;
+			}
+			template <typename K>
+			typename transparent_lookup<Compare, K, iterator>::type lower_bound(const K &key) { return iterator(lowerBound(key)); }
+			template <typename K>
+			typename transparent_lookup<Compare, K, const_iterator>::type lower_bound(const K &key) const { return const_iterator(lowerBound(key)); }
+			template <typename K>
+			typename transparent_lookup<Compare, K, iterator>::type upper_bound(const K &key) { return iterator(upperBound(key)); }
+			template <typename K>
+			typename transparent_lookup<Compare, K, const_iterator>::type upper_bound(const K &key) const { return const_iterator(upperBound(key)); }
+			template <typename K>
+			typename transparent_lookup<Compare, K, ft::pair<iterator, iterator> >::type equal_range(const K &key) {
+				iterator first = lower_bound(key);
+				iterator last = first;
+				if (last != end() && !keyLess(key, last->first))
+					++last;
+				return ft::pair<iterator, iterator>(first, last);
+			}
+			template <typename K>
+			typename transparent_lookup<Compare, K, ft::pair<const_iterator, const_iterator> >::type equal_range(const K &key) const {
+				const_iterator first = lower_bound(key);
+				const_iterator last = first;
+				if (last != end() && !keyLess(key, last->first))
+					++last;
+				return ft::pair<const_iterator, const_iterator>(first, last);
+			}
+			template <typename K>
+			typename transparent_lookup<Compare, K, size_type>::type remove(const K &key) {
+				Node<Key, Value, Augment> *z = searchBST(header.parent(), key);
+				if (z == NULL)
+					return 0;
+				eraseNode(z);
+				return 1;
+			}
 
 		class iterator {
-    	public:
-        using difference_type = std::ptrdiff_t;
-        using value_type = ft::pair<const Key, Value>;
-        using reference = value_type&;
-        using pointer = value_type*;
-        using iterator_category = std::forward_iterator_tag;
+			public:
+				typedef std::ptrdiff_t difference_type;
+				typedef ft::pair<const Key, Value> value_type;
+				// read-only when the policy folds the values, see update()
+				typedef typename std::conditional<Augment::folds_values, const value_type, value_type>::type& reference;
+				typedef typename std::conditional<Augment::folds_values, const value_type, value_type>::type* pointer;
+				typedef std::bidirectional_iterator_tag iterator_category;
 
 				// default constructor
 				iterator() : current(NULL) {}
-        iterator(Node<Key, Value> *current) : current(current) {}
-        iterator(const iterator &other) : current(other.current) {}
+				explicit iterator(NodeBase *current) : current(current) {}
 
-        iterator& operator++() {
-					current = RBTree().successor(current);
+				iterator& operator++() {
+					current = treeIncrement(current);
 					return *this;
-        }
+				}
 
-        iterator operator++(int) {
+				iterator operator++(int) {
 					iterator tmp(*this);
-					operator++();
+					current = treeIncrement(current);
 					return tmp;
-        }
+				}
 
-        reference operator*() const {
-					return *reinterpret_cast<value_type*>(current);
-        }
+				iterator& operator--() {
+					current = treeDecrement(current);
+					return *this;
+				}
 
-        pointer operator->() const {
-					return reinterpret_cast<value_type*>(current);
-        }
+				iterator operator--(int) {
+					iterator tmp(*this);
+					current = treeDecrement(current);
+					return tmp;
+				}
 
-        bool operator==(const iterator &other) const {
+				reference operator*() const {
+					return static_cast<Node<Key, Value, Augment> *>(current)->data;
+				}
+
+				pointer operator->() const {
+					return &static_cast<Node<Key, Value, Augment> *>(current)->data;
+				}
+
+				bool operator==(const iterator &other) const {
 					return current == other.current;
-        }
+				}
 
-        bool operator!=(const iterator &other) const {
+				bool operator!=(const iterator &other) const {
 					return current != other.current;
-        }
+				}
 
-  	  private:
-        Node<Key, Value> *current;
-    };
+				// found by argument dependent lookup (call it unqualified),
+				// O(log n) with the order_statistic policy
+				friend difference_type distance(iterator first, iterator last) {
+					return distance(const_iterator(first), const_iterator(last));
+				}
 
-		// iterator begin() {
-		// 	Node<Key, Value> *n = minimum(root);
-		// 	return iterator(n);
-    // }
+			private:
+				NodeBase *current;
 
-    // iterator end() {
-		// 	return iterator(nullptr);
-    // }
+				friend class RBTree;
+				friend class const_iterator;
+		};
 
 		// const iterator
 		class const_iterator {
 			public:
-				using difference_type = std::ptrdiff_t;
-				using value_type = ft::pair<const Key, Value>;
-				using reference = value_type&;
-				using pointer = value_type*;
-				using iterator_category = std::forward_iterator_tag;
+				typedef std::ptrdiff_t difference_type;
+				typedef ft::pair<const Key, Value> value_type;
+				typedef const value_type& reference;
+				typedef const value_type* pointer;
+				typedef std::bidirectional_iterator_tag iterator_category;
 
 				// default constructor
 				const_iterator() : current(NULL) {}
-				const_iterator(Node<Key, Value> *current) : current(current) {}
-				const_iterator(const const_iterator &other) : current(other.current) {}
+				explicit const_iterator(const NodeBase *current) : current(current) {}
+				const_iterator(const iterator &other) : current(other.current) {}
 
 				const_iterator& operator++() {
-					current = RBTree().successor(current);
+					current = treeIncrement(current);
 					return *this;
 				}
 
 				const_iterator operator++(int) {
 					const_iterator tmp(*this);
-					operator++();
+					current = treeIncrement(current);
+					return tmp;
+				}
+
+				const_iterator& operator--() {
+					current = treeDecrement(current);
+					return *this;
+				}
+
+				const_iterator operator--(int) {
+					const_iterator tmp(*this);
+					current = treeDecrement(current);
 					return tmp;
 				}
 
 				reference operator*() const {
-					return *reinterpret_cast<value_type*>(current);
+					return static_cast<const Node<Key, Value, Augment> *>(current)->data;
 				}
 
 				pointer operator->() const {
-					return reinterpret_cast<value_type*>(current);
+					return &static_cast<const Node<Key, Value, Augment> *>(current)->data;
 				}
 
 				bool operator==(const const_iterator &other) const {
@@ -168,504 +792,1633 @@ namespace ft {
 					return current != other.current;
 				}
 
-		  private:
-				Node<Key, Value> *current;
-		};
+				friend difference_type distance(const_iterator first, const_iterator last) {
+					return const_iterator::distanceBetween(first, last);
+				}
 
-		// const_iterator cbegin() const {
-		// 	Node<Key, Value> *n = RBTree().minimum(root);
-		// 	return const_iterator(n);
-		// }
+			private:
+				const NodeBase *current;
+
+				// nested class, so it may use the tree's private helpers
+				static difference_type distanceBetween(const_iterator first, const_iterator last) {
+					if (Augment::sized)
+						return static_cast<difference_type>(rankOf(last.current)) - static_cast<difference_type>(rankOf(first.current));
+					difference_type n = 0;
+					for (; first != last; ++first)
+						++n;
+					return n;
+				}
 
-		// const_iterator cend() const {
-		// 	return const_iterator(nullptr);
-		// }
+				friend class RBTree;
+		};
 
-		// reverse iterator
-		class reverse_iterator {
+		// owns a node taken out of a tree, and the storage it lives in
+		class node_handle {
 			public:
-				using difference_type = std::ptrdiff_t;
-				using value_type = ft::pair<const Key, Value>;
-				using reference = value_type&;
-				using pointer = value_type*;
-				using iterator_category = std::forward_iterator_tag;
-				// default constructor
-				reverse_iterator() : current(NULL) {}
-				reverse_iterator(Node<Key, Value> *current) : current(current) {}
-				reverse_iterator(const reverse_iterator &other) : current(other.current) {}
+				typedef Key key_type;
+				typedef Value mapped_type;
 
-				reverse_iterator& operator++() {
-					current = RBTree().predecessor(current);
+				node_handle() : node(NULL) {}
+				node_handle(node_handle &&other) : node(other.node), arena(std::move(other.arena)) {
+					other.node = NULL;
+				}
+				node_handle &operator=(node_handle &&other) {
+					if (this != &other) {
+						reset();
+						node = other.node;
+						arena = std::move(other.arena);
+						other.node = NULL;
+					}
 					return *this;
 				}
-
-				reverse_iterator operator++(int) {
-					reverse_iterator tmp(*this);
-					operator++();
-					return tmp;
+				~node_handle() { reset(); }
+
+				bool empty() const { return node == NULL; }
+				explicit operator bool() const { return node != NULL; }
+				const key_type &key() const { return node->data.first; }
+				mapped_type &mapped() const { return node->data.second; }
+				void swap(node_handle &other) {
+					std::swap(node, other.node);
+					arena.swap(other.arena);
 				}
 
-				reference operator*() const {
-					return *reinterpret_cast<value_type*>(current);
+			private:
+				Node<Key, Value, Augment> *node;
+				typename pool_type::arena_ref arena;
+
+				node_handle(Node<Key, Value, Augment> *node, const typename pool_type::arena_ref &arena) : node(node), arena(arena) {}
+				node_handle(const node_handle &);
+				node_handle &operator=(const node_handle &);
+
+				// destroy the node, its slot goes back to the arena it came from
+				void reset() {
+					if (node == NULL)
+						return;
+					node->~Node();
+					pool_type::give_back(arena, node);
+					node = NULL;
+					arena.reset();
 				}
 
-				pointer operator->() const {
-					return reinterpret_cast<value_type*>(current);
-				}
+				friend class RBTree;
+		};
 
-				bool operator==(const reverse_iterator &other) const {
-					return current == other.current;
-				}
+		struct insert_return_type {
+			iterator position;
+			bool inserted;
+			node_handle node;
+		};
 
-				bool operator!=(const reverse_iterator &other) const {
-					return current != other.current;
-				}
+		iterator begin() {
+			return iterator(header.left);
+		}
 
-		  private:
-				Node<Key, Value> *current;
-		};
+		iterator end() {
+			return iterator(&header);
+		}
+
+		const_iterator begin() const {
+			return const_iterator(header.left);
+		}
+
+		const_iterator end() const {
+			return const_iterator(&header);
+		}
 
 		reverse_iterator rbegin() {
-			Node<Key, Value> *n = RBTree().maximum(root);
-			return reverse_iterator(n);
+			return reverse_iterator(end());
 		}
 
 		reverse_iterator rend() {
-			return reverse_iterator(nullptr);
+			return reverse_iterator(begin());
 		}
 
-		// const reverse iterator
-		class const_reverse_iterator {
-			public:
-				using difference_type = std::ptrdiff_t;
-				using value_type = ft::pair<const Key, Value>;
-				using reference = value_type&;
-				using pointer = value_type*;
-				using iterator_category = std::forward_iterator_tag;
-				// default constructor
-				const_reverse_iterator() : current(NULL) {}
-				const_reverse_iterator(Node<Key, Value> *current) : current(current) {}
-				const_reverse_iterator(const const_reverse_iterator &other) : current(other.current) {}
+		const_reverse_iterator rbegin() const {
+			return const_reverse_iterator(end());
+		}
 
-				const_reverse_iterator& operator++() {
-					current = RBTree().predecessor(current);
-					return *this;
-				}
+		const_reverse_iterator rend() const {
+			return const_reverse_iterator(begin());
+		}
 
-				const_reverse_iterator operator++(int) {
-					const_reverse_iterator tmp(*this);
-					operator++();
-					return tmp;
-				}
+	};
 
-				reference operator*() const {
-					return *reinterpret_cast<value_type*>(current);
-				}
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	void RBTree<Key, Value, Compare, Allocator, Augment, Stats>::resetHeader() {
+		header.setColor(RED);
+		header.setParent(NULL);
+		header.left = header.right = &header;
+	}
 
-				pointer operator->() const {
-					return reinterpret_cast<value_type*>(current);
-				}
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	void RBTree<Key, Value, Compare, Allocator, Augment, Stats>::updatePath(NodeBase *x) {
+		if (!Augment::enabled)
+			return;
+		for (; x != &header; x = x->parent())
+			updateNode(x);
+	}
 
-				bool operator==(const const_reverse_iterator &other) const {
-					return current == other.current;
-				}
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	typename RBTree<Key, Value, Compare, Allocator, Augment, Stats>::size_type RBTree<Key, Value, Compare, Allocator, Augment, Stats>::rankOf(const NodeBase *x) {
+		// the header is the only red node whose grandparent is itself
+		if (x->color() == RED && x->parent() != NULL && x->parent()->parent() == x)
+			return subtreeSize(x->parent());
+		if (x->color() == RED && x->parent() == NULL)
+			return 0;	// header of an empty tree
+		size_type rank = subtreeSize(x->left);
+		// climb to the root, every time we come up from a right child the
+		// parent and its left subtree are before x
+		while (x->parent()->parent() != x) {
+			const NodeBase *parent = x->parent();
+			if (x == parent->right)
+				rank += subtreeSize(parent->left) + 1;
+			x = parent;
+		}
+		return rank;
+	}
 
-				bool operator!=(const const_reverse_iterator &other) const {
-					return current != other.current;
-				}
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	typename RBTree<Key, Value, Compare, Allocator, Augment, Stats>::size_type RBTree<Key, Value, Compare, Allocator, Augment, Stats>::rank(const Key &key) const {
+		if (!Augment::sized)
+			return static_cast<size_type>(distance(begin(), lower_bound(key)));
+		NodeBase *x = header.parent();
+		size_type rank = 0;
+		while (x != NULL) {
+			if (keyLess(keyOf(x), key)) {
+				rank += subtreeSize(x->left) + 1;
+				x = x->right;
+			} else {
+				x = x->left;
+			}
+		}
+		return rank;
+	}
 
-		  private:
-				Node<Key, Value> *current;
-		};
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	typename RBTree<Key, Value, Compare, Allocator, Augment, Stats>::const_iterator RBTree<Key, Value, Compare, Allocator, Augment, Stats>::select(size_type k) const {
+		// neither path asks size(), which may walk the tree after a split
+		if (!Augment::sized) {
+			const_iterator it = begin();
+			for (; k > 0 && it != end(); --k)
+				++it;
+			return it;
+		}
+		const NodeBase *x = header.parent();
+		if (k >= subtreeSize(x))
+			return end();
+		for (;;) {
+			size_type leftSize = subtreeSize(x->left);
+			if (k < leftSize) {
+				x = x->left;
+			} else if (k == leftSize) {
+				return const_iterator(x);
+			} else {
+				k -= leftSize + 1;
+				x = x->right;
+			}
+		}
+	}
 
-		const_reverse_iterator rbegin() const {
-			Node<Key, Value> *n = RBTree().maximum(root);
-			return const_reverse_iterator(n);
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	typename RBTree<Key, Value, Compare, Allocator, Augment, Stats>::iterator RBTree<Key, Value, Compare, Allocator, Augment, Stats>::select(size_type k) {
+		return iterator(const_cast<NodeBase *>(static_cast<const RBTree *>(this)->select(k).current));
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	typename Augment::value_type RBTree<Key, Value, Compare, Allocator, Augment, Stats>::range_aggregate(const Key &lo, const Key &hi) const {
+		// find the highest node inside the range, the range is then the
+		// right spine of its left subtree and the left spine of its right one
+		const NodeBase *split = header.parent();
+		while (split != NULL) {
+			if (keyLess(keyOf(split), lo))
+				split = split->right;
+			else if (!keyLess(keyOf(split), hi))
+				split = split->left;
+			else
+				break;
+		}
+		if (split == NULL)
+			return Augment::identity();
+
+		// left side: a node not less than lo is in the range with its whole
+		// right subtree, and comes after everything gathered below it
+		typename Augment::value_type left = Augment::identity();
+		for (const NodeBase *x = split->left; x != NULL; ) {
+			if (!keyLess(keyOf(x), lo)) {
+				left = Augment::combine(Augment::combine(nodeAggregate(x), subtreeAggregate(x->right)), left);
+				x = x->left;
+			} else {
+				x = x->right;
+			}
 		}
+		// right side: the mirror image for keys less than hi
+		typename Augment::value_type right = Augment::identity();
+		for (const NodeBase *x = split->right; x != NULL; ) {
+			if (keyLess(keyOf(x), hi)) {
+				right = Augment::combine(right, Augment::combine(subtreeAggregate(x->left), nodeAggregate(x)));
+				x = x->right;
+			} else {
+				x = x->left;
+			}
+		}
+		return Augment::combine(Augment::combine(left, nodeAggregate(split)), right);
+	}
 
-		const_reverse_iterator rend() const {
-			return const_reverse_iterator(nullptr);
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	template <typename Enter, typename Visit>
+	void RBTree<Key, Value, Compare, Allocator, Augment, Stats>::visit_pruned(Enter enter, Visit visit) const {
+		visitHelper(header.parent(), enter, visit);
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	template <typename Enter, typename Visit>
+	bool RBTree<Key, Value, Compare, Allocator, Augment, Stats>::visitHelper(const NodeBase *x, Enter &enter, Visit &visit) const {
+		if (x == NULL)
+			return true;
+		const Node<Key, Value, Augment> &node = *static_cast<const Node<Key, Value, Augment> *>(x);
+		if (!enter(node))
+			return true;
+		return visitHelper(x->left, enter, visit) && visit(node) && visitHelper(x->right, enter, visit);
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	RBTree<Key, Value, Compare, Allocator, Augment, Stats>::RBTree(const RBTree &other)
+		: CompareHolder<Compare>(other.compare()), header(), nodeCount(0),
+		  pool(std::allocator_traits<node_allocator>::select_on_container_copy_construction(other.pool.get_allocator())) {
+		resetHeader();
+		if (other.header.parent() == NULL)
+			return;
+		pool.reserve(other.size());
+		header.setParent(copyHelper(other.header.parent(), &header));
+		header.left = treeMinimum(header.parent());
+		header.right = treeMaximum(header.parent());
+		nodeCount = other.nodeCount;
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	RBTree<Key, Value, Compare, Allocator, Augment, Stats>& RBTree<Key, Value, Compare, Allocator, Augment, Stats>::operator=(const RBTree &other) {
+		if (this != &other) {
+			RBTree tmp(other);
+			swap(tmp);
 		}
+		return *this;
+	}
 
-	};
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	NodeBase* RBTree<Key, Value, Compare, Allocator, Augment, Stats>::copyHelper(const NodeBase *src, NodeBase *parent) {
+		NodeBase *node = createNode(static_cast<const Node<Key, Value, Augment> *>(src)->data);
+		node->setColor(src->color());
+		node->setParent(parent);
+		try {
+			if (src->left != NULL)
+				node->left = copyHelper(src->left, node);
+			if (src->right != NULL)
+				node->right = copyHelper(src->right, node);
+		} catch (...) {
+			clearHelper(node);
+			throw;
+		}
+		if (Augment::enabled)
+			updateNode(node);
+		return node;
+	}
 
-	template <typename Key, typename Value>
-	void RBTree<Key, Value>::rotateLeft(Node<Key, Value> *&root, Node<Key, Value> *&pt) {
-			Node<Key, Value> *pt_right = pt->right;
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	void RBTree<Key, Value, Compare, Allocator, Augment, Stats>::swap(RBTree &other) {
+		std::swap(this->compare(), other.compare());
+		std::swap(header, other.header);
+		std::swap(nodeCount, other.nodeCount);
+		pool.swap(other.pool);
+		// the root points back at its header, an empty header points at itself
+		if (header.parent() != NULL)
+			header.parent()->setParent(&header);
+		else
+			resetHeader();
+		if (other.header.parent() != NULL)
+			other.header.parent()->setParent(&other.header);
+		else
+			other.resetHeader();
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	void RBTree<Key, Value, Compare, Allocator, Augment, Stats>::rotateLeft(NodeBase *pt) {
+			Stats::rotation();
+			NodeBase *pt_right = pt->right;
 			pt->right = pt_right->left;
 			if (pt->right != NULL) {
-				pt->right->parent = pt;
-			}
-			pt_right->parent = pt->parent;
-			if (pt->parent == NULL) {
-				root = pt_right;
-			} else if (pt == pt->parent->left) {
-				pt->parent->left = pt_right;
-			} else {
-				pt->parent->right = pt_right;
+				pt->right->setParent(pt);
 			}
+			pt_right->setParent(pt->parent());
+			replaceChild(pt->parent(), pt, pt_right);
 			pt_right->left = pt;
-			pt->parent = pt_right;
+			pt->setParent(pt_right);
+			// pt is now below pt_right, recompute it first
+			if (Augment::enabled) {
+				updateNode(pt);
+				updateNode(pt_right);
+			}
 	}
 
-	template <typename Key, typename Value>
-	void RBTree<Key, Value>::rotateRight(Node<Key, Value> *&root, Node<Key, Value> *&pt) {
-		Node<Key, Value> *pt_left = pt->left;
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	void RBTree<Key, Value, Compare, Allocator, Augment, Stats>::rotateRight(NodeBase *pt) {
+		Stats::rotation();
+		NodeBase *pt_left = pt->left;
 
 		pt->left = pt_left->right;
 
-		if (pt->left != NULL)  
-			pt->left->parent = pt;
+		if (pt->left != NULL)
+			pt->left->setParent(pt);
+
+		pt_left->setParent(pt->parent());
 
-		pt_left->parent = pt->parent;
+		replaceChild(pt->parent(), pt, pt_left);
 
-		if (pt->parent == NULL)
-			root = pt_left;
+		pt_left->right = pt;
+		pt->setParent(pt_left);
+		if (Augment::enabled) {
+			updateNode(pt);
+			updateNode(pt_left);
+		}
+	}
 
-		else if (pt == pt->parent->left)
-			pt->parent->left = pt_left;
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	typename RBTree<Key, Value, Compare, Allocator, Augment, Stats>::size_type RBTree<Key, Value, Compare, Allocator, Augment, Stats>::blackHeightOf(const NodeBase *x) {
+		size_type bh = 0;
+		for (; x != NULL; x = x->left)
+			bh += x->color() == BLACK;
+		return bh;
+	}
 
-		else
-			pt->parent->right = pt_left;
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	typename RBTree<Key, Value, Compare, Allocator, Augment, Stats>::Subtree RBTree<Key, Value, Compare, Allocator, Augment, Stats>::detach(NodeBase *x, size_type bh) {
+		Subtree t = { x, bh };
+		if (x == NULL)
+			return t;
+		x->setParent(NULL);
+		if (x->color() == RED) {
+			x->setColor(BLACK);
+			++t.blackHeight;
+		}
+		return t;
+	}
 
-		pt_left->right = pt;
-		pt->parent = pt_left;
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	typename RBTree<Key, Value, Compare, Allocator, Augment, Stats>::Subtree RBTree<Key, Value, Compare, Allocator, Augment, Stats>::joinAt(Subtree left, NodeBase *k, Subtree right) {
+		k->left = k->right = NULL;
+		k->setColor(RED);
+		if (left.blackHeight >= right.blackHeight) {
+			// k replaces the first black node of right's black height on
+			// the right spine of left, which becomes k's left subtree
+			NodeBase *parent = NULL;
+			NodeBase *x = left.root;
+			size_type bh = left.blackHeight;
+			while (x != NULL && !(x->color() == BLACK && bh == right.blackHeight)) {
+				bh -= x->color() == BLACK;
+				parent = x;
+				x = x->right;
+			}
+			k->left = x;
+			k->right = right.root;
+			if (parent == NULL) {
+				header.setParent(k);
+				k->setParent(&header);
+			} else {
+				header.setParent(left.root);
+				left.root->setParent(&header);
+				parent->right = k;
+				k->setParent(parent);
+			}
+		} else {
+			// the mirror image on the left spine of right
+			NodeBase *parent = NULL;
+			NodeBase *x = right.root;
+			size_type bh = right.blackHeight;
+			while (x != NULL && !(x->color() == BLACK && bh == left.blackHeight)) {
+				bh -= x->color() == BLACK;
+				parent = x;
+				x = x->left;
+			}
+			k->left = left.root;
+			k->right = x;
+			header.setParent(right.root);
+			right.root->setParent(&header);
+			parent->left = k;
+			k->setParent(parent);
+		}
+		if (k->left != NULL)
+			k->left->setParent(k);
+		if (k->right != NULL)
+			k->right->setParent(k);
+		// k is as deep as the black heights differ, so is this path
+		updatePath(k);
+		bool grew = fixViolation(k);
+		Subtree t = { header.parent(), std::max(left.blackHeight, right.blackHeight) + grew };
+		return t;
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	NodeBase* RBTree<Key, Value, Compare, Allocator, Augment, Stats>::splitAt(Subtree t, const Key &key, Subtree &less, Subtree &greater) {
+		// the path down to key, each node with its black height
+		NodeBase *path[2 * std::numeric_limits<size_type>::digits];
+		size_type heights[2 * std::numeric_limits<size_type>::digits];
+		size_type depth = 0;
+		NodeBase *equal = NULL;
+
+		for (NodeBase *x = t.root; x != NULL; ) {
+			path[depth] = x;
+			heights[depth++] = t.blackHeight;
+			t.blackHeight -= x->color() == BLACK;
+			if (keyLess(keyOf(x), key)) {
+				x = x->right;
+			} else if (keyLess(key, keyOf(x))) {
+				x = x->left;
+			} else {
+				equal = x;
+				break;
+			}
+		}
+		less.root = greater.root = NULL;
+		less.blackHeight = greater.blackHeight = 0;
+		size_type i = depth;
+		if (equal != NULL) {
+			--i;
+			less = detach(equal->left, t.blackHeight);
+			greater = detach(equal->right, t.blackHeight);
+		}
+		// bottom-up: every node of the path joins the side it belongs to
+		// together with its subtree on the far side of the path. the joins
+		// climb black heights that only grow, so they cost O(log n) in all
+		while (i-- > 0) {
+			NodeBase *x = path[i];
+			size_type childHeight = heights[i] - (x->color() == BLACK);
+			if (keyLess(keyOf(x), key))
+				less = joinAt(detach(x->left, childHeight), x, less);
+			else
+				greater = joinAt(greater, x, detach(x->right, childHeight));
+		}
+		return equal;
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	void RBTree<Key, Value, Compare, Allocator, Augment, Stats>::setRoot(Subtree t, size_type count) {
+		if (t.root == NULL) {
+			resetHeader();
+			nodeCount = 0;
+			return;
+		}
+		header.setParent(t.root);
+		t.root->setParent(&header);
+		header.left = treeMinimum(t.root);
+		header.right = treeMaximum(t.root);
+		nodeCount = Augment::sized ? subtreeSize(t.root) : count;
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	typename RBTree<Key, Value, Compare, Allocator, Augment, Stats>::size_type RBTree<Key, Value, Compare, Allocator, Augment, Stats>::destroySubtree(NodeBase *x) {
+		if (x == NULL)
+			return 0;
+		size_type n = destroySubtree(x->left) + destroySubtree(x->right) + 1;
+		destroyNode(static_cast<Node<Key, Value, Augment> *>(x));
+		return n;
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	RBTree<Key, Value, Compare, Allocator, Augment, Stats> RBTree<Key, Value, Compare, Allocator, Augment, Stats>::split(const Key &key) {
+		RBTree greater(key_comp(), get_allocator());
+		if (empty())
+			return greater;
+		Subtree whole = { header.parent(), blackHeightOf(header.parent()) };
+		Subtree less, more;
+		NodeBase *equal = splitAt(whole, key, less, more);
+		// a key equal to key goes with the greater ones, as their minimum
+		if (equal != NULL) {
+			Subtree none = { NULL, 0 };
+			more = joinAt(none, equal, more);
+		}
+		greater.pool.adopt(pool.share());
+		greater.setRoot(more, unknownCount);
+		setRoot(less, unknownCount);
+		return greater;
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	void RBTree<Key, Value, Compare, Allocator, Augment, Stats>::join(RBTree &greater) {
+		if (&greater == this || greater.empty())
+			return;
+		if (empty()) {
+			swap(greater);
+			return;
+		}
+		// the smallest node of greater goes between the two
+		NodeBase *pivot = greater.header.left;
+		greater.unlinkNode(pivot);
+		joinTrees(pivot, greater);
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	void RBTree<Key, Value, Compare, Allocator, Augment, Stats>::join(const ft::pair<const Key, Value> &pivot, RBTree &greater) {
+		joinTrees(createNode(pivot), greater);
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	void RBTree<Key, Value, Compare, Allocator, Augment, Stats>::joinTrees(NodeBase *pivot, RBTree &greater) {
+		size_type count = unknownCount;
+		if (nodeCount != unknownCount && greater.nodeCount != unknownCount)
+			count = nodeCount + 1 + greater.nodeCount;
+		Subtree left = { header.parent(), blackHeightOf(header.parent()) };
+		Subtree right = { greater.header.parent(), blackHeightOf(greater.header.parent()) };
+		if (right.root != NULL)
+			right.root->setParent(NULL);
+		pool.adopt(greater.pool.share());
+		greater.resetHeader();
+		greater.nodeCount = 0;
+		setRoot(joinAt(left, pivot, right), count);
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	void RBTree<Key, Value, Compare, Allocator, Augment, Stats>::erase(const_iterator first, const_iterator last) {
+		if (first == last)
+			return;
+		if (first.current == header.left && last.current == &header) {
+			clear();
+			return;
+		}
+		size_type count = nodeCount;
+		Subtree whole = { header.parent(), blackHeightOf(header.parent()) };
+		Subtree less, rest, greater = { NULL, 0 };
+		// [first, last) is cut out by two splits, first's node is the
+		// equal one of the first split and last's node of the second
+		NodeBase *firstNode = splitAt(whole, keyOf(first.current), less, rest);
+		NodeBase *lastNode = NULL;
+		size_type erased = 1;
+		if (last.current == &header) {
+			erased += destroySubtree(rest.root);
+		} else {
+			Subtree range;
+			lastNode = splitAt(rest, keyOf(last.current), range, greater);
+			erased += destroySubtree(range.root);
+		}
+		destroyNode(static_cast<Node<Key, Value, Augment> *>(firstNode));
+		if (lastNode != NULL)
+			less = joinAt(less, lastNode, greater);
+		setRoot(less, count == unknownCount ? count : count - erased);
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	typename RBTree<Key, Value, Compare, Allocator, Augment, Stats>::size_type RBTree<Key, Value, Compare, Allocator, Augment, Stats>::destroyDiscarded(const Discarded &discarded) {
+		size_type n = 0;
+		NodeBase *next;
+		for (NodeBase *x = discarded.head; x != NULL; x = next) {
+			next = x->parent();
+			n += destroySubtree(x);
+		}
+		return n;
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	typename RBTree<Key, Value, Compare, Allocator, Augment, Stats>::Subtree RBTree<Key, Value, Compare, Allocator, Augment, Stats>::concat(Subtree left, Subtree right) {
+		if (right.root == NULL)
+			return left;
+		if (left.root == NULL)
+			return right;
+		// the smallest node of right becomes the pivot
+		Subtree none, rest;
+		NodeBase *pivot = splitAt(right, keyOf(treeMinimum(right.root)), none, rest);
+		return joinAt(left, pivot, rest);
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	typename RBTree<Key, Value, Compare, Allocator, Augment, Stats>::size_type RBTree<Key, Value, Compare, Allocator, Augment, Stats>::forkDepth(const thread_pool &workers) {
+		if (workers.concurrency() == 1)
+			return 0;
+		size_type depth = 3;
+		for (size_type n = 1; n < workers.concurrency(); n *= 2)
+			++depth;
+		return depth;
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	typename RBTree<Key, Value, Compare, Allocator, Augment, Stats>::Subtree RBTree<Key, Value, Compare, Allocator, Augment, Stats>::unionAt(Subtree a, Subtree b, size_type depth, thread_pool &workers, Discarded &discarded) {
+		if (a.root == NULL)
+			return b;
+		if (b.root == NULL)
+			return a;
+		// a's root is black, its children are one black level lower
+		NodeBase *k = a.root;
+		Subtree aLess = detach(k->left, a.blackHeight - 1);
+		Subtree aGreater = detach(k->right, a.blackHeight - 1);
+		Subtree bLess, bGreater;
+		NodeBase *equal = splitAt(b, keyOf(k), bLess, bGreater);
+		if (equal != NULL)
+			discarded.push(isolate(equal));
+
+		Subtree less, greater;
+		Discarded greaterDiscarded = { NULL, NULL };
+		if (depth < forkDepth(workers)) {
+			workers.invoke(
+				[&] { less = unionAt(aLess, bLess, depth + 1, workers, discarded); },
+				[&] {
+					RBTree scratch(key_comp(), get_allocator());
+					greater = scratch.unionAt(aGreater, bGreater, depth + 1, workers, greaterDiscarded);
+					scratch.resetHeader();
+				});
+		} else {
+			less = unionAt(aLess, bLess, depth + 1, workers, discarded);
+			greater = unionAt(aGreater, bGreater, depth + 1, workers, greaterDiscarded);
+		}
+		discarded.append(greaterDiscarded);
+		return joinAt(less, k, greater);
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	typename RBTree<Key, Value, Compare, Allocator, Augment, Stats>::Subtree RBTree<Key, Value, Compare, Allocator, Augment, Stats>::filterAt(Subtree a, const NodeBase *b, bool keepCommon, size_type depth, thread_pool &workers, Discarded &discarded) {
+		if (a.root == NULL)
+			return a;
+		if (b == NULL) {
+			if (!keepCommon)
+				return a;
+			discarded.push(a.root);
+			Subtree none = { NULL, 0 };
+			return none;
+		}
+		// b is only read, a is cut at b's root and each side goes on
+		// with the matching side of b
+		Subtree aLess, aGreater;
+		NodeBase *equal = splitAt(a, keyOf(b), aLess, aGreater);
+
+		Subtree less, greater;
+		Discarded greaterDiscarded = { NULL, NULL };
+		if (depth < forkDepth(workers)) {
+			workers.invoke(
+				[&] { less = filterAt(aLess, b->left, keepCommon, depth + 1, workers, discarded); },
+				[&] {
+					RBTree scratch(key_comp(), get_allocator());
+					greater = scratch.filterAt(aGreater, b->right, keepCommon, depth + 1, workers, greaterDiscarded);
+					scratch.resetHeader();
+				});
+		} else {
+			less = filterAt(aLess, b->left, keepCommon, depth + 1, workers, discarded);
+			greater = filterAt(aGreater, b->right, keepCommon, depth + 1, workers, greaterDiscarded);
+		}
+		discarded.append(greaterDiscarded);
+		if (equal != NULL && keepCommon)
+			return joinAt(less, equal, greater);
+		if (equal != NULL)
+			discarded.push(isolate(equal));
+		return concat(less, greater);
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	void RBTree<Key, Value, Compare, Allocator, Augment, Stats>::union_with(RBTree &other, thread_pool &workers) {
+		if (&other == this || other.empty())
+			return;
+		size_type count = unknownCount;
+		if (nodeCount != unknownCount && other.nodeCount != unknownCount)
+			count = nodeCount + other.nodeCount;
+		Subtree a = { header.parent(), blackHeightOf(header.parent()) };
+		Subtree b = { other.header.parent(), blackHeightOf(other.header.parent()) };
+		b.root->setParent(NULL);
+		pool.adopt(other.pool.share());
+		other.resetHeader();
+		other.nodeCount = 0;
+		Discarded discarded = { NULL, NULL };
+		Subtree result = unionAt(a, b, 0, workers, discarded);
+		size_type destroyed = destroyDiscarded(discarded);
+		setRoot(result, count == unknownCount ? count : count - destroyed);
 	}
 
-	template <typename Key, typename Value>
-	void RBTree<Key, Value>::fixViolation(Node<Key, Value> *&root, Node<Key, Value> *&pt) {
-		Node<Key, Value> *parent_pt = NULL;
-		Node<Key, Value> *grand_parent_pt = NULL;
-		while ((pt != root) && (pt->color != BLACK) &&
-			(pt->parent->color == RED)) {
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	void RBTree<Key, Value, Compare, Allocator, Augment, Stats>::intersect(const RBTree &other, thread_pool &workers) {
+		if (&other == this)
+			return;
+		size_type count = nodeCount;
+		Subtree a = { header.parent(), blackHeightOf(header.parent()) };
+		Discarded discarded = { NULL, NULL };
+		Subtree result = filterAt(a, other.header.parent(), true, 0, workers, discarded);
+		size_type destroyed = destroyDiscarded(discarded);
+		setRoot(result, count == unknownCount ? count : count - destroyed);
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	void RBTree<Key, Value, Compare, Allocator, Augment, Stats>::difference(const RBTree &other, thread_pool &workers) {
+		if (&other == this) {
+			clear();
+			return;
+		}
+		size_type count = nodeCount;
+		Subtree a = { header.parent(), blackHeightOf(header.parent()) };
+		Discarded discarded = { NULL, NULL };
+		Subtree result = filterAt(a, other.header.parent(), false, 0, workers, discarded);
+		size_type destroyed = destroyDiscarded(discarded);
+		setRoot(result, count == unknownCount ? count : count - destroyed);
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	bool RBTree<Key, Value, Compare, Allocator, Augment, Stats>::fixViolation(NodeBase *pt) {
+		NodeBase *parent_pt = NULL;
+		NodeBase *grand_parent_pt = NULL;
+		// the root's parent is the (red) header, so test for the root first
+		while ((pt != header.parent()) && (pt->color() != BLACK) &&
+			(pt->parent()->color() == RED)) {
 
-			parent_pt = pt->parent;
-			grand_parent_pt = pt->parent->parent;
+			parent_pt = pt->parent();
+			grand_parent_pt = pt->parent()->parent();
 
 			if (parent_pt == grand_parent_pt->left) {
-				Node<Key, Value> *uncle_pt = grand_parent_pt->right;
+				NodeBase *uncle_pt = grand_parent_pt->right;
 
-				if (uncle_pt != NULL && uncle_pt->color == RED) {
-					grand_parent_pt->color = RED;
-					parent_pt->color = BLACK;
-					uncle_pt->color = BLACK;
+				if (uncle_pt != NULL && uncle_pt->color() == RED) {
+					grand_parent_pt->setColor(RED);
+					parent_pt->setColor(BLACK);
+					uncle_pt->setColor(BLACK);
 					pt = grand_parent_pt;
 				} else {
 					if (pt == parent_pt->right) {
-						rotateLeft(root, parent_pt);
+						rotateLeft(parent_pt);
 						pt = parent_pt;
-						parent_pt = pt->parent;
+						parent_pt = pt->parent();
 					}
-					rotateRight(root, grand_parent_pt);
-					std::swap(parent_pt->color, grand_parent_pt->color);
+					rotateRight(grand_parent_pt);
+					parent_pt->setColor(BLACK);
+					grand_parent_pt->setColor(RED);
 					pt = parent_pt;
 				}
 			} else {
-				Node<Key, Value> *uncle_pt = grand_parent_pt->left;
+				NodeBase *uncle_pt = grand_parent_pt->left;
 
-				if ((uncle_pt != NULL) && (uncle_pt->color == RED)) {
-					grand_parent_pt->color = RED;
-					parent_pt->color = BLACK;
-					uncle_pt->color = BLACK;
+				if ((uncle_pt != NULL) && (uncle_pt->color() == RED)) {
+					grand_parent_pt->setColor(RED);
+					parent_pt->setColor(BLACK);
+					uncle_pt->setColor(BLACK);
 					pt = grand_parent_pt;
 				} else {
 					if (pt == parent_pt->left) {
-						rotateRight(root, parent_pt);
+						rotateRight(parent_pt);
 						pt = parent_pt;
-						parent_pt = pt->parent;
+						parent_pt = pt->parent();
 					}
-					rotateLeft(root, grand_parent_pt);
-					std::swap(parent_pt->color, grand_parent_pt->color);
+					rotateLeft(grand_parent_pt);
+					parent_pt->setColor(BLACK);
+					grand_parent_pt->setColor(RED);
 					pt = parent_pt;
 				}
 			}
 		}
-		root->color = BLACK;
+		bool grew = header.parent()->color() == RED;
+		header.parent()->setColor(BLACK);
+		return grew;
 	}
 
-	template <typename Key, typename Value>
-	Node<Key, Value>* RBTree<Key, Value>::insertBST(Node<Key, Value> *root, Node<Key, Value> *pt) {
-		if (root == NULL) {
-			// When the tree is empty
-			pt->color = BLACK;
-			return pt;
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	NodeBase* RBTree<Key, Value, Compare, Allocator, Augment, Stats>::findInsertPos(const Key &key, NodeBase *&parent, bool &left) const {
+		NodeBase *x = header.parent();
+		// last node whose key is not greater than key, the only
+		// possible duplicate once we reach the bottom
+		NodeBase *notGreater = NULL;
+
+		Stats::search();
+		parent = const_cast<NodeBase *>(&header);
+		left = true;
+		while (x != NULL) {
+			parent = x;
+			left = keyLess(key, keyOf(x));
+			if (left) {
+				x = x->left;
+			} else {
+				notGreater = x;
+				x = x->right;
+			}
 		}
+		if (notGreater != NULL && !keyLess(keyOf(notGreater), key))
+			return notGreater;
+		return NULL;
+	}
 
-		if (pt->data.first < root->data.first) {
-			root->left = insertBST(root->left, pt);
-			root->left->parent = root;
-		} else if (pt->data.first > root->data.first) {
-			root->right = insertBST(root->right, pt);
-			root->right->parent = root;
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	NodeBase* RBTree<Key, Value, Compare, Allocator, Augment, Stats>::linkNode(NodeBase *parent, bool left, NodeBase *pt) {
+		Stats::insertion();
+		pt->setParent(parent);
+		if (parent == &header) {
+			header.setParent(pt);
+			header.left = header.right = pt;
+		} else if (left) {
+			parent->left = pt;
+			if (parent == header.left)
+				header.left = pt;
 		} else {
-			// duplicate keys not allowed
-			return root;
+			parent->right = pt;
+			if (parent == header.right)
+				header.right = pt;
 		}
-		// fix violations of Red-Black Tree properties
-		fixViolation(root, pt);
-		return root;
+		if (nodeCount != unknownCount)
+			++nodeCount;
+		updatePath(pt);
+		fixViolation(pt);
+		return pt;
 	}
 
-	template <typename Key, typename Value>
-	Node<Key, Value>* RBTree<Key, Value>::minimum(Node<Key, Value> *root) {
-		if (root == NULL) {
-			return NULL;
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	ft::pair<typename RBTree<Key, Value, Compare, Allocator, Augment, Stats>::iterator, bool> RBTree<Key, Value, Compare, Allocator, Augment, Stats>::insert(const ft::pair<const Key, Value> &data) {
+		NodeBase *parent;
+		bool left;
+		NodeBase *found = findInsertPos(data.first, parent, left);
+
+		if (found != NULL)
+			return ft::pair<iterator, bool>(iterator(found), false);
+		return ft::pair<iterator, bool>(iterator(insertAt(parent, left, data)), true);
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	ft::pair<typename RBTree<Key, Value, Compare, Allocator, Augment, Stats>::iterator, bool> RBTree<Key, Value, Compare, Allocator, Augment, Stats>::insert(ft::pair<const Key, Value> &&data) {
+		NodeBase *parent;
+		bool left;
+		NodeBase *found = findInsertPos(data.first, parent, left);
+
+		if (found != NULL)
+			return ft::pair<iterator, bool>(iterator(found), false);
+		return ft::pair<iterator, bool>(iterator(insertAt(parent, left, std::move(data))), true);
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	template <typename... Args>
+	ft::pair<typename RBTree<Key, Value, Compare, Allocator, Augment, Stats>::iterator, bool> RBTree<Key, Value, Compare, Allocator, Augment, Stats>::emplace(Args&&... args) {
+		// the key is only known once the pair is built
+		Node<Key, Value, Augment> *node = createNode(std::forward<Args>(args)...);
+		NodeBase *parent;
+		bool left;
+		NodeBase *found = findInsertPos(node->data.first, parent, left);
+
+		if (found != NULL) {
+			destroyNode(node);
+			return ft::pair<iterator, bool>(iterator(found), false);
 		}
-		while (root->left != NULL) {
-			root = root->left;
+		return ft::pair<iterator, bool>(iterator(linkNode(parent, left, node)), true);
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	template <typename K, typename... Args>
+	ft::pair<typename RBTree<Key, Value, Compare, Allocator, Augment, Stats>::iterator, bool> RBTree<Key, Value, Compare, Allocator, Augment, Stats>::tryEmplace(K &&key, Args&&... args) {
+		NodeBase *parent;
+		bool left;
+		NodeBase *found = findInsertPos(key, parent, left);
+
+		if (found != NULL)
+			return ft::pair<iterator, bool>(iterator(found), false);
+		return ft::pair<iterator, bool>(iterator(insertAt(parent, left, std::piecewise_construct,
+			std::forward_as_tuple(std::forward<K>(key)), std::forward_as_tuple(std::forward<Args>(args)...))), true);
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	template <typename K, typename M>
+	ft::pair<typename RBTree<Key, Value, Compare, Allocator, Augment, Stats>::iterator, bool> RBTree<Key, Value, Compare, Allocator, Augment, Stats>::insertOrAssign(K &&key, M &&obj) {
+		NodeBase *parent;
+		bool left;
+		NodeBase *found = findInsertPos(key, parent, left);
+
+		if (found != NULL) {
+			static_cast<Node<Key, Value, Augment> *>(found)->data.second = std::forward<M>(obj);
+			// the policy data may depend on the value
+			updatePath(found);
+			return ft::pair<iterator, bool>(iterator(found), false);
 		}
-		return root;
+		return ft::pair<iterator, bool>(iterator(insertAt(parent, left, std::forward<K>(key), std::forward<M>(obj))), true);
 	}
 
-	template <typename Key, typename Value>
-	Node<Key, Value>* RBTree<Key, Value>::maximum(Node<Key, Value> *root) {
-		// if the root is null, return null
-		if (!root) return NULL;
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	template <typename Pair>
+	typename RBTree<Key, Value, Compare, Allocator, Augment, Stats>::iterator RBTree<Key, Value, Compare, Allocator, Augment, Stats>::insertHint(iterator hint, Pair &&data) {
+		NodeBase *pos = hint.current;
+		const Key &key = data.first;
+
+		if (pos == &header) {
+			// hint is end(): appending after the largest key
+			if (header.parent() != NULL && keyLess(keyOf(header.right), key))
+				return iterator(insertAt(header.right, false, std::forward<Pair>(data)));
+		} else if (keyLess(key, keyOf(pos))) {
+			// key goes before hint, check it also goes after its predecessor
+			if (pos == header.left)
+				return iterator(insertAt(pos, true, std::forward<Pair>(data)));
+			NodeBase *before = treeDecrement(pos);
+			if (keyLess(keyOf(before), key)) {
+				if (before->right == NULL)
+					return iterator(insertAt(before, false, std::forward<Pair>(data)));
+				return iterator(insertAt(pos, true, std::forward<Pair>(data)));
+			}
+		} else if (keyLess(keyOf(pos), key)) {
+			// key goes after hint, check it also goes before its successor
+			if (pos == header.right)
+				return iterator(insertAt(pos, false, std::forward<Pair>(data)));
+			NodeBase *after = treeIncrement(pos);
+			if (keyLess(key, keyOf(after))) {
+				if (pos->right == NULL)
+					return iterator(insertAt(pos, false, std::forward<Pair>(data)));
+				return iterator(insertAt(after, true, std::forward<Pair>(data)));
+			}
+		} else {
+			// hint already holds key
+			return hint;
+		}
+		// the hint was wrong, fall back to a full descent
+		return insert(std::forward<Pair>(data)).first;
+	}
 
-		// traverse to the right child of the root
-		// while there is a right child
-		while (root->right != NULL) {
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	template <typename... Args>
+	Node<Key, Value, Augment>* RBTree<Key, Value, Compare, Allocator, Augment, Stats>::createNode(Args&&... args) {
+		Node<Key, Value, Augment> *node = pool.allocate();
+		Stats::allocation(1);
+		try {
+			::new (static_cast<void *>(node)) Node<Key, Value, Augment>(std::forward<Args>(args)...);
+		} catch (...) {
+			pool.deallocate(node);
+			throw;
+		}
+		return node;
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	void RBTree<Key, Value, Compare, Allocator, Augment, Stats>::destroyNode(Node<Key, Value, Augment> *node) {
+		node->~Node();
+		pool.deallocate(node);
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	template <typename K>
+	Node<Key, Value, Augment>* RBTree<Key, Value, Compare, Allocator, Augment, Stats>::searchBST(NodeBase *root, const K &key) const {
+		// one comparison per level: remember the last node not less than
+		// key and check it for equality once at the bottom
+		NodeBase *candidate = NULL;
+
+		Stats::search();
+		while (root != NULL) {
+			if (!keyLess(keyOf(root), key)) {
+				candidate = root;
+				root = root->left;
+			} else {
 				root = root->right;
+			}
 		}
+		if (candidate == NULL || keyLess(key, keyOf(candidate)))
+			return NULL;
+		return static_cast<Node<Key, Value, Augment> *>(candidate);
+	}
 
-		// return the node with the maximum key
-		return root;
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	template <typename Result, typename ForwardIterator, typename OutputIterator>
+	OutputIterator RBTree<Key, Value, Compare, Allocator, Augment, Stats>::findBatch(ForwardIterator first, ForwardIterator last, OutputIterator out) const {
+		ForwardIterator keys[batchLanes];
+		NodeBase *cursor[batchLanes];
+		NodeBase *candidate[batchLanes];
+		NodeBase *end = const_cast<NodeBase *>(&header);
+
+		while (first != last) {
+			size_type lanes = 0;
+			for (; lanes < batchLanes && first != last; ++lanes, ++first) {
+				Stats::search();
+				keys[lanes] = first;
+				cursor[lanes] = header.parent();
+				candidate[lanes] = NULL;
+			}
+			// same walk as searchBST, one level of every lane per round
+			for (size_type active = lanes; active != 0; ) {
+				active = 0;
+				for (size_type i = 0; i < lanes; ++i) {
+					NodeBase *x = cursor[i];
+					if (x == NULL)
+						continue;
+					if (!keyLess(keyOf(x), *keys[i])) {
+						candidate[i] = x;
+						x = x->left;
+					} else {
+						x = x->right;
+					}
+					if (x != NULL) {
+						__builtin_prefetch(x);
+						++active;
+					}
+					cursor[i] = x;
+				}
+			}
+			for (size_type i = 0; i < lanes; ++i) {
+				if (candidate[i] == NULL || keyLess(*keys[i], keyOf(candidate[i])))
+					*out++ = Result(end);
+				else
+					*out++ = Result(candidate[i]);
+			}
+		}
+		return out;
 	}
 
-	template <typename Key, typename Value>
-	void RBTree<Key, Value>::insert(const ft::pair<const Key, Value> &data) {
-		Node<Key, Value> *pt = new Node<Key, Value>(data);
-		root = insertBST(root, pt);
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	template <typename K>
+	NodeBase* RBTree<Key, Value, Compare, Allocator, Augment, Stats>::lowerBound(const K &key) const {
+		NodeBase *x = header.parent();
+		NodeBase *result = const_cast<NodeBase *>(&header);
+
+		Stats::search();
+		while (x != NULL) {
+			if (!keyLess(keyOf(x), key)) {
+				result = x;
+				x = x->left;
+			} else {
+				x = x->right;
+			}
+		}
+		return result;
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	template <typename K>
+	NodeBase* RBTree<Key, Value, Compare, Allocator, Augment, Stats>::upperBound(const K &key) const {
+		NodeBase *x = header.parent();
+		NodeBase *result = const_cast<NodeBase *>(&header);
+
+		Stats::search();
+		while (x != NULL) {
+			if (keyLess(key, keyOf(x))) {
+				result = x;
+				x = x->left;
+			} else {
+				x = x->right;
+			}
+		}
+		return result;
+	}
 
-		fixViolation(root, pt);
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	typename RBTree<Key, Value, Compare, Allocator, Augment, Stats>::iterator RBTree<Key, Value, Compare, Allocator, Augment, Stats>::find(const Key &key) {
+		NodeBase *result = searchBST(header.parent(), key);
+		return iterator(result != NULL ? result : &header);
 	}
 
-	template <typename Key, typename Value>
-	Node<Key, Value>* RBTree<Key, Value>::searchBST(Node<Key, Value> *root, const Key &key) const {
-		if (root == NULL || root->data.first == key)
-			return root;
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	typename RBTree<Key, Value, Compare, Allocator, Augment, Stats>::const_iterator RBTree<Key, Value, Compare, Allocator, Augment, Stats>::find(const Key &key) const {
+		const NodeBase *result = searchBST(header.parent(), key);
+		return const_iterator(result != NULL ? result : &header);
+	}
 
-		if (root->data.first > key)
-			return searchBST(root->left, key);
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	ft::pair<typename RBTree<Key, Value, Compare, Allocator, Augment, Stats>::iterator, typename RBTree<Key, Value, Compare, Allocator, Augment, Stats>::iterator>
+	RBTree<Key, Value, Compare, Allocator, Augment, Stats>::equal_range(const Key &key) {
+		iterator first = lower_bound(key);
+		iterator last = first;
+		// keys are unique: the range is empty or holds exactly one node
+		if (last != end() && !keyLess(key, last->first))
+			++last;
+		return ft::pair<iterator, iterator>(first, last);
+	}
 
-		return searchBST(root->right, key);
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	ft::pair<typename RBTree<Key, Value, Compare, Allocator, Augment, Stats>::const_iterator, typename RBTree<Key, Value, Compare, Allocator, Augment, Stats>::const_iterator>
+	RBTree<Key, Value, Compare, Allocator, Augment, Stats>::equal_range(const Key &key) const {
+		const_iterator first = lower_bound(key);
+		const_iterator last = first;
+		if (last != end() && !keyLess(key, last->first))
+			++last;
+		return ft::pair<const_iterator, const_iterator>(first, last);
 	}
 
-	template <typename Key, typename Value>
-	Value& RBTree<Key, Value>::at(const Key &key){
-		Node<Key, Value> *result = searchBST(root, key);
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	Value& RBTree<Key, Value, Compare, Allocator, Augment, Stats>::at(const Key &key){
+		static_assert(!Augment::folds_values, "the policy folds the values, change them with update()");
+		Node<Key, Value, Augment> *result = searchBST(header.parent(), key);
 		if (result == NULL) {
 			throw std::out_of_range("Key notfound");
 		}
 		return result->data.second;
 	}
 
-	template <typename Key, typename Value>
-	const Value& RBTree<Key, Value>::at(const Key &key) const {
-		Node<Key, Value> *result = searchBST(root, key);
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	template <typename Function>
+	bool RBTree<Key, Value, Compare, Allocator, Augment, Stats>::update(const Key &key, Function fn) {
+		Node<Key, Value, Augment> *x = searchBST(header.parent(), key);
+		if (x == NULL)
+			return false;
+		fn(x->data);
+		updatePath(x);
+		return true;
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	const Value& RBTree<Key, Value, Compare, Allocator, Augment, Stats>::at(const Key &key) const {
+		Node<Key, Value, Augment> *result = searchBST(header.parent(), key);
 		if (result == NULL) {
 			throw std::out_of_range("Key not found");
 		}
 		return result->data.second;
 	}
 
-	template <typename Key, typename Value>
-	bool RBTree<Key, Value>::contains(const Key &key) const {
-		return searchBST(root, key) != NULL;
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	bool RBTree<Key, Value, Compare, Allocator, Augment, Stats>::contains(const Key &key) const {
+		return searchBST(header.parent(), key) != NULL;
 	}
 
-	template <typename Key, typename Value>
-	Value& RBTree<Key, Value>::operator[](const Key &key) {
-		Node<Key, Value> *result = searchBST(root, key);
-		if (result == NULL) {
-			insert(ft::make_pair(key, Value()));
-			result = searchBST(root, key);
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	void RBTree<Key, Value, Compare, Allocator, Augment, Stats>::clear() {
+		// trivially destructible payloads don't need a walk, the chunks
+		// are returned to the allocator in one go
+		if (!std::is_trivially_destructible<ft::pair<const Key, Value> >::value) {
+			if (size() < parallelMin)
+				clearHelper(header.parent());
+			else
+				clearParallel(header.parent(), 0, thread_pool::shared());
 		}
-		return result->data.second;
+		resetHeader();
+		nodeCount = 0;
+		pool.release();
 	}
 
-	template <typename Key, typename Value>
-	void RBTree<Key, Value>::clear() {
-		clearHelper(root);
-		root = NULL;
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	void RBTree<Key, Value, Compare, Allocator, Augment, Stats>::clear(thread_pool &workers) {
+		if (!std::is_trivially_destructible<ft::pair<const Key, Value> >::value)
+			clearParallel(header.parent(), 0, workers);
+		resetHeader();
+		nodeCount = 0;
+		pool.release();
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	void RBTree<Key, Value, Compare, Allocator, Augment, Stats>::clearParallel(NodeBase *root, size_type depth, thread_pool &workers) {
+		if (root == NULL)
+			return;
+		if (depth >= forkDepth(workers)) {
+			clearHelper(root);
+			return;
+		}
+		workers.invoke(
+			[&] { clearParallel(root->left, depth + 1, workers); },
+			[&] { clearParallel(root->right, depth + 1, workers); });
+		static_cast<Node<Key, Value, Augment> *>(root)->~Node();
 	}
 
-	template <typename Key, typename Value>
-	void RBTree<Key, Value>::clearHelper(Node<Key, Value> *node) {
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	template <typename Function>
+	void RBTree<Key, Value, Compare, Allocator, Augment, Stats>::forEachHelper(NodeBase *x, Function &fn, size_type depth, thread_pool &workers, bool refresh) {
+		if (x == NULL)
+			return;
+		if (depth < forkDepth(workers)) {
+			workers.invoke(
+				[&] { forEachHelper(x->left, fn, depth + 1, workers, refresh); },
+				[&] { forEachHelper(x->right, fn, depth + 1, workers, refresh); });
+			fn(static_cast<Node<Key, Value, Augment> *>(x)->data);
+		} else {
+			forEachHelper(x->left, fn, depth + 1, workers, refresh);
+			fn(static_cast<Node<Key, Value, Augment> *>(x)->data);
+			forEachHelper(x->right, fn, depth + 1, workers, refresh);
+		}
+		// both subtrees are done
+		if (refresh)
+			updateNode(x);
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	void RBTree<Key, Value, Compare, Allocator, Augment, Stats>::clearHelper(NodeBase *node) {
 		if (node == NULL) return;
 		clearHelper(node->left);
 		clearHelper(node->right);
-		delete node;
+		static_cast<Node<Key, Value, Augment> *>(node)->~Node();
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	template <typename InputIterator>
+	void RBTree<Key, Value, Compare, Allocator, Augment, Stats>::assign_sorted(InputIterator first, InputIterator last) {
+		clear();
+		assignRange(first, last, typename std::iterator_traits<InputIterator>::iterator_category());
 	}
 
-	template <class Key, class Value>
-	void RBTree<Key, Value>::inorder() {
-		inorderHelper(root);
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	template <typename InputIterator>
+	void RBTree<Key, Value, Compare, Allocator, Augment, Stats>::assignRange(InputIterator first, InputIterator last, std::input_iterator_tag) {
+		for (; first != last; ++first)
+			insert(end(), *first);
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	template <typename ForwardIterator>
+	void RBTree<Key, Value, Compare, Allocator, Augment, Stats>::assignRange(ForwardIterator first, ForwardIterator last, std::forward_iterator_tag) {
+		// count the range and check the keys are strictly increasing
+		size_type n = 0;
+		bool sorted = true;
+		for (ForwardIterator prev = first, it = first; it != last; prev = it++, ++n) {
+			if (n != 0 && !keyLess((*prev).first, (*it).first)) {
+				sorted = false;
+				break;
+			}
+		}
+		if (!sorted) {
+			assignRange(first, last, std::input_iterator_tag());
+			return;
+		}
+		if (n == 0)
+			return;
+
+		pool.reserve(n);
+		try {
+			header.setParent(buildSorted(first, n, 0, redDepthOf(n), &header));
+		} catch (...) {
+			resetHeader();
+			pool.release();
+			throw;
+		}
+		header.left = treeMinimum(header.parent());
+		header.right = treeMaximum(header.parent());
+		nodeCount = n;
 	}
 
-	template <typename Key, typename Value>
-	void RBTree<Key, Value>::inorderHelper(Node<Key, Value> *root) {
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	typename RBTree<Key, Value, Compare, Allocator, Augment, Stats>::size_type RBTree<Key, Value, Compare, Allocator, Augment, Stats>::redDepthOf(size_type n) {
+		// the bottom level of a tree of n nodes built by halving is full only
+		// when n + 1 is a power of two, otherwise its nodes are colored red so
+		// that every path holds the same number of black nodes
+		size_type deepest = 0;
+		while ((static_cast<size_type>(2) << deepest) <= n)
+			++deepest;
+		return ((n & (n + 1)) == 0) ? deepest + 1 : deepest;
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	template <typename InputIterator>
+	void RBTree<Key, Value, Compare, Allocator, Augment, Stats>::assignParallel(InputIterator first, InputIterator last, thread_pool &, std::input_iterator_tag) {
+		assignRange(first, last, typename std::iterator_traits<InputIterator>::iterator_category());
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	template <typename RandomAccessIterator>
+	void RBTree<Key, Value, Compare, Allocator, Augment, Stats>::assignParallel(RandomAccessIterator first, RandomAccessIterator last, thread_pool &workers, std::random_access_iterator_tag) {
+		size_type n = last - first;
+		for (size_type i = 1; i < n; ++i) {
+			if (!keyLess(first[i - 1].first, first[i].first)) {
+				assignRange(first, last, std::input_iterator_tag());
+				return;
+			}
+		}
+		if (n == 0)
+			return;
+
+		node_type *block = pool.allocate_block(n);
+		Stats::allocation(n);
+		NodeBase *root;
+		try {
+			root = buildBlock(first, n, 0, redDepthOf(n), block, workers);
+		} catch (...) {
+			resetHeader();
+			pool.release();
+			throw;
+		}
+		header.setParent(root);
+		root->setParent(&header);
+		header.left = treeMinimum(root);
+		header.right = treeMaximum(root);
+		nodeCount = n;
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	template <typename RandomAccessIterator>
+	NodeBase* RBTree<Key, Value, Compare, Allocator, Augment, Stats>::buildBlock(RandomAccessIterator first, size_type n, size_type depth, size_type redDepth, node_type *block, thread_pool &workers) {
+		if (n == 0)
+			return NULL;
+		size_type leftSize = n / 2;
+		RandomAccessIterator middle = first + leftSize;
+		node_type *rightBlock = pool_type::at(block, leftSize + 1);
+		NodeBase *left = NULL;
+		NodeBase *right = NULL;
+		// a half that threw destroyed what it built, the other one is
+		// destroyed here
+		if (depth < forkDepth(workers)) {
+			try {
+				workers.invoke(
+					[&] { left = buildBlock(first, leftSize, depth + 1, redDepth, block, workers); },
+					[&] { right = buildBlock(middle + 1, n - leftSize - 1, depth + 1, redDepth, rightBlock, workers); });
+			} catch (...) {
+				clearHelper(left);
+				clearHelper(right);
+				throw;
+			}
+		} else {
+			left = buildBlock(first, leftSize, depth + 1, redDepth, block, workers);
+			try {
+				right = buildBlock(middle + 1, n - leftSize - 1, depth + 1, redDepth, rightBlock, workers);
+			} catch (...) {
+				clearHelper(left);
+				throw;
+			}
+		}
+		node_type *node = pool_type::at(block, leftSize);
+		try {
+			::new (static_cast<void *>(node)) node_type(*middle);
+		} catch (...) {
+			clearHelper(left);
+			clearHelper(right);
+			throw;
+		}
+		node->setColor((depth == redDepth) ? RED : BLACK);
+		node->left = left;
+		node->right = right;
+		if (left != NULL)
+			left->setParent(node);
+		if (right != NULL)
+			right->setParent(node);
+		if (Augment::enabled)
+			updateNode(node);
+		return node;
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	template <typename ForwardIterator>
+	NodeBase* RBTree<Key, Value, Compare, Allocator, Augment, Stats>::buildSorted(ForwardIterator &first, size_type n, size_type depth, size_type redDepth, NodeBase *parent) {
+		if (n == 0)
+			return NULL;
+		// in-order: the left half consumes the range first, then the middle
+		// element becomes this node, then the right half
+		size_type leftSize = n / 2;
+		NodeBase *left = buildSorted(first, leftSize, depth + 1, redDepth, NULL);
+		NodeBase *node;
+		try {
+			node = createNode(*first);
+		} catch (...) {
+			clearHelper(left);
+			throw;
+		}
+		++first;
+		node->setColor((depth == redDepth) ? RED : BLACK);
+		node->setParent(parent);
+		node->left = left;
+		if (left != NULL)
+			left->setParent(node);
+		try {
+			node->right = buildSorted(first, n - leftSize - 1, depth + 1, redDepth, node);
+		} catch (...) {
+			clearHelper(node);
+			throw;
+		}
+		if (Augment::enabled)
+			updateNode(node);
+		return node;
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	void RBTree<Key, Value, Compare, Allocator, Augment, Stats>::inorder() {
+		inorderHelper(header.parent());
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	void RBTree<Key, Value, Compare, Allocator, Augment, Stats>::inorderHelper(NodeBase *root) {
 			if (root != NULL) {
 				inorderHelper(root->left);
-				std::cout << "key: " << root->data.first << " value: " << root->data.second << std::endl;
+				Node<Key, Value, Augment> *node = static_cast<Node<Key, Value, Augment> *>(root);
+				std::cout << "key: " << node->data.first << " value: " << node->data.second << std::endl;
 				inorderHelper(root->right);
 			}
 	}
 
-	template <typename Key, typename Value>
-	void RBTree<Key, Value>::fixDoubleBlack(Node<Key, Value> *&root, Node<Key, Value> *&x, Node<Key, Value> *&parent) {
-			if (x == root) {
-				// if x is the root, it is no longer double black
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	bool RBTree<Key, Value, Compare, Allocator, Augment, Stats>::validate() const {
+		const NodeBase *root = header.parent();
+		if (root == NULL)
+			return header.left == &header && header.right == &header && (nodeCount == unknownCount || nodeCount == 0);
+		if (root->parent() != &header || root->color() != BLACK)
+			return false;
+		if (header.left != treeMinimum(const_cast<NodeBase *>(root)) || header.right != treeMaximum(const_cast<NodeBase *>(root)))
+			return false;
+		size_type blackHeight;
+		size_type count = 0;
+		if (!validateHelper(root, NULL, NULL, blackHeight, count))
+			return false;
+		return nodeCount == unknownCount || nodeCount == count;
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	bool RBTree<Key, Value, Compare, Allocator, Augment, Stats>::validateHelper(const NodeBase *x, const NodeBase *lo, const NodeBase *hi, size_type &blackHeight, size_type &count) const {
+		if (x == NULL) {
+			blackHeight = 0;
+			return true;
+		}
+		// straight to the comparator, a check isn't counted by Stats
+		if ((lo != NULL && !this->compare()(keyOf(lo), keyOf(x))) || (hi != NULL && !this->compare()(keyOf(x), keyOf(hi))))
+			return false;
+		if ((x->left != NULL && x->left->parent() != x) || (x->right != NULL && x->right->parent() != x))
+			return false;
+		if (x->color() == RED && ((x->left != NULL && x->left->color() == RED) || (x->right != NULL && x->right->color() == RED)))
+			return false;
+		size_type leftHeight;
+		size_type rightHeight;
+		if (!validateHelper(x->left, lo, x, leftHeight, count) || !validateHelper(x->right, x, hi, rightHeight, count) || leftHeight != rightHeight)
+			return false;
+		if (Augment::sized && subtreeSize(x) != 1 + subtreeSize(x->left) + subtreeSize(x->right))
+			return false;
+		++count;
+		blackHeight = leftHeight + (x->color() == BLACK);
+		return true;
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	void RBTree<Key, Value, Compare, Allocator, Augment, Stats>::fixDoubleBlack(NodeBase *x, NodeBase *parent) {
+			Stats::double_black();
+			if (x == header.parent() || (x != NULL && x->color() == RED)) {
+				// a red node or the root simply absorbs the extra black
+				if (x != NULL)
+					x->setColor(BLACK);
 				return;
 			}
 
-			Node<Key, Value> *sibling = (parent->left == x) ? parent->right : parent->left;
-
-			if (sibling == NULL) {
-				// if x has no sibling, it is no longer double black
+			// x may be NULL (a black leaf), so the side is taken from the parent
+			bool xIsLeft = (parent->left == x);
+			NodeBase *sibling = xIsLeft ? parent->right : parent->left;
+
+			if (sibling->color() == RED) {
+				// if the sibling is red, rotate it above the parent so
+				// that x gets a black sibling
+				parent->setColor(RED);
+				sibling->setColor(BLACK);
+				if (xIsLeft) {
+					rotateLeft(parent);
+				} else {
+					rotateRight(parent);
+				}
+				fixDoubleBlack(x, parent);
 				return;
 			}
 
-			if (sibling->color == RED) {
-				// if the sibling is red, we perform a rotation
-				parent->color = RED;
-				sibling->color = BLACK;
-				if (parent->left == x) {
-					rotateRight(root, parent);
+			NodeBase *nearChild = xIsLeft ? sibling->left : sibling->right;
+			NodeBase *farChild = xIsLeft ? sibling->right : sibling->left;
+
+			if (farChild != NULL && farChild->color() == RED) {
+				// the far child of the sibling is red: one rotation at the parent
+				// moves the extra black over and we are done
+				sibling->setColor(parent->color());
+				parent->setColor(BLACK);
+				farChild->setColor(BLACK);
+				if (xIsLeft) {
+					rotateLeft(parent);
+				} else {
+					rotateRight(parent);
+				}
+			} else if (nearChild != NULL && nearChild->color() == RED) {
+				// only the near child is red: rotate it above the sibling
+				// so it becomes the far child case
+				nearChild->setColor(BLACK);
+				sibling->setColor(RED);
+				if (xIsLeft) {
+					rotateRight(sibling);
 				} else {
-					rotateLeft(root, parent);
+					rotateLeft(sibling);
 				}
-				fixDoubleBlack(root, x, parent);
+				fixDoubleBlack(x, parent);
 			} else {
-				// if the sibling is black, we check its children
-				if (sibling->left != NULL && sibling->left->color == RED) {
-					if (sibling->right != NULL && sibling->right->color == RED) {
-						// if both children of the sibling are red
-						sibling->color = RED;
-						sibling->left->color = BLACK;
-						sibling->right->color = BLACK;
-						fixDoubleBlack(root, parent, parent->parent);
-					} else {
-						if (parent->left == x) {
-							// if the left child of the sibling is red, we perform a rotation
-							sibling->left->color = BLACK;
-							sibling->color = RED;
-							rotateLeft(root, sibling);
-							fixDoubleBlack(root, x, parent);
-						} else {
-							// if the right child of the sibling is red, we perform a rotation
-							sibling->right->color = BLACK;
-							sibling->color = RED;
-							rotateRight(root, sibling);
-							fixDoubleBlack(root, x, parent);
-						}
-					}
-				} else if (sibling->right != NULL && sibling->right->color == RED) {
-					if (parent->left == x) {
-						// if the right child of the sibling is red, we perform a rotation
-						sibling->right->color = BLACK;
-						sibling->color = RED;
-						rotateRight(root, sibling);
-						fixDoubleBlack(root, x, parent);
-					} else {
-						// if the left child of the sibling is red, we perform a rotation
-						sibling->left->color = BLACK;
-						sibling->color = RED;
-						rotateLeft(root, sibling);
-						fixDoubleBlack(root, x, parent);
-					}
+				// if the sibling has no red children, push the extra black up
+				sibling->setColor(RED);
+				if (parent->color() == BLACK) {
+					fixDoubleBlack(parent, parent->parent());
 				} else {
-					// if the sibling has no red children
-					sibling->color = RED;
-					if (parent->color == BLACK) {
-							fixDoubleBlack(root, parent, parent->parent);
-					} else {
-							parent->color = BLACK;
-					}
+					parent->setColor(BLACK);
 				}
 			}
 	}
 
-	template <typename Key, typename Value>
-	void RBTree<Key, Value>::remove(const Key &key) {
-			Node<Key, Value> *z = searchBST(root, key);
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	typename RBTree<Key, Value, Compare, Allocator, Augment, Stats>::size_type RBTree<Key, Value, Compare, Allocator, Augment, Stats>::remove(const Key &key) {
+			Node<Key, Value, Augment> *z = searchBST(header.parent(), key);
 			if (z == NULL) {
-					return;
+					return 0;
 			}
-			Node<Key, Value> *x;
-			Node<Key, Value> *y = z;
-			Color originalColor = y->color;
+			eraseNode(z);
+			return 1;
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	void RBTree<Key, Value, Compare, Allocator, Augment, Stats>::erase(const_iterator pos) {
+		eraseNode(const_cast<NodeBase *>(pos.current));
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	void RBTree<Key, Value, Compare, Allocator, Augment, Stats>::unlinkNode(NodeBase *z) {
+			// z has no left child if it is the leftmost node, its successor is
+			// then below on the right or its parent (and the mirror for rightmost),
+			// removing the last node leaves both pointing at the header
+			if (z == header.left)
+				header.left = (z->right != NULL) ? treeMinimum(z->right) : z->parent();
+			if (z == header.right)
+				header.right = (z->left != NULL) ? treeMaximum(z->left) : z->parent();
+			NodeBase *x;
+			NodeBase *xParent;
+			NodeBase *y = z;
+			Color originalColor = y->color();
 			if (z->left == NULL) {
 				x = z->right;
-				transplant(root, z, z->right);
+				xParent = z->parent();
+				transplant(z, z->right);
 			} else if (z->right == NULL) {
 				x = z->left;
-				transplant(root, z, z->left);
+				xParent = z->parent();
+				transplant(z, z->left);
 			} else {
-				y = minimum(z->right);
-				originalColor = y->color;
+				y = treeMinimum(z->right);
+				originalColor = y->color();
 				x = y->right;
-				if (y->parent == z) {
-						x->parent = y;
+				if (y->parent() == z) {
+					xParent = y;
 				} else {
-					transplant(root, y, y->right);
+					xParent = y->parent();
+					transplant(y, y->right);
 					y->right = z->right;
-					y->right->parent = y;
+					y->right->setParent(y);
 				}
-				transplant(root, z, y);
+				transplant(z, y);
 				y->left = z->left;
-				y->left->parent = y;
-				y->color = z->color;
+				y->left->setParent(y);
+				y->setColor(z->color());
 			}
+			// every subtree that lost a node hangs below xParent, the
+			// rotations done by fixDoubleBlack keep their nodes up to date
+			updatePath(xParent);
 			if (originalColor == BLACK) {
-				fixDoubleBlack(root, x, x->parent);
+				fixDoubleBlack(x, xParent);
 			}
-			delete z;
+			Stats::erasure();
+			if (nodeCount != unknownCount)
+				--nodeCount;
+			z->left = z->right = NULL;
+			z->setParent(NULL);
+			z->setColor(RED);
 	}
 
-	template <typename Key, typename Value>
-	void RBTree<Key, Value>::transplant(Node<Key, Value> *&root, Node<Key, Value> *u, Node<Key, Value> *v) {
-		if (u->parent == NULL) {
-			root = v;
-		} else if (u == u->parent->left) {
-			u->parent->left = v;
-		} else {
-			u->parent->right = v;
-		}
-		if (v != NULL) {
-			v->parent = u->parent;
-		}
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	typename RBTree<Key, Value, Compare, Allocator, Augment, Stats>::node_handle RBTree<Key, Value, Compare, Allocator, Augment, Stats>::extract(const_iterator pos) {
+		NodeBase *z = const_cast<NodeBase *>(pos.current);
+		unlinkNode(z);
+		return node_handle(static_cast<Node<Key, Value, Augment> *>(z), pool.share());
 	}
 
-	template <typename Key, typename Value>
-	Node<Key, Value>* RBTree<Key, Value>::successor(Node<Key, Value> *root) {
-		// If the node has a right child, then its successor is the minimum key in its right subtree
-		if (root->right != NULL) {
-			return minimum(root->right);
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	typename RBTree<Key, Value, Compare, Allocator, Augment, Stats>::node_handle RBTree<Key, Value, Compare, Allocator, Augment, Stats>::extract(const Key &key) {
+		Node<Key, Value, Augment> *z = searchBST(header.parent(), key);
+		if (z == NULL)
+			return node_handle();
+		return extract(const_iterator(z));
+	}
+
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	typename RBTree<Key, Value, Compare, Allocator, Augment, Stats>::insert_return_type RBTree<Key, Value, Compare, Allocator, Augment, Stats>::insert(node_handle &&nh) {
+		insert_return_type result;
+		if (nh.empty()) {
+			result.position = end();
+			result.inserted = false;
+			return result;
+		}
+		NodeBase *parent;
+		bool left;
+		NodeBase *found = findInsertPos(nh.key(), parent, left);
+		if (found != NULL) {
+			result.position = iterator(found);
+			result.inserted = false;
+			result.node = std::move(nh);
+			return result;
 		}
+		// the node's storage is given back to this pool when it is erased
+		pool.adopt(nh.arena);
+		result.position = iterator(linkNode(parent, left, nh.node));
+		result.inserted = true;
+		nh.node = NULL;
+		nh.arena.reset();
+		return result;
+	}
 
-		// Otherwise, its successor is the lowest ancestor whose left child is also an ancestor of `root`
-		Node<Key, Value> *successor = root->parent;
-		while (successor != NULL && root == successor->right) {
-			root = successor;
-			successor = successor->parent;
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	void RBTree<Key, Value, Compare, Allocator, Augment, Stats>::merge(RBTree &other) {
+		if (&other == this || other.empty())
+			return;
+		pool.adopt(other.pool.share());
+		NodeBase *x = other.header.left;
+		while (x != &other.header) {
+			NodeBase *next = treeIncrement(x);
+			NodeBase *parent;
+			bool left;
+			if (findInsertPos(keyOf(x), parent, left) == NULL) {
+				other.unlinkNode(x);
+				linkNode(parent, left, x);
+			}
+			x = next;
 		}
-		return (successor);
 	}
 
-	template <typename Key, typename Value>
-	Node<Key, Value>* RBTree<Key, Value>::predecessor(Node<Key, Value> *root) {
-		// If the node has a left child, then its predecessor is the maximum key in its left subtree
-		if (root->left != NULL) {
-			return maximum(root->left);
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	void RBTree<Key, Value, Compare, Allocator, Augment, Stats>::transplant(NodeBase *u, NodeBase *v) {
+		replaceChild(u->parent(), u, v);
+		if (v != NULL) {
+			v->setParent(u->parent());
 		}
+	}
 
-		// Otherwise, its predecessor is the highest ancestor whose right child is also an ancestor of `root`
-		Node<Key, Value> *predecessor = root->parent;
-		while (predecessor != NULL && root == predecessor->left) {
-			root = predecessor;
-			predecessor = predecessor->parent;
+	template <typename Key, typename Value, typename Compare, typename Allocator, typename Augment, typename Stats>
+	void RBTree<Key, Value, Compare, Allocator, Augment, Stats>::replaceChild(NodeBase *parent, NodeBase *oldChild, NodeBase *newChild) {
+		// the root hangs below the header through its parent link, the
+		// header's left/right are the leftmost/rightmost nodes, not children
+		if (parent == &header) {
+			header.setParent(newChild);
+		} else if (oldChild == parent->left) {
+			parent->left = newChild;
+		} else {
+			parent->right = newChild;
 		}
-		return predecessor;
 	}
-}
\ No newline at end of file
+}
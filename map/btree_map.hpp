@@ -0,0 +1,183 @@
+#pragma once
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include "./pair.hpp"
+#include "./BTree.hpp"
+
+namespace ft {
+
+	// ft::map on a B+ tree: same interface, but elements are stored in
+	// wide contiguous nodes, which makes lookups and scans of large maps
+	// cheaper in cache misses. inserting and erasing invalidate iterators,
+	// erase(position) returns the iterator to the next element instead.
+	template<
+			class Key,
+			class T,
+			class Compare = std::less<Key>,
+			class Allocator = std::allocator<ft::pair<const Key, T> >,
+			std::size_t NodeSize = 256
+			>
+	class btree_map {
+		public:
+			typedef Key key_type;
+			typedef T mapped_type;
+			typedef ft::pair<const key_type, mapped_type> value_type;
+			typedef Compare key_compare;
+			typedef Allocator allocator_type;
+			typedef value_type& reference;
+			typedef const value_type& const_reference;
+			typedef typename std::allocator_traits<allocator_type>::pointer pointer;
+			typedef typename std::allocator_traits<allocator_type>::const_pointer const_pointer;
+			typedef std::ptrdiff_t difference_type;
+			typedef std::size_t size_type;
+
+		class value_compare {
+			friend class btree_map;
+			protected:
+				Compare comp;
+				value_compare(Compare c) : comp(c) {}
+			public:
+				typedef bool result_type;
+				typedef value_type first_argument_type;
+				typedef value_type second_argument_type;
+				bool operator()(const value_type& x, const value_type& y) const {
+					return comp(x.first, y.first);
+				}
+		};
+
+		private:
+			typedef ft::BTree<key_type, value_type, ft::select_first<key_type>, key_compare, allocator_type, NodeSize> rep_type;
+			rep_type t;
+
+		public:
+			typedef typename rep_type::iterator iterator;
+			typedef typename rep_type::const_iterator const_iterator;
+			typedef typename rep_type::reverse_iterator reverse_iterator;
+			typedef typename rep_type::const_reverse_iterator const_reverse_iterator;
+
+			// constructors
+			explicit btree_map(const key_compare& comp = key_compare(), const allocator_type& alloc = allocator_type()) : t(comp, alloc) {}
+			template <class InputIterator>
+			btree_map(InputIterator first, InputIterator last, const key_compare& comp = key_compare(), const allocator_type& alloc = allocator_type()) : t(comp, alloc) {
+				insert(first, last);
+			}
+			btree_map(const btree_map& x) : t(x.t) {}
+
+			// destructor
+			~btree_map() {}
+
+			// operators
+			btree_map& operator=(const btree_map& x) {
+				t = x.t;
+				return *this;
+			}
+
+			// iterators
+			iterator begin() { return t.begin(); }
+			iterator end() { return t.end(); }
+			const_iterator begin() const { return t.begin(); }
+			const_iterator end() const { return t.end(); }
+			reverse_iterator rbegin() { return t.rbegin(); }
+			reverse_iterator rend() { return t.rend(); }
+			const_reverse_iterator rbegin() const { return t.rbegin(); }
+			const_reverse_iterator rend() const { return t.rend(); }
+
+			// capacity
+			bool empty() const { return t.empty(); }
+			size_type size() const { return t.size(); }
+			size_type max_size() const { return t.max_size(); }
+
+			// element access
+			mapped_type& operator[](const key_type& k) { return t.insert(value_type(k, mapped_type())).first->second; }
+			mapped_type& at(const key_type& k) {
+				iterator it = t.find(k);
+				if (it == t.end())
+					throw std::out_of_range("Key not found");
+				return it->second;
+			}
+			const mapped_type& at(const key_type& k) const {
+				const_iterator it = t.find(k);
+				if (it == t.end())
+					throw std::out_of_range("Key not found");
+				return it->second;
+			}
+
+			// modifiers
+			ft::pair<iterator, bool> insert(const value_type& x) { return t.insert(x); }
+			iterator insert(const_iterator position, const value_type& x) { return t.insert(position, x); }
+			template <class InputIterator>
+			void insert(InputIterator first, InputIterator last) {
+				// hinting at end() makes sorted input amortized O(1) per element
+				for (; first != last; ++first)
+					t.insert(t.end(), *first);
+			}
+			iterator erase(const_iterator position) { return t.erase(position); }
+			size_type erase(const key_type& x) { return t.remove(x); }
+			iterator erase(const_iterator first, const_iterator last) { return t.erase(first, last); }
+			void swap(btree_map& x) { t.swap(x.t); }
+			// replace the contents, O(n) when the range is sorted by key
+			template <class InputIterator>
+			void assign_sorted(InputIterator first, InputIterator last) {
+				t.clear();
+				insert(first, last);
+			}
+			void clear() { t.clear(); }
+
+			// observers
+			key_compare key_comp() const { return t.key_comp(); }
+			value_compare value_comp() const { return value_compare(t.key_comp()); }
+
+			// operations
+			iterator find(const key_type& x) { return t.find(x); }
+			const_iterator find(const key_type& x) const { return t.find(x); }
+			size_type count(const key_type& x) const { return t.contains(x) ? 1 : 0; }
+			bool contains(const key_type& x) const { return t.contains(x); }
+			iterator lower_bound(const key_type& x) { return t.lower_bound(x); }
+			const_iterator lower_bound(const key_type& x) const { return t.lower_bound(x); }
+			iterator upper_bound(const key_type& x) { return t.upper_bound(x); }
+			const_iterator upper_bound(const key_type& x) const { return t.upper_bound(x); }
+			ft::pair<iterator, iterator> equal_range(const key_type& x) { return ft::pair<iterator, iterator>(t.lower_bound(x), t.upper_bound(x)); }
+			ft::pair<const_iterator, const_iterator> equal_range(const key_type& x) const { return ft::pair<const_iterator, const_iterator>(t.lower_bound(x), t.upper_bound(x)); }
+
+			// allocator
+			allocator_type get_allocator() const { return t.get_allocator(); }
+	};
+
+	template <class Key, class T, class Compare, class Allocator, std::size_t NodeSize>
+	bool operator==(const btree_map<Key, T, Compare, Allocator, NodeSize> &lhs, const btree_map<Key, T, Compare, Allocator, NodeSize> &rhs) {
+		return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+	}
+
+	template <class Key, class T, class Compare, class Allocator, std::size_t NodeSize>
+	bool operator!=(const btree_map<Key, T, Compare, Allocator, NodeSize> &lhs, const btree_map<Key, T, Compare, Allocator, NodeSize> &rhs) {
+		return !(lhs == rhs);
+	}
+
+	template <class Key, class T, class Compare, class Allocator, std::size_t NodeSize>
+	bool operator<(const btree_map<Key, T, Compare, Allocator, NodeSize> &lhs, const btree_map<Key, T, Compare, Allocator, NodeSize> &rhs) {
+		return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+	}
+
+	template <class Key, class T, class Compare, class Allocator, std::size_t NodeSize>
+	bool operator<=(const btree_map<Key, T, Compare, Allocator, NodeSize> &lhs, const btree_map<Key, T, Compare, Allocator, NodeSize> &rhs) {
+		return !(rhs < lhs);
+	}
+
+	template <class Key, class T, class Compare, class Allocator, std::size_t NodeSize>
+	bool operator>(const btree_map<Key, T, Compare, Allocator, NodeSize> &lhs, const btree_map<Key, T, Compare, Allocator, NodeSize> &rhs) {
+		return rhs < lhs;
+	}
+
+	template <class Key, class T, class Compare, class Allocator, std::size_t NodeSize>
+	bool operator>=(const btree_map<Key, T, Compare, Allocator, NodeSize> &lhs, const btree_map<Key, T, Compare, Allocator, NodeSize> &rhs) {
+		return !(lhs < rhs);
+	}
+
+	template <class Key, class T, class Compare, class Allocator, std::size_t NodeSize>
+	void swap(btree_map<Key, T, Compare, Allocator, NodeSize> &lhs, btree_map<Key, T, Compare, Allocator, NodeSize> &rhs) {
+		lhs.swap(rhs);
+	}
+}
@@ -0,0 +1,140 @@
+#pragma once
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include "./pair.hpp"
+#include "./BTree.hpp"
+
+namespace ft {
+
+	// set of unique keys on a B+ tree, the keys are stored contiguously in
+	// the leaves. inserting and erasing invalidate iterators, erase(position)
+	// returns the iterator to the next key instead.
+	template<
+			class Key,
+			class Compare = std::less<Key>,
+			class Allocator = std::allocator<Key>,
+			std::size_t NodeSize = 256
+			>
+	class btree_set {
+		public:
+			typedef Key key_type;
+			typedef Key value_type;
+			typedef Compare key_compare;
+			typedef Compare value_compare;
+			typedef Allocator allocator_type;
+			typedef value_type& reference;
+			typedef const value_type& const_reference;
+			typedef typename std::allocator_traits<allocator_type>::pointer pointer;
+			typedef typename std::allocator_traits<allocator_type>::const_pointer const_pointer;
+			typedef std::ptrdiff_t difference_type;
+			typedef std::size_t size_type;
+
+		private:
+			typedef ft::BTree<key_type, value_type, ft::identity_key<key_type>, key_compare, allocator_type, NodeSize> rep_type;
+			rep_type t;
+
+		public:
+			// keys can't be changed in place, both iterators are constant
+			typedef typename rep_type::const_iterator iterator;
+			typedef typename rep_type::const_iterator const_iterator;
+			typedef typename rep_type::const_reverse_iterator reverse_iterator;
+			typedef typename rep_type::const_reverse_iterator const_reverse_iterator;
+
+			// constructors
+			explicit btree_set(const key_compare& comp = key_compare(), const allocator_type& alloc = allocator_type()) : t(comp, alloc) {}
+			template <class InputIterator>
+			btree_set(InputIterator first, InputIterator last, const key_compare& comp = key_compare(), const allocator_type& alloc = allocator_type()) : t(comp, alloc) {
+				insert(first, last);
+			}
+			btree_set(const btree_set& x) : t(x.t) {}
+
+			// destructor
+			~btree_set() {}
+
+			// operators
+			btree_set& operator=(const btree_set& x) {
+				t = x.t;
+				return *this;
+			}
+
+			// iterators
+			iterator begin() const { return t.begin(); }
+			iterator end() const { return t.end(); }
+			reverse_iterator rbegin() const { return t.rbegin(); }
+			reverse_iterator rend() const { return t.rend(); }
+
+			// capacity
+			bool empty() const { return t.empty(); }
+			size_type size() const { return t.size(); }
+			size_type max_size() const { return t.max_size(); }
+
+			// modifiers
+			ft::pair<iterator, bool> insert(const value_type& x) {
+				ft::pair<typename rep_type::iterator, bool> r = t.insert(x);
+				return ft::pair<iterator, bool>(r.first, r.second);
+			}
+			iterator insert(const_iterator position, const value_type& x) { return t.insert(position, x); }
+			template <class InputIterator>
+			void insert(InputIterator first, InputIterator last) {
+				// hinting at end() makes sorted input amortized O(1) per element
+				for (; first != last; ++first)
+					t.insert(t.end(), *first);
+			}
+			iterator erase(const_iterator position) { return t.erase(position); }
+			size_type erase(const key_type& x) { return t.remove(x); }
+			iterator erase(const_iterator first, const_iterator last) { return t.erase(first, last); }
+			void swap(btree_set& x) { t.swap(x.t); }
+			void clear() { t.clear(); }
+
+			// observers
+			key_compare key_comp() const { return t.key_comp(); }
+			value_compare value_comp() const { return t.key_comp(); }
+
+			// operations
+			iterator find(const key_type& x) const { return t.find(x); }
+			size_type count(const key_type& x) const { return t.contains(x) ? 1 : 0; }
+			bool contains(const key_type& x) const { return t.contains(x); }
+			iterator lower_bound(const key_type& x) const { return t.lower_bound(x); }
+			iterator upper_bound(const key_type& x) const { return t.upper_bound(x); }
+			ft::pair<iterator, iterator> equal_range(const key_type& x) const { return ft::pair<iterator, iterator>(t.lower_bound(x), t.upper_bound(x)); }
+
+			// allocator
+			allocator_type get_allocator() const { return t.get_allocator(); }
+	};
+
+	template <class Key, class Compare, class Allocator, std::size_t NodeSize>
+	bool operator==(const btree_set<Key, Compare, Allocator, NodeSize> &lhs, const btree_set<Key, Compare, Allocator, NodeSize> &rhs) {
+		return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+	}
+
+	template <class Key, class Compare, class Allocator, std::size_t NodeSize>
+	bool operator!=(const btree_set<Key, Compare, Allocator, NodeSize> &lhs, const btree_set<Key, Compare, Allocator, NodeSize> &rhs) {
+		return !(lhs == rhs);
+	}
+
+	template <class Key, class Compare, class Allocator, std::size_t NodeSize>
+	bool operator<(const btree_set<Key, Compare, Allocator, NodeSize> &lhs, const btree_set<Key, Compare, Allocator, NodeSize> &rhs) {
+		return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+	}
+
+	template <class Key, class Compare, class Allocator, std::size_t NodeSize>
+	bool operator<=(const btree_set<Key, Compare, Allocator, NodeSize> &lhs, const btree_set<Key, Compare, Allocator, NodeSize> &rhs) {
+		return !(rhs < lhs);
+	}
+
+	template <class Key, class Compare, class Allocator, std::size_t NodeSize>
+	bool operator>(const btree_set<Key, Compare, Allocator, NodeSize> &lhs, const btree_set<Key, Compare, Allocator, NodeSize> &rhs) {
+		return rhs < lhs;
+	}
+
+	template <class Key, class Compare, class Allocator, std::size_t NodeSize>
+	bool operator>=(const btree_set<Key, Compare, Allocator, NodeSize> &lhs, const btree_set<Key, Compare, Allocator, NodeSize> &rhs) {
+		return !(lhs < rhs);
+	}
+
+	template <class Key, class Compare, class Allocator, std::size_t NodeSize>
+	void swap(btree_set<Key, Compare, Allocator, NodeSize> &lhs, btree_set<Key, Compare, Allocator, NodeSize> &rhs) {
+		lhs.swap(rhs);
+	}
+}
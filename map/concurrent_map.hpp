@@ -0,0 +1,284 @@
+#pragma once
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <vector>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <cstdint>
+#include "./pair.hpp"
+#include "./map.hpp"
+#include "./thread_pool.hpp"
+
+namespace ft {
+
+	// map for many threads at once, the keys are spread over shards that
+	// are each an ft::map behind a reader-writer lock, so that threads
+	// working on different shards don't wait for each other. by default a
+	// key goes to the shard its hash picks; given splitters, shard i holds
+	// the keys from splitters[i - 1] up to splitters[i], which keeps ranges
+	// together.
+	//
+	// every operation locks one shard, so the elements are handed out by
+	// copy or to a function called under the lock, never by reference.
+	// size() sees each shard at a different moment. the whole-map walks
+	// lock every shard, in index order and on the calling thread, so no
+	// task of a thread_pool ever waits for a shard lock; they must not be
+	// called from such a task either.
+	template<
+			class Key,
+			class T,
+			class Compare = std::less<Key>,
+			class Allocator = std::allocator<ft::pair<const Key, T> >,
+			class Hash = std::hash<Key>
+			>
+	class concurrent_map {
+		public:
+			typedef Key key_type;
+			typedef T mapped_type;
+			typedef ft::pair<const key_type, mapped_type> value_type;
+			typedef Compare key_compare;
+			typedef Allocator allocator_type;
+			typedef Hash hasher;
+			typedef std::size_t size_type;
+			typedef ft::map<Key, T, Compare, Allocator> shard_type;
+
+		private:
+			// a shard per cache line or more, so that taking the lock of
+			// one doesn't invalidate the line holding its neighbour's
+			struct alignas(64) shard {
+				mutable std::shared_mutex lock;
+				shard_type map;
+
+				shard(const key_compare &comp, const allocator_type &alloc) : map(comp, alloc) {}
+			};
+
+			std::vector<std::unique_ptr<shard> > _shards;
+			std::vector<Key> _splitters;
+			key_compare _comp;
+			hasher _hash;
+
+			// shards to use when none are asked for: a few per hardware thread
+			static size_type defaultShards() {
+				size_type n = std::thread::hardware_concurrency();
+				return n == 0 ? 16 : 4 * n;
+			}
+
+			void makeShards(size_type n, const allocator_type &alloc) {
+				_shards.reserve(n);
+				for (size_type i = 0; i < n; ++i)
+					_shards.push_back(std::unique_ptr<shard>(new shard(_comp, alloc)));
+			}
+
+			size_type shardOf(const key_type &k) const {
+				if (!_splitters.empty())
+					return std::upper_bound(_splitters.begin(), _splitters.end(), k, _comp) - _splitters.begin();
+				// std::hash is often the identity, the multiply spreads
+				// consecutive keys over every shard
+				std::uint64_t h = static_cast<std::uint64_t>(_hash(k)) * 0x9e3779b97f4a7c15ull;
+				return static_cast<size_type>((h >> 32) % _shards.size());
+			}
+			shard& shardFor(const key_type &k) { return *_shards[shardOf(k)]; }
+			const shard& shardFor(const key_type &k) const { return *_shards[shardOf(k)]; }
+
+			// f(i) for every shard index in [first, last), forked on workers
+			template <typename Function>
+			void forkShards(size_type first, size_type last, Function &f, thread_pool &workers) const {
+				if (last - first == 1) {
+					f(first);
+					return;
+				}
+				size_type middle = first + (last - first) / 2;
+				workers.invoke(
+					[&] { forkShards(first, middle, f, workers); },
+					[&] { forkShards(middle, last, f, workers); });
+			}
+
+			// smallest current element of the k-way merge on top of the heap
+			struct cursor {
+				typename shard_type::const_iterator it;
+				typename shard_type::const_iterator end;
+			};
+			struct cursor_greater {
+				key_compare comp;
+				bool operator()(const cursor &a, const cursor &b) const { return comp(b.it->first, a.it->first); }
+			};
+
+			concurrent_map(const concurrent_map &);
+			concurrent_map &operator=(const concurrent_map &);
+
+		public:
+			// constructors
+			// hash partitioned into the given number of shards, 0 for a few per
+			// hardware thread
+			explicit concurrent_map(size_type shards = 0, const key_compare& comp = key_compare(), const allocator_type& alloc = allocator_type(), const hasher& hash = hasher())
+				: _comp(comp), _hash(hash) {
+				makeShards(shards == 0 ? defaultShards() : shards, alloc);
+			}
+			// range partitioned at the sorted splitters, one more shard than splitters
+			explicit concurrent_map(const std::vector<Key>& splitters, const key_compare& comp = key_compare(), const allocator_type& alloc = allocator_type())
+				: _splitters(splitters), _comp(comp), _hash() {
+				makeShards(splitters.size() + 1, alloc);
+			}
+
+			// destructor
+			~concurrent_map() {}
+
+			// capacity, sums of the shards
+			bool empty() const { return size() == 0; }
+			size_type size() const {
+				size_type n = 0;
+				for (size_type i = 0; i < _shards.size(); ++i) {
+					std::shared_lock<std::shared_mutex> guard(_shards[i]->lock);
+					n += _shards[i]->map.size();
+				}
+				return n;
+			}
+			size_type shard_count() const { return _shards.size(); }
+
+			// element access
+			// copy the value of k to out, false if k is absent
+			bool find(const key_type& k, mapped_type& out) const {
+				const shard &s = shardFor(k);
+				std::shared_lock<std::shared_mutex> guard(s.lock);
+				typename shard_type::const_iterator it = s.map.find(k);
+				if (it == s.map.end())
+					return false;
+				out = it->second;
+				return true;
+			}
+			bool contains(const key_type& k) const {
+				const shard &s = shardFor(k);
+				std::shared_lock<std::shared_mutex> guard(s.lock);
+				return s.map.contains(k);
+			}
+			size_type count(const key_type& k) const { return contains(k) ? 1 : 0; }
+			// call f(const value_type&) on the element of k under a read
+			// lock, false if k is absent
+			template <class Function>
+			bool visit(const key_type& k, Function f) const {
+				const shard &s = shardFor(k);
+				std::shared_lock<std::shared_mutex> guard(s.lock);
+				typename shard_type::const_iterator it = s.map.find(k);
+				if (it == s.map.end())
+					return false;
+				f(*it);
+				return true;
+			}
+			// call f(value_type&) on the element of k under a write lock,
+			// false if k is absent
+			template <class Function>
+			bool update(const key_type& k, Function f) {
+				shard &s = shardFor(k);
+				std::unique_lock<std::shared_mutex> guard(s.lock);
+				typename shard_type::iterator it = s.map.find(k);
+				if (it == s.map.end())
+					return false;
+				f(*it);
+				return true;
+			}
+
+			// modifiers
+			// false, and nothing changed, if the key is already there
+			bool insert(const value_type& x) {
+				shard &s = shardFor(x.first);
+				std::unique_lock<std::shared_mutex> guard(s.lock);
+				return s.map.insert(x).second;
+			}
+			template <class... Args>
+			bool try_emplace(const key_type& k, Args&&... args) {
+				shard &s = shardFor(k);
+				std::unique_lock<std::shared_mutex> guard(s.lock);
+				return s.map.try_emplace(k, std::forward<Args>(args)...).second;
+			}
+			// true if inserted, false if assigned
+			template <class M>
+			bool insert_or_assign(const key_type& k, M&& obj) {
+				shard &s = shardFor(k);
+				std::unique_lock<std::shared_mutex> guard(s.lock);
+				return s.map.insert_or_assign(k, std::forward<M>(obj)).second;
+			}
+			size_type erase(const key_type& k) {
+				shard &s = shardFor(k);
+				std::unique_lock<std::shared_mutex> guard(s.lock);
+				return s.map.erase(k);
+			}
+			// each shard is swapped out under its lock and destroyed after,
+			// so readers don't wait for the elements to be freed
+			void clear() {
+				for (size_type i = 0; i < _shards.size(); ++i) {
+					shard_type gone(_comp, _shards[i]->map.get_allocator());
+					std::unique_lock<std::shared_mutex> guard(_shards[i]->lock);
+					_shards[i]->map.swap(gone);
+					guard.unlock();
+				}
+			}
+
+			// whole-map operations
+			// call f(shard_type&) on every shard, the shards in parallel on
+			// workers. every shard is write locked for the whole call
+			template <class Function>
+			void for_each_shard(Function f, thread_pool& workers = thread_pool::shared()) {
+				std::vector<std::unique_lock<std::shared_mutex> > guards;
+				guards.reserve(_shards.size());
+				for (size_type i = 0; i < _shards.size(); ++i)
+					guards.push_back(std::unique_lock<std::shared_mutex>(_shards[i]->lock));
+				auto run = [&](size_type i) { f(_shards[i]->map); };
+				forkShards(0, _shards.size(), run, workers);
+			}
+			// the same with f(const shard_type&), every shard read locked
+			template <class Function>
+			void for_each_shard(Function f, thread_pool& workers = thread_pool::shared()) const {
+				std::vector<std::shared_lock<std::shared_mutex> > guards;
+				guards.reserve(_shards.size());
+				for (size_type i = 0; i < _shards.size(); ++i)
+					guards.push_back(std::shared_lock<std::shared_mutex>(_shards[i]->lock));
+				auto run = [&](size_type i) { f(static_cast<const shard_type &>(_shards[i]->map)); };
+				forkShards(0, _shards.size(), run, workers);
+			}
+			// call f(const value_type&) on every element in key order, with
+			// every shard read locked for the whole walk. range partitioned
+			// shards are walked one after the other, hash partitioned ones
+			// through a k-way merge on a heap of shard cursors
+			template <class Function>
+			void for_each_ordered(Function f) const {
+				// in index order like for_each_shard, writers only ever hold one
+				std::vector<std::shared_lock<std::shared_mutex> > guards;
+				guards.reserve(_shards.size());
+				for (size_type i = 0; i < _shards.size(); ++i)
+					guards.push_back(std::shared_lock<std::shared_mutex>(_shards[i]->lock));
+
+				if (!_splitters.empty()) {
+					for (size_type i = 0; i < _shards.size(); ++i)
+						for (typename shard_type::const_iterator it = _shards[i]->map.begin(); it != _shards[i]->map.end(); ++it)
+							f(*it);
+					return;
+				}
+				std::vector<cursor> heap;
+				heap.reserve(_shards.size());
+				for (size_type i = 0; i < _shards.size(); ++i) {
+					const shard_type &m = _shards[i]->map;
+					if (!m.empty()) {
+						cursor c = { m.begin(), m.end() };
+						heap.push_back(c);
+					}
+				}
+				cursor_greater greater = { _comp };
+				std::make_heap(heap.begin(), heap.end(), greater);
+				while (!heap.empty()) {
+					std::pop_heap(heap.begin(), heap.end(), greater);
+					cursor &c = heap.back();
+					f(*c.it);
+					if (++c.it == c.end)
+						heap.pop_back();
+					else
+						std::push_heap(heap.begin(), heap.end(), greater);
+				}
+			}
+
+			// observers
+			key_compare key_comp() const { return _comp; }
+			hasher hash_function() const { return _hash; }
+	};
+}
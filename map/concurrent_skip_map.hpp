@@ -0,0 +1,376 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include "./pair.hpp"
+#include "./RBTree.hpp"
+#include "./epoch.hpp"
+
+namespace ft {
+
+	// ordered map for many threads without locks: a skip list whose links
+	// are changed by compare-and-swap only. a node is removed by first
+	// marking its links, which makes it logically deleted and stops anyone
+	// from linking behind it, then unlinking it level by level; every
+	// search unlinks the marked nodes it walks over. unlinked nodes are
+	// freed through epoch based reclamation, every operation runs in an
+	// epoch::guard.
+	//
+	// elements can't be changed once inserted, so readers never see a half
+	// written value: at() returns a copy, iterators give const access.
+	// an iterator pins the current epoch while it lives and must stay on
+	// the thread that made it. size() is exact only when nobody writes.
+	template<
+			class Key,
+			class T,
+			class Compare = std::less<Key>
+			>
+	class concurrent_skip_map : private CompareHolder<Compare> {
+		public:
+			typedef Key key_type;
+			typedef T mapped_type;
+			typedef ft::pair<const key_type, mapped_type> value_type;
+			typedef Compare key_compare;
+			typedef std::size_t size_type;
+			typedef std::ptrdiff_t difference_type;
+
+		private:
+			// a quarter of the nodes reach each next level, 4^maxLevel is
+			// far beyond any size
+			static const int maxLevel = 24;
+
+			// links are node pointers with the low bit set once the node
+			// holding the link is deleted at that level
+			struct node {
+				// the levels the node is linked at, plus one for the
+				// inserter until it is done, the last one out retires it
+				std::atomic<int> refs;
+				int height;
+				value_type data;
+				std::atomic<std::uintptr_t> next[1];
+
+				template <typename... Args>
+				node(int height, Args&&... args) : refs(1), height(height), data(std::forward<Args>(args)...) {}
+			};
+
+			static node* ptr(std::uintptr_t link) { return reinterpret_cast<node *>(link & ~static_cast<std::uintptr_t>(1)); }
+			static bool marked(std::uintptr_t link) { return link & 1; }
+			static std::uintptr_t linkTo(node *x) { return reinterpret_cast<std::uintptr_t>(x); }
+
+			// the head is a node of maxLevel links whose data is never built
+			struct head_storage {
+				std::atomic<int> refs;
+				int height;
+				alignas(value_type) unsigned char data[sizeof(value_type)];
+				std::atomic<std::uintptr_t> next[maxLevel];
+			};
+			head_storage _head;
+			std::atomic<size_type> _size;
+
+			node* head() { return reinterpret_cast<node *>(&_head); }
+			const node* head() const { return reinterpret_cast<const node *>(&_head); }
+
+			// a node with height links, all NULL
+			template <typename... Args>
+			static node* createNode(int height, Args&&... args) {
+				void *raw = ::operator new(sizeof(node) + (height - 1) * sizeof(std::atomic<std::uintptr_t>));
+				node *x;
+				try {
+					x = ::new (raw) node(height, std::forward<Args>(args)...);
+				} catch (...) {
+					::operator delete(raw);
+					throw;
+				}
+				for (int i = 1; i < height; ++i)
+					::new (static_cast<void *>(&x->next[i])) std::atomic<std::uintptr_t>(0);
+				x->next[0].store(0, std::memory_order_relaxed);
+				return x;
+			}
+			static void destroyNode(void *p) {
+				node *x = static_cast<node *>(p);
+				x->~node();
+				::operator delete(p);
+			}
+			// one link of x gone (or the inserter done with it)
+			static void release(node *x) {
+				if (x->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+					epoch::retire(x, &destroyNode);
+			}
+
+			// geometric height from a per thread xorshift
+			static int randomHeight() {
+				static thread_local std::uint64_t state = reinterpret_cast<std::uintptr_t>(&state) | 1;
+				state ^= state << 13;
+				state ^= state >> 7;
+				state ^= state << 17;
+				int height = 1;
+				for (std::uint64_t bits = state; height < maxLevel && (bits & 3) == 0; bits >>= 2)
+					++height;
+				return height;
+			}
+
+			bool keyLess(const Key &a, const Key &b) const { return this->compare()(a, b); }
+
+			// preds/succs[i]: the last node before key at level i and the one
+			// after it, unlinking every marked node on the way. returns the
+			// unmarked node holding key or NULL
+			node* findPosition(const Key &key, node **preds, node **succs);
+			// first unmarked node whose key is not less than key, without
+			// unlinking anything (readers don't write)
+			node* lowerBound(const Key &key) const;
+			// first node after x at level 0 that isn't deleted
+			static node* nextLive(const node *x);
+
+			concurrent_skip_map(const concurrent_skip_map &);
+			concurrent_skip_map &operator=(const concurrent_skip_map &);
+
+		public:
+			class const_iterator {
+				public:
+					typedef std::ptrdiff_t difference_type;
+					typedef typename concurrent_skip_map::value_type value_type;
+					typedef const value_type* pointer;
+					typedef const value_type& reference;
+					typedef std::forward_iterator_tag iterator_category;
+
+					const_iterator() : current(NULL) {}
+
+					reference operator*() const { return current->data; }
+					pointer operator->() const { return &current->data; }
+					// skips the elements deleted in the meantime
+					const_iterator& operator++() { current = nextLive(current); return *this; }
+					const_iterator operator++(int) { const_iterator tmp(*this); ++*this; return tmp; }
+
+					bool operator==(const const_iterator &other) const { return current == other.current; }
+					bool operator!=(const const_iterator &other) const { return current != other.current; }
+
+				private:
+					epoch::guard pin;
+					const node *current;
+
+					explicit const_iterator(const node *x) : current(x) {}
+
+					friend class concurrent_skip_map;
+			};
+			typedef const_iterator iterator;
+
+			// constructors
+			explicit concurrent_skip_map(const key_compare& comp = key_compare()) : CompareHolder<Compare>(comp), _size(0) {
+				_head.refs.store(1, std::memory_order_relaxed);
+				_head.height = maxLevel;
+				for (int i = 0; i < maxLevel; ++i)
+					_head.next[i].store(0, std::memory_order_relaxed);
+			}
+
+			// destructor, no other thread may use the map any more
+			~concurrent_skip_map();
+
+			// iterators
+			const_iterator begin() const {
+				epoch::guard pin;
+				return const_iterator(nextLive(head()));
+			}
+			const_iterator end() const { return const_iterator(); }
+
+			// capacity
+			bool empty() const { return begin() == end(); }
+			size_type size() const { return _size.load(std::memory_order_relaxed); }
+
+			// modifiers, true if the map changed
+			bool insert(const value_type &x) { return emplace(x); }
+			template <typename... Args>
+			bool emplace(Args&&... args);
+			// remove the element with a given key, returns how many were removed
+			size_type remove(const Key &key);
+			size_type erase(const Key &key) { return remove(key); }
+
+			// lookup
+			bool contains(const Key &key) const {
+				epoch::guard pin;
+				node *x = lowerBound(key);
+				return x != NULL && !keyLess(key, x->data.first);
+			}
+			size_type count(const Key &key) const { return contains(key) ? 1 : 0; }
+			// copy of the value of key
+			mapped_type at(const Key &key) const {
+				epoch::guard pin;
+				node *x = lowerBound(key);
+				if (x == NULL || keyLess(key, x->data.first))
+					throw std::out_of_range("Key not found");
+				return x->data.second;
+			}
+			const_iterator find(const Key &key) const {
+				epoch::guard pin;
+				node *x = lowerBound(key);
+				return (x != NULL && !keyLess(key, x->data.first)) ? const_iterator(x) : end();
+			}
+			const_iterator lower_bound(const Key &key) const {
+				epoch::guard pin;
+				return const_iterator(lowerBound(key));
+			}
+
+			// observers
+			key_compare key_comp() const { return this->compare(); }
+	};
+
+	template <class Key, class T, class Compare>
+	typename concurrent_skip_map<Key, T, Compare>::node* concurrent_skip_map<Key, T, Compare>::findPosition(const Key &key, node **preds, node **succs) {
+	retry:
+		node *pred = head();
+		node *curr = NULL;
+		for (int level = maxLevel - 1; level >= 0; --level) {
+			curr = ptr(pred->next[level].load(std::memory_order_acquire));
+			while (curr != NULL) {
+				std::uintptr_t succ = curr->next[level].load(std::memory_order_acquire);
+				// curr is deleted at this level: unlink it, or start over if
+				// pred changed under us
+				while (marked(succ)) {
+					std::uintptr_t expected = linkTo(curr);
+					if (!pred->next[level].compare_exchange_strong(expected, succ & ~static_cast<std::uintptr_t>(1), std::memory_order_acq_rel))
+						goto retry;
+					release(curr);
+					curr = ptr(succ);
+					if (curr == NULL)
+						break;
+					succ = curr->next[level].load(std::memory_order_acquire);
+				}
+				if (curr == NULL || !keyLess(curr->data.first, key))
+					break;
+				pred = curr;
+				curr = ptr(succ);
+			}
+			preds[level] = pred;
+			succs[level] = curr;
+		}
+		return (curr != NULL && !keyLess(key, curr->data.first)) ? curr : NULL;
+	}
+
+	template <class Key, class T, class Compare>
+	typename concurrent_skip_map<Key, T, Compare>::node* concurrent_skip_map<Key, T, Compare>::lowerBound(const Key &key) const {
+		const node *pred = head();
+		node *curr = NULL;
+		for (int level = maxLevel - 1; level >= 0; --level) {
+			curr = ptr(pred->next[level].load(std::memory_order_acquire));
+			while (curr != NULL) {
+				std::uintptr_t succ = curr->next[level].load(std::memory_order_acquire);
+				// step over deleted nodes, they are still linked to the rest
+				if (marked(succ)) {
+					curr = ptr(succ);
+					continue;
+				}
+				if (!keyLess(curr->data.first, key))
+					break;
+				pred = curr;
+				curr = ptr(succ);
+			}
+		}
+		return curr;
+	}
+
+	template <class Key, class T, class Compare>
+	typename concurrent_skip_map<Key, T, Compare>::node* concurrent_skip_map<Key, T, Compare>::nextLive(const node *x) {
+		node *curr = ptr(x->next[0].load(std::memory_order_acquire));
+		while (curr != NULL && marked(curr->next[0].load(std::memory_order_acquire)))
+			curr = ptr(curr->next[0].load(std::memory_order_acquire));
+		return curr;
+	}
+
+	template <class Key, class T, class Compare>
+	template <typename... Args>
+	bool concurrent_skip_map<Key, T, Compare>::emplace(Args&&... args) {
+		node *x = createNode(randomHeight(), std::forward<Args>(args)...);
+		const Key &key = x->data.first;
+		node *preds[maxLevel];
+		node *succs[maxLevel];
+		epoch::guard pin;
+
+		// level 0 decides whether the key is in
+		for (;;) {
+			if (findPosition(key, preds, succs) != NULL) {
+				destroyNode(x);
+				return false;
+			}
+			x->next[0].store(linkTo(succs[0]), std::memory_order_relaxed);
+			x->refs.fetch_add(1, std::memory_order_relaxed);
+			std::uintptr_t expected = linkTo(succs[0]);
+			if (preds[0]->next[0].compare_exchange_strong(expected, linkTo(x), std::memory_order_acq_rel))
+				break;
+			x->refs.fetch_sub(1, std::memory_order_relaxed);
+		}
+		_size.fetch_add(1, std::memory_order_relaxed);
+
+		// then the upper levels, unless x gets deleted meanwhile
+		for (int level = 1; level < x->height; ++level) {
+			for (;;) {
+				// point x at succ, unless a remover marked the link
+				std::uintptr_t link = x->next[level].load(std::memory_order_acquire);
+				if (marked(link) || !x->next[level].compare_exchange_strong(link, linkTo(succs[level]), std::memory_order_acq_rel))
+					goto done;
+				x->refs.fetch_add(1, std::memory_order_relaxed);
+				std::uintptr_t expected = linkTo(succs[level]);
+				if (preds[level]->next[level].compare_exchange_strong(expected, linkTo(x), std::memory_order_acq_rel))
+					break;
+				x->refs.fetch_sub(1, std::memory_order_relaxed);
+				// the neighbourhood changed, look again. x itself may be
+				// gone already, then the levels above aren't needed
+				if (findPosition(key, preds, succs) != x)
+					goto done;
+			}
+			// a remover that marked this link after we set it may have
+			// finished its cleanup before x was linked here
+			if (marked(x->next[level].load(std::memory_order_acquire)))
+				findPosition(key, preds, succs);
+		}
+	done:
+		release(x);
+		return true;
+	}
+
+	template <class Key, class T, class Compare>
+	typename concurrent_skip_map<Key, T, Compare>::size_type concurrent_skip_map<Key, T, Compare>::remove(const Key &key) {
+		node *preds[maxLevel];
+		node *succs[maxLevel];
+		epoch::guard pin;
+
+		node *x = findPosition(key, preds, succs);
+		if (x == NULL)
+			return 0;
+		// mark the upper levels top down, then level 0: whoever marks
+		// level 0 deleted the element
+		for (int level = x->height - 1; level >= 1; --level) {
+			std::uintptr_t link = x->next[level].load(std::memory_order_acquire);
+			while (!marked(link))
+				x->next[level].compare_exchange_weak(link, link | 1, std::memory_order_acq_rel);
+		}
+		std::uintptr_t link = x->next[0].load(std::memory_order_acquire);
+		for (;;) {
+			if (marked(link))
+				return 0;
+			if (x->next[0].compare_exchange_weak(link, link | 1, std::memory_order_acq_rel))
+				break;
+		}
+		_size.fetch_sub(1, std::memory_order_relaxed);
+		// unlink it everywhere
+		findPosition(key, preds, succs);
+		return 1;
+	}
+
+	template <class Key, class T, class Compare>
+	concurrent_skip_map<Key, T, Compare>::~concurrent_skip_map() {
+		// every node is reached once per level it is linked at, the last
+		// one frees it. nodes that are unlinked everywhere were retired
+		for (int level = maxLevel - 1; level >= 0; --level) {
+			node *x = ptr(_head.next[level].load(std::memory_order_relaxed));
+			while (x != NULL) {
+				node *next = ptr(x->next[level].load(std::memory_order_relaxed));
+				if (x->refs.fetch_sub(1, std::memory_order_relaxed) == 1)
+					destroyNode(x);
+				x = next;
+			}
+		}
+	}
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ft {
+
+	// epoch based reclamation for lock-free containers. a thread reads
+	// shared nodes only inside a critical section (an epoch::guard); a node
+	// that was unlinked is retire()d and freed once every thread that was in
+	// a critical section at the time has left it.
+	//
+	// there is one global epoch. a thread entering a critical section
+	// announces the epoch it saw, and the epoch only moves on once every
+	// thread inside a critical section announced the current one, so a node
+	// retired in epoch e is unreachable to every thread once the epoch is
+	// e + 2. each thread keeps the nodes it retired and frees the old ones
+	// every few retirements.
+	class epoch {
+		private:
+			struct retired {
+				void *p;
+				void (*deleter)(void *);
+				std::uint64_t epoch;
+			};
+
+			// per thread state, linked in a list that only grows. a record
+			// is reused by the next thread once its owner exits, together
+			// with the nodes still waiting in it
+			struct record {
+				// epoch << 1 | 1 while in a critical section, 0 outside
+				std::atomic<std::uint64_t> state;
+				std::atomic<bool> inUse;
+				record *next;
+				// owner only
+				unsigned nesting;
+				std::size_t sinceScan;
+				std::vector<retired> limbo;
+
+				record() : state(0), inUse(true), next(NULL), nesting(0), sinceScan(0) {}
+			};
+
+			// retirements between two attempts to free
+			static const std::size_t scanEvery = 64;
+
+			static std::atomic<std::uint64_t>& globalEpoch() {
+				static std::atomic<std::uint64_t> e(0);
+				return e;
+			}
+			static std::atomic<record *>& records() {
+				static std::atomic<record *> head(NULL);
+				return head;
+			}
+
+			// claims a free record for the thread, gives it back at exit
+			struct owner {
+				record *rec;
+
+				owner() {
+					for (rec = records().load(std::memory_order_acquire); rec != NULL; rec = rec->next) {
+						bool free = false;
+						if (!rec->inUse.load(std::memory_order_relaxed) && rec->inUse.compare_exchange_strong(free, true))
+							return;
+					}
+					rec = new record;
+					record *head = records().load(std::memory_order_relaxed);
+					do {
+						rec->next = head;
+					} while (!records().compare_exchange_weak(head, rec, std::memory_order_release, std::memory_order_relaxed));
+				}
+				~owner() { rec->inUse.store(false, std::memory_order_release); }
+			};
+
+			static record& local() {
+				static thread_local owner o;
+				return *o.rec;
+			}
+
+			// move to the next epoch if every thread in a critical section
+			// is in the current one
+			static void tryAdvance() {
+				std::uint64_t e = globalEpoch().load();
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				for (record *r = records().load(std::memory_order_acquire); r != NULL; r = r->next) {
+					std::uint64_t s = r->state.load();
+					if ((s & 1) && (s >> 1) != e)
+						return;
+				}
+				globalEpoch().compare_exchange_strong(e, e + 1);
+			}
+
+			// free what this thread retired two epochs ago or earlier
+			static void collect(record &r) {
+				std::uint64_t e = globalEpoch().load();
+				std::size_t kept = 0;
+				for (std::size_t i = 0; i < r.limbo.size(); ++i) {
+					if (r.limbo[i].epoch + 2 <= e)
+						r.limbo[i].deleter(r.limbo[i].p);
+					else
+						r.limbo[kept++] = r.limbo[i];
+				}
+				r.limbo.resize(kept);
+			}
+
+			static void enter() {
+				record &r = local();
+				if (r.nesting++ != 0)
+					return;
+				r.state.store(globalEpoch().load() << 1 | 1, std::memory_order_relaxed);
+				// the announcement must be visible before any shared load
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+			}
+			static void leave() {
+				record &r = local();
+				if (--r.nesting == 0)
+					r.state.store(0, std::memory_order_release);
+			}
+
+		public:
+			// critical section, nests and can be copied within one thread
+			class guard {
+				public:
+					guard() { enter(); }
+					guard(const guard &) { enter(); }
+					guard& operator=(const guard &) { return *this; }
+					~guard() { leave(); }
+			};
+
+			// free p with deleter(p) once no thread can still be reading it,
+			// p must already be unreachable from the shared structure
+			static void retire(void *p, void (*deleter)(void *)) {
+				record &r = local();
+				retired x = { p, deleter, globalEpoch().load() };
+				r.limbo.push_back(x);
+				if (++r.sinceScan == scanEvery) {
+					r.sinceScan = 0;
+					tryAdvance();
+					collect(r);
+				}
+			}
+
+			// advance as far as possible and free what this thread retired,
+			// for a thread outside any critical section that goes idle
+			static void flush() {
+				record &r = local();
+				for (int i = 0; i < 3 && !r.limbo.empty(); ++i) {
+					tryAdvance();
+					collect(r);
+				}
+			}
+	};
+}
@@ -0,0 +1,367 @@
+#pragma once
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+#include "./pair.hpp"
+#include "./map.hpp"
+#include "./simd_lower_bound.hpp"
+
+namespace ft {
+
+	// sorted vector map for tables that are built once and read many times.
+	// keys and values live in two separate arrays, so a lookup only walks
+	// keys, with a branchless lower_bound that counts its last few keys with
+	// SIMD compares when the keys are arithmetic and ordered by std::less.
+	// inserting or erasing one element is O(n), inserting a range is
+	// O(n + m log m): the new elements are sorted once and merged in.
+	//
+	// elements are not stored as pairs: dereferencing an iterator gives a
+	// pair of references to the key and the value, and inserting or erasing
+	// invalidates every iterator.
+	template<
+			class Key,
+			class T,
+			class Compare = std::less<Key>,
+			class Allocator = std::allocator<ft::pair<const Key, T> >
+			>
+	class flat_map : private CompareHolder<Compare> {
+		public:
+			typedef Key key_type;
+			typedef T mapped_type;
+			typedef ft::pair<const key_type, mapped_type> value_type;
+			typedef Compare key_compare;
+			typedef Allocator allocator_type;
+			typedef ft::pair<const key_type&, mapped_type&> reference;
+			typedef ft::pair<const key_type&, const mapped_type&> const_reference;
+			typedef std::ptrdiff_t difference_type;
+			typedef std::size_t size_type;
+			typedef std::vector<Key, typename std::allocator_traits<Allocator>::template rebind_alloc<Key> > key_container_type;
+			typedef std::vector<T, typename std::allocator_traits<Allocator>::template rebind_alloc<T> > mapped_container_type;
+			typedef ft::map<Key, T, Compare, Allocator> map_type;
+
+		private:
+			key_container_type _keys;
+			mapped_container_type _values;
+
+			// holds a pair of references so that it->first works
+			template <typename Reference>
+			struct arrow_proxy {
+				Reference ref;
+				arrow_proxy(const Reference &ref) : ref(ref) {}
+				Reference* operator->() { return &ref; }
+			};
+
+			// index of the first key not less than key
+			size_type lowerBound(const Key &key) const {
+				return ft::sorted_lower_bound(_keys.data(), _keys.size(), key, this->compare());
+			}
+			// index of the first key greater than key
+			size_type upperBound(const Key &key) const {
+				size_type i = lowerBound(key);
+				return (i < _keys.size() && !this->compare()(key, _keys[i])) ? i + 1 : i;
+			}
+			// index of key, size() if absent
+			size_type indexOf(const Key &key) const {
+				size_type i = lowerBound(key);
+				return (i < _keys.size() && !this->compare()(key, _keys[i])) ? i : _keys.size();
+			}
+
+		public:
+		class iterator {
+			public:
+				typedef std::ptrdiff_t difference_type;
+				typedef typename flat_map::value_type value_type;
+				typedef typename flat_map::reference reference;
+				typedef arrow_proxy<reference> pointer;
+				typedef std::random_access_iterator_tag iterator_category;
+
+				// default constructor
+				iterator() : key(NULL), value(NULL) {}
+
+				reference operator*() const { return reference(*key, *value); }
+				pointer operator->() const { return pointer(**this); }
+				reference operator[](difference_type n) const { return reference(key[n], value[n]); }
+
+				iterator& operator++() { ++key; ++value; return *this; }
+				iterator operator++(int) { iterator tmp(*this); ++*this; return tmp; }
+				iterator& operator--() { --key; --value; return *this; }
+				iterator operator--(int) { iterator tmp(*this); --*this; return tmp; }
+				iterator& operator+=(difference_type n) { key += n; value += n; return *this; }
+				iterator& operator-=(difference_type n) { key -= n; value -= n; return *this; }
+				iterator operator+(difference_type n) const { iterator tmp(*this); return tmp += n; }
+				iterator operator-(difference_type n) const { iterator tmp(*this); return tmp -= n; }
+				difference_type operator-(const iterator &other) const { return key - other.key; }
+
+				bool operator==(const iterator &other) const { return key == other.key; }
+				bool operator!=(const iterator &other) const { return key != other.key; }
+				bool operator<(const iterator &other) const { return key < other.key; }
+				bool operator>(const iterator &other) const { return key > other.key; }
+				bool operator<=(const iterator &other) const { return key <= other.key; }
+				bool operator>=(const iterator &other) const { return key >= other.key; }
+
+			private:
+				const Key *key;
+				T *value;
+
+				iterator(const Key *key, T *value) : key(key), value(value) {}
+
+				friend class flat_map;
+				friend class const_iterator;
+		};
+
+		class const_iterator {
+			public:
+				typedef std::ptrdiff_t difference_type;
+				typedef typename flat_map::value_type value_type;
+				typedef typename flat_map::const_reference reference;
+				typedef arrow_proxy<reference> pointer;
+				typedef std::random_access_iterator_tag iterator_category;
+
+				// default constructor
+				const_iterator() : key(NULL), value(NULL) {}
+				const_iterator(const iterator &other) : key(other.key), value(other.value) {}
+
+				reference operator*() const { return reference(*key, *value); }
+				pointer operator->() const { return pointer(**this); }
+				reference operator[](difference_type n) const { return reference(key[n], value[n]); }
+
+				const_iterator& operator++() { ++key; ++value; return *this; }
+				const_iterator operator++(int) { const_iterator tmp(*this); ++*this; return tmp; }
+				const_iterator& operator--() { --key; --value; return *this; }
+				const_iterator operator--(int) { const_iterator tmp(*this); --*this; return tmp; }
+				const_iterator& operator+=(difference_type n) { key += n; value += n; return *this; }
+				const_iterator& operator-=(difference_type n) { key -= n; value -= n; return *this; }
+				const_iterator operator+(difference_type n) const { const_iterator tmp(*this); return tmp += n; }
+				const_iterator operator-(difference_type n) const { const_iterator tmp(*this); return tmp -= n; }
+				difference_type operator-(const const_iterator &other) const { return key - other.key; }
+
+				bool operator==(const const_iterator &other) const { return key == other.key; }
+				bool operator!=(const const_iterator &other) const { return key != other.key; }
+				bool operator<(const const_iterator &other) const { return key < other.key; }
+				bool operator>(const const_iterator &other) const { return key > other.key; }
+				bool operator<=(const const_iterator &other) const { return key <= other.key; }
+				bool operator>=(const const_iterator &other) const { return key >= other.key; }
+
+			private:
+				const Key *key;
+				const T *value;
+
+				const_iterator(const Key *key, const T *value) : key(key), value(value) {}
+
+				friend class flat_map;
+		};
+
+			typedef std::reverse_iterator<iterator> reverse_iterator;
+			typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+			// constructors
+			explicit flat_map(const key_compare& comp = key_compare(), const allocator_type& alloc = allocator_type())
+				: CompareHolder<Compare>(comp), _keys(alloc), _values(alloc) {}
+			template <class InputIterator>
+			flat_map(InputIterator first, InputIterator last, const key_compare& comp = key_compare(), const allocator_type& alloc = allocator_type())
+				: CompareHolder<Compare>(comp), _keys(alloc), _values(alloc) {
+				insert(first, last);
+			}
+			// from a tree map, already sorted so O(n)
+			explicit flat_map(const map_type& m)
+				: CompareHolder<Compare>(m.key_comp()), _keys(m.get_allocator()), _values(m.get_allocator()) {
+				_keys.reserve(m.size());
+				_values.reserve(m.size());
+				for (typename map_type::const_iterator it = m.begin(); it != m.end(); ++it) {
+					_keys.push_back(it->first);
+					_values.push_back(it->second);
+				}
+			}
+			flat_map(const flat_map& x) : CompareHolder<Compare>(x.compare()), _keys(x._keys), _values(x._values) {}
+
+			// destructor
+			~flat_map() {}
+
+			// operators
+			flat_map& operator=(const flat_map& x) {
+				if (this != &x) {
+					flat_map tmp(x);
+					swap(tmp);
+				}
+				return *this;
+			}
+
+			// to a tree map, O(n): the map builds itself bottom-up from sorted input
+			map_type to_map() const { return map_type(begin(), end(), key_comp(), get_allocator()); }
+
+			// iterators
+			iterator begin() { return iterator(_keys.data(), _values.data()); }
+			iterator end() { return iterator(_keys.data() + _keys.size(), _values.data() + _values.size()); }
+			const_iterator begin() const { return const_iterator(_keys.data(), _values.data()); }
+			const_iterator end() const { return const_iterator(_keys.data() + _keys.size(), _values.data() + _values.size()); }
+			reverse_iterator rbegin() { return reverse_iterator(end()); }
+			reverse_iterator rend() { return reverse_iterator(begin()); }
+			const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+			const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+			// capacity
+			bool empty() const { return _keys.empty(); }
+			size_type size() const { return _keys.size(); }
+			size_type max_size() const { return std::min(_keys.max_size(), _values.max_size()); }
+			void reserve(size_type n) { _keys.reserve(n); _values.reserve(n); }
+			void shrink_to_fit() { _keys.shrink_to_fit(); _values.shrink_to_fit(); }
+
+			// element access
+			mapped_type& operator[](const key_type& k) {
+				size_type i = lowerBound(k);
+				if (i == _keys.size() || this->compare()(k, _keys[i]))
+					return (*insertAt(i, k, mapped_type())).second;
+				return _values[i];
+			}
+			mapped_type& at(const key_type& k) {
+				size_type i = indexOf(k);
+				if (i == _keys.size())
+					throw std::out_of_range("Key not found");
+				return _values[i];
+			}
+			const mapped_type& at(const key_type& k) const {
+				size_type i = indexOf(k);
+				if (i == _keys.size())
+					throw std::out_of_range("Key not found");
+				return _values[i];
+			}
+			// the underlying arrays, in key order
+			const key_container_type& keys() const { return _keys; }
+			const mapped_container_type& values() const { return _values; }
+
+			// modifiers
+			ft::pair<iterator, bool> insert(const value_type& x) {
+				size_type i = lowerBound(x.first);
+				if (i < _keys.size() && !this->compare()(x.first, _keys[i]))
+					return ft::pair<iterator, bool>(begin() + i, false);
+				return ft::pair<iterator, bool>(insertAt(i, x.first, x.second), true);
+			}
+			iterator insert(const_iterator position, const value_type& x) {
+				// the hint is used when x goes right before it, appending at
+				// end() in key order is then amortized O(1)
+				size_type i = position.key - _keys.data();
+				if ((i == 0 || this->compare()(_keys[i - 1], x.first)) && (i == _keys.size() || this->compare()(x.first, _keys[i])))
+					return insertAt(i, x.first, x.second);
+				return insert(x).first;
+			}
+			// stage the range, sort it once and merge it in, keys already
+			// present and later duplicates in the range are ignored
+			template <class InputIterator>
+			void insert(InputIterator first, InputIterator last);
+			iterator erase(const_iterator position) {
+				size_type i = position.key - _keys.data();
+				_keys.erase(_keys.begin() + i);
+				_values.erase(_values.begin() + i);
+				return begin() + i;
+			}
+			size_type erase(const key_type& x) {
+				size_type i = indexOf(x);
+				if (i == _keys.size())
+					return 0;
+				erase(const_iterator(begin() + i));
+				return 1;
+			}
+			iterator erase(const_iterator first, const_iterator last) {
+				size_type i = first.key - _keys.data();
+				size_type j = last.key - _keys.data();
+				_keys.erase(_keys.begin() + i, _keys.begin() + j);
+				_values.erase(_values.begin() + i, _values.begin() + j);
+				return begin() + i;
+			}
+			void swap(flat_map& x) {
+				std::swap(this->compare(), x.compare());
+				_keys.swap(x._keys);
+				_values.swap(x._values);
+			}
+			void clear() { _keys.clear(); _values.clear(); }
+
+			// observers
+			key_compare key_comp() const { return this->compare(); }
+
+			// operations
+			iterator find(const key_type& x) { return begin() + indexOf(x); }
+			const_iterator find(const key_type& x) const { return begin() + indexOf(x); }
+			size_type count(const key_type& x) const { return indexOf(x) != _keys.size() ? 1 : 0; }
+			bool contains(const key_type& x) const { return indexOf(x) != _keys.size(); }
+			iterator lower_bound(const key_type& x) { return begin() + lowerBound(x); }
+			const_iterator lower_bound(const key_type& x) const { return begin() + lowerBound(x); }
+			iterator upper_bound(const key_type& x) { return begin() + upperBound(x); }
+			const_iterator upper_bound(const key_type& x) const { return begin() + upperBound(x); }
+			ft::pair<iterator, iterator> equal_range(const key_type& x) { return ft::pair<iterator, iterator>(lower_bound(x), upper_bound(x)); }
+			ft::pair<const_iterator, const_iterator> equal_range(const key_type& x) const { return ft::pair<const_iterator, const_iterator>(lower_bound(x), upper_bound(x)); }
+
+			// allocator
+			allocator_type get_allocator() const { return allocator_type(_keys.get_allocator()); }
+
+		private:
+			// insert at index i, which is where k belongs
+			iterator insertAt(size_type i, const key_type& k, const mapped_type& v) {
+				_keys.insert(_keys.begin() + i, k);
+				try {
+					_values.insert(_values.begin() + i, v);
+				} catch (...) {
+					_keys.erase(_keys.begin() + i);
+					throw;
+				}
+				return begin() + i;
+			}
+	};
+
+	template <class Key, class T, class Compare, class Allocator>
+	template <class InputIterator>
+	void flat_map<Key, T, Compare, Allocator>::insert(InputIterator first, InputIterator last) {
+		typedef ft::pair<Key, T> entry;
+		std::vector<entry> staged;
+		for (; first != last; ++first)
+			staged.push_back(entry((*first).first, (*first).second));
+		if (staged.empty())
+			return;
+
+		// stable, so the first of equal keys in the range is the one kept
+		Compare comp = this->compare();
+		std::stable_sort(staged.begin(), staged.end(), [&comp](const entry &a, const entry &b) { return comp(a.first, b.first); });
+
+		key_container_type keys(_keys.get_allocator());
+		mapped_container_type values(_values.get_allocator());
+		keys.reserve(_keys.size() + staged.size());
+		values.reserve(_values.size() + staged.size());
+		size_type i = 0;
+		typename std::vector<entry>::const_iterator it = staged.begin();
+		while (i < _keys.size() || it != staged.end()) {
+			if (it == staged.end() || (i < _keys.size() && !comp(it->first, _keys[i]))) {
+				// existing key first, a staged key equal to it is dropped
+				if (it != staged.end() && !comp(_keys[i], it->first))
+					++it;
+				keys.push_back(_keys[i]);
+				values.push_back(_values[i]);
+				++i;
+			} else if (keys.empty() || comp(keys.back(), it->first)) {
+				keys.push_back(it->first);
+				values.push_back(it->second);
+				++it;
+			} else {
+				++it;	// duplicate within the range
+			}
+		}
+		_keys.swap(keys);
+		_values.swap(values);
+	}
+
+	template <class Key, class T, class Compare, class Allocator>
+	bool operator==(const flat_map<Key, T, Compare, Allocator> &lhs, const flat_map<Key, T, Compare, Allocator> &rhs) {
+		return lhs.keys() == rhs.keys() && lhs.values() == rhs.values();
+	}
+
+	template <class Key, class T, class Compare, class Allocator>
+	bool operator!=(const flat_map<Key, T, Compare, Allocator> &lhs, const flat_map<Key, T, Compare, Allocator> &rhs) {
+		return !(lhs == rhs);
+	}
+
+	template <class Key, class T, class Compare, class Allocator>
+	void swap(flat_map<Key, T, Compare, Allocator> &lhs, flat_map<Key, T, Compare, Allocator> &rhs) {
+		lhs.swap(rhs);
+	}
+}
@@ -0,0 +1,275 @@
+#pragma once
+#include <memory>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+#include "./pair.hpp"
+#include "./map.hpp"
+
+namespace ft {
+
+	// immutable copy of an ft::map laid out in eytzinger order: the keys
+	// form an implicit binary tree in one array, node k has its children at
+	// 2k and 2k + 1 (1-based). a lookup walks down without branching on the
+	// comparison and prefetches the cache line holding the descendants a
+	// few levels below, so the top of the tree stays hot and the rest costs
+	// about one miss per level it can't prefetch.
+	//
+	// the snapshot doesn't follow changes to the map, rebuild() it from the
+	// map when it gets stale. iteration is in key order, stepping from one
+	// slot to its in-order successor in amortized O(1).
+	template<
+			class Key,
+			class T,
+			class Compare = std::less<Key>,
+			class Allocator = std::allocator<ft::pair<const Key, T> >
+			>
+	class frozen_map : private CompareHolder<Compare> {
+		public:
+			typedef Key key_type;
+			typedef T mapped_type;
+			typedef ft::pair<const key_type, mapped_type> value_type;
+			typedef Compare key_compare;
+			typedef Allocator allocator_type;
+			typedef ft::pair<const key_type&, const mapped_type&> reference;
+			typedef reference const_reference;
+			typedef std::ptrdiff_t difference_type;
+			typedef std::size_t size_type;
+			typedef ft::map<Key, T, Compare, Allocator> map_type;
+
+		private:
+			typedef std::vector<Key, typename std::allocator_traits<Allocator>::template rebind_alloc<Key> > key_array;
+			typedef std::vector<T, typename std::allocator_traits<Allocator>::template rebind_alloc<T> > mapped_array;
+
+			// slot k of the implicit tree is _keys[k - 1], slot 0 is end()
+			key_array _keys;
+			mapped_array _values;
+			size_type _first;
+			size_type _last;
+
+			// how many keys fit in a cache line, the descendants of k that
+			// far down start at k * line_keys and are contiguous
+			static const size_type line_keys = (64 / sizeof(Key)) ? 64 / sizeof(Key) : 1;
+
+			// holds a pair of references so that it->first works
+			struct arrow_proxy {
+				reference ref;
+				arrow_proxy(const reference &ref) : ref(ref) {}
+				reference* operator->() { return &ref; }
+			};
+
+			// in-order neighbours in an implicit tree of n slots, 0 past either end
+			static size_type nextSlot(size_type k, size_type n) {
+				if (2 * k + 1 <= n) {
+					k = 2 * k + 1;
+					while (2 * k <= n)
+						k = 2 * k;
+					return k;
+				}
+				// climb while k is a right child, then once more
+				return k >> (__builtin_ctzl(~k) + 1);
+			}
+			size_type prevSlot(size_type k) const {
+				if (k == 0)
+					return _last;
+				if (2 * k <= _keys.size()) {
+					k = 2 * k;
+					while (2 * k + 1 <= _keys.size())
+						k = 2 * k + 1;
+					return k;
+				}
+				return k >> (__builtin_ctzl(k) + 1);
+			}
+
+			// slot of the first key not less than key, 0 if none
+			size_type lowerSlot(const Key &key) const {
+				const Key *keys = _keys.data();
+				size_type n = _keys.size();
+				size_type k = 1;
+				while (k <= n) {
+					__builtin_prefetch(keys + k * line_keys - 1);
+					k = 2 * k + this->compare()(keys[k - 1], key);
+				}
+				// undo the right turns taken after the last left one
+				return k >> (__builtin_ctzl(~k) + 1);
+			}
+			// slot of the first key greater than key, 0 if none
+			size_type upperSlot(const Key &key) const {
+				const Key *keys = _keys.data();
+				size_type n = _keys.size();
+				size_type k = 1;
+				while (k <= n) {
+					__builtin_prefetch(keys + k * line_keys - 1);
+					k = 2 * k + !this->compare()(key, keys[k - 1]);
+				}
+				return k >> (__builtin_ctzl(~k) + 1);
+			}
+			size_type findSlot(const Key &key) const {
+				size_type k = lowerSlot(key);
+				return (k != 0 && !this->compare()(key, _keys[k - 1])) ? k : 0;
+			}
+
+			void build(const map_type &m);
+
+		public:
+		class const_iterator {
+			public:
+				typedef std::ptrdiff_t difference_type;
+				typedef typename frozen_map::value_type value_type;
+				typedef typename frozen_map::reference reference;
+				typedef arrow_proxy pointer;
+				typedef std::bidirectional_iterator_tag iterator_category;
+
+				// default constructor
+				const_iterator() : owner(NULL), slot(0) {}
+
+				reference operator*() const { return reference(owner->_keys[slot - 1], owner->_values[slot - 1]); }
+				pointer operator->() const { return pointer(**this); }
+
+				const_iterator& operator++() { slot = nextSlot(slot, owner->size()); return *this; }
+				const_iterator operator++(int) { const_iterator tmp(*this); ++*this; return tmp; }
+				const_iterator& operator--() { slot = owner->prevSlot(slot); return *this; }
+				const_iterator operator--(int) { const_iterator tmp(*this); --*this; return tmp; }
+
+				bool operator==(const const_iterator &other) const { return slot == other.slot; }
+				bool operator!=(const const_iterator &other) const { return slot != other.slot; }
+
+			private:
+				const frozen_map *owner;
+				size_type slot;
+
+				const_iterator(const frozen_map *owner, size_type slot) : owner(owner), slot(slot) {}
+
+				friend class frozen_map;
+		};
+
+			// a snapshot can't be modified, both iterators are constant
+			typedef const_iterator iterator;
+			typedef std::reverse_iterator<const_iterator> reverse_iterator;
+			typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+			// constructors
+			explicit frozen_map(const key_compare& comp = key_compare(), const allocator_type& alloc = allocator_type())
+				: CompareHolder<Compare>(comp), _keys(alloc), _values(alloc), _first(0), _last(0) {}
+			// O(n), one in-order walk of the map
+			explicit frozen_map(const map_type& m)
+				: CompareHolder<Compare>(m.key_comp()), _keys(m.get_allocator()), _values(m.get_allocator()), _first(0), _last(0) {
+				build(m);
+			}
+			frozen_map(const frozen_map& x)
+				: CompareHolder<Compare>(x.compare()), _keys(x._keys), _values(x._values), _first(x._first), _last(x._last) {}
+
+			// destructor
+			~frozen_map() {}
+
+			// operators
+			frozen_map& operator=(const frozen_map& x) {
+				if (this != &x) {
+					frozen_map tmp(x);
+					swap(tmp);
+				}
+				return *this;
+			}
+
+			// replace the snapshot with the current contents of m, reusing
+			// the arrays when they are large enough
+			void rebuild(const map_type& m) {
+				this->compare() = m.key_comp();
+				build(m);
+			}
+
+			// iterators
+			const_iterator begin() const { return const_iterator(this, _first); }
+			const_iterator end() const { return const_iterator(this, 0); }
+			const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+			const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+			// capacity
+			bool empty() const { return _keys.empty(); }
+			size_type size() const { return _keys.size(); }
+			size_type max_size() const { return std::min(_keys.max_size(), _values.max_size()); }
+
+			// element access
+			const mapped_type& at(const key_type& k) const {
+				size_type slot = findSlot(k);
+				if (slot == 0)
+					throw std::out_of_range("Key not found");
+				return _values[slot - 1];
+			}
+
+			// modifiers
+			void swap(frozen_map& x) {
+				std::swap(this->compare(), x.compare());
+				_keys.swap(x._keys);
+				_values.swap(x._values);
+				std::swap(_first, x._first);
+				std::swap(_last, x._last);
+			}
+			void clear() { _keys.clear(); _values.clear(); _first = _last = 0; }
+
+			// observers
+			key_compare key_comp() const { return this->compare(); }
+
+			// operations
+			const_iterator find(const key_type& x) const { return const_iterator(this, findSlot(x)); }
+			size_type count(const key_type& x) const { return findSlot(x) != 0 ? 1 : 0; }
+			bool contains(const key_type& x) const { return findSlot(x) != 0; }
+			const_iterator lower_bound(const key_type& x) const { return const_iterator(this, lowerSlot(x)); }
+			const_iterator upper_bound(const key_type& x) const { return const_iterator(this, upperSlot(x)); }
+			ft::pair<const_iterator, const_iterator> equal_range(const key_type& x) const { return ft::pair<const_iterator, const_iterator>(lower_bound(x), upper_bound(x)); }
+
+			// allocator
+			allocator_type get_allocator() const { return allocator_type(_keys.get_allocator()); }
+	};
+
+	template <class Key, class T, class Compare, class Allocator>
+	void frozen_map<Key, T, Compare, Allocator>::build(const map_type &m) {
+		size_type n = m.size();
+		_keys.clear();
+		_values.clear();
+		_first = _last = 0;
+		if (n == 0)
+			return;
+
+		// the map is walked in order while the slots are visited in order,
+		// which places every element, then the arrays are filled by slot
+		std::vector<const value_type *> bySlot(n);
+		_first = 1;
+		while (2 * _first <= n)
+			_first = 2 * _first;
+		size_type k = _first;
+		for (typename map_type::const_iterator it = m.begin(); it != m.end(); ++it) {
+			bySlot[k - 1] = &*it;
+			_last = k;
+			k = nextSlot(k, n);
+		}
+		_keys.reserve(n);
+		_values.reserve(n);
+		for (size_type i = 0; i < n; ++i) {
+			_keys.push_back(bySlot[i]->first);
+			_values.push_back(bySlot[i]->second);
+		}
+	}
+
+	template <class Key, class T, class Compare, class Allocator>
+	bool operator==(const frozen_map<Key, T, Compare, Allocator> &lhs, const frozen_map<Key, T, Compare, Allocator> &rhs) {
+		if (lhs.size() != rhs.size())
+			return false;
+		typename frozen_map<Key, T, Compare, Allocator>::const_iterator a = lhs.begin(), b = rhs.begin();
+		for (; a != lhs.end(); ++a, ++b)
+			if (!(a->first == b->first && a->second == b->second))
+				return false;
+		return true;
+	}
+
+	template <class Key, class T, class Compare, class Allocator>
+	bool operator!=(const frozen_map<Key, T, Compare, Allocator> &lhs, const frozen_map<Key, T, Compare, Allocator> &rhs) {
+		return !(lhs == rhs);
+	}
+
+	template <class Key, class T, class Compare, class Allocator>
+	void swap(frozen_map<Key, T, Compare, Allocator> &lhs, frozen_map<Key, T, Compare, Allocator> &rhs) {
+		lhs.swap(rhs);
+	}
+}
@@ -0,0 +1,182 @@
+#pragma once
+#include <memory>
+#include <functional>
+#include "./pair.hpp"
+#include "./RBTree.hpp"
+#include "./tree_augment.hpp"
+
+namespace ft {
+
+	// half-open interval [low, high)
+	template <typename Bound>
+	struct interval {
+		Bound low;
+		Bound high;
+
+		interval() : low(), high() {}
+		interval(const Bound &low, const Bound &high) : low(low), high(high) {}
+	};
+
+	// intervals ordered by low end, then by high end
+	template <typename Bound, typename Compare = std::less<Bound> >
+	struct interval_less {
+		bool operator()(const interval<Bound> &a, const interval<Bound> &b) const {
+			Compare comp;
+			if (comp(a.low, b.low))
+				return true;
+			if (comp(b.low, a.low))
+				return false;
+			return comp(a.high, b.high);
+		}
+	};
+
+	// map from half-open intervals to values, an RBTree ordered by low end
+	// where every node knows the largest high end below it, so overlap
+	// queries skip the subtrees that end before the query starts and stop at
+	// the first interval starting after it ends: O(log n + k) for k results.
+	// Compare orders the bounds and must be stateless.
+	template<
+			class Bound,
+			class T,
+			class Compare = std::less<Bound>,
+			class Allocator = std::allocator<ft::pair<const ft::interval<Bound>, T> >
+			>
+	class interval_map {
+		public:
+			typedef Bound bound_type;
+			typedef ft::interval<Bound> key_type;
+			typedef T mapped_type;
+			typedef ft::pair<const key_type, mapped_type> value_type;
+			typedef ft::interval_less<Bound, Compare> key_compare;
+			typedef Allocator allocator_type;
+			typedef std::size_t size_type;
+			typedef std::ptrdiff_t difference_type;
+
+		private:
+			typedef ft::RBTree<key_type, mapped_type, key_compare, allocator_type, ft::max_interval_end<Bound, Compare> > rep_type;
+			typedef typename rep_type::node_type node_type;
+			rep_type t;
+
+			// query [lo, hi) for overlaps, or the single point lo for stab()
+			struct overlap_query {
+				Bound lo, hi;
+				bool point;
+
+				overlap_query(const Bound &lo, const Bound &hi, bool point) : lo(lo), hi(hi), point(point) {}
+
+				// something in the subtree ends after lo
+				bool reaches(const node_type &node) const { return Compare()(lo, node.max_end); }
+				// this interval and every later one start at or after the query end
+				bool past(const node_type &node) const {
+					return point ? Compare()(lo, node.data.first.low) : !Compare()(node.data.first.low, hi);
+				}
+				bool overlaps(const node_type &node) const { return Compare()(lo, node.data.first.high); }
+			};
+
+			struct enter_fn {
+				const overlap_query *q;
+				bool operator()(const node_type &node) const { return q->reaches(node); }
+			};
+
+			template <typename OutputIterator>
+			struct collect_fn {
+				const overlap_query *q;
+				OutputIterator *out;
+				bool operator()(const node_type &node) const {
+					if (q->past(node))
+						return false;
+					if (q->overlaps(node))
+						*(*out)++ = const_iterator(&node);
+					return true;
+				}
+			};
+
+			struct any_fn {
+				const overlap_query *q;
+				bool *found;
+				bool operator()(const node_type &node) const {
+					if (q->past(node))
+						return false;
+					*found = q->overlaps(node);
+					return !*found;
+				}
+			};
+
+			template <typename OutputIterator>
+			OutputIterator query(const overlap_query &q, OutputIterator out) const {
+				enter_fn enter = { &q };
+				collect_fn<OutputIterator> visit = { &q, &out };
+				t.visit_pruned(enter, visit);
+				return out;
+			}
+
+		public:
+			typedef typename rep_type::iterator iterator;
+			typedef typename rep_type::const_iterator const_iterator;
+
+			// constructors
+			explicit interval_map(const allocator_type& alloc = allocator_type()) : t(key_compare(), alloc) {}
+			interval_map(const interval_map& x) : t(x.t) {}
+
+			// destructor
+			~interval_map() {}
+
+			// operators
+			interval_map& operator=(const interval_map& x) {
+				t = x.t;
+				return *this;
+			}
+
+			// iterators, in order of low end
+			iterator begin() { return t.begin(); }
+			iterator end() { return t.end(); }
+			const_iterator begin() const { return t.begin(); }
+			const_iterator end() const { return t.end(); }
+
+			// capacity
+			bool empty() const { return t.empty(); }
+			size_type size() const { return t.size(); }
+
+			// modifiers
+			ft::pair<iterator, bool> insert(const value_type& x) { return t.insert(x); }
+			ft::pair<iterator, bool> insert(const Bound& low, const Bound& high, const mapped_type& v) {
+				return t.insert(value_type(key_type(low, high), v));
+			}
+			void erase(iterator position) { t.erase(position); }
+			size_type erase(const key_type& x) { return t.remove(x); }
+			void swap(interval_map& x) { t.swap(x.t); }
+			void clear() { t.clear(); }
+
+			// operations
+			iterator find(const key_type& x) { return t.find(x); }
+			const_iterator find(const key_type& x) const { return t.find(x); }
+			// write a const_iterator to every interval overlapping [lo, hi)
+			// to out, in order of low end
+			template <class OutputIterator>
+			OutputIterator find_overlaps(const Bound& lo, const Bound& hi, OutputIterator out) const {
+				return query(overlap_query(lo, hi, false), out);
+			}
+			// whether any interval overlaps [lo, hi), stops at the first one
+			bool overlaps(const Bound& lo, const Bound& hi) const {
+				overlap_query q(lo, hi, false);
+				bool found = false;
+				enter_fn enter = { &q };
+				any_fn visit = { &q, &found };
+				t.visit_pruned(enter, visit);
+				return found;
+			}
+			// write a const_iterator to every interval containing point to out
+			template <class OutputIterator>
+			OutputIterator stab(const Bound& point, OutputIterator out) const {
+				return query(overlap_query(point, point, true), out);
+			}
+
+			// allocator
+			allocator_type get_allocator() const { return t.get_allocator(); }
+	};
+
+	template <class Bound, class T, class Compare, class Allocator>
+	void swap(interval_map<Bound, T, Compare, Allocator> &lhs, interval_map<Bound, T, Compare, Allocator> &rhs) {
+		lhs.swap(rhs);
+	}
+}
@@ -1,4 +1,9 @@
 #pragma once
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <type_traits>
+#include <utility>
 #include "./pair.hpp"
 #include "./RBTree.hpp"
 
@@ -8,7 +13,7 @@ namespace ft {
 			class Key,
 			class T,
 			class Compare = std::less<Key>,
-			class Allocator = std::allocator<std::pair<const Key, T>>
+			class Allocator = std::allocator<ft::pair<const Key, T> >
 			>
 	class map {
 		public:
@@ -17,101 +22,253 @@ namespace ft {
 			typedef ft::pair<const key_type, mapped_type> value_type;
 			typedef Compare key_compare;
 			typedef Allocator allocator_type;
-			typedef typename allocator_type::reference reference;
-			typedef typename allocator_type::const_reference const_reference;
-			typedef typename allocator_type::pointer pointer;
-			typedef typename allocator_type::const_pointer const_pointer;
-			typedef typename allocator_type::difference_type difference_type;
-			typedef typename allocator_type::size_type size_type;
-
-		// class value_compare : public std::binary_function<value_type, value_type, bool> {
-		// 	friend class map;
-		// 	protected:
-		// 		Compare comp;
-		// 		value_compare(Compare c) : comp(c) {}
-		// 	public:
-		// 		typedef bool result_type;
-		// 		typedef value_type first_argument_type;
-		// 		typedef value_type second_argument_type;
-		// 		bool operator()(const value_type& x, const value_type& y) const {
-		// 			return comp(x.first, y.first);
-		// 		}
-		// };
-		// private:	
-		// 	typedef ft::RBTree<value_type, value_compare, allocator_type> rep_type;
-		// 	rep_type t;
-
-		
-		// public:
+			typedef value_type& reference;
+			typedef const value_type& const_reference;
+			typedef typename std::allocator_traits<allocator_type>::pointer pointer;
+			typedef typename std::allocator_traits<allocator_type>::const_pointer const_pointer;
+			typedef std::ptrdiff_t difference_type;
+			typedef std::size_t size_type;
+
+		class value_compare {
+			friend class map;
+			protected:
+				Compare comp;
+				value_compare(Compare c) : comp(c) {}
+			public:
+				typedef bool result_type;
+				typedef value_type first_argument_type;
+				typedef value_type second_argument_type;
+				bool operator()(const value_type& x, const value_type& y) const {
+					return comp(x.first, y.first);
+				}
+		};
+
+		private:
+			typedef ft::RBTree<key_type, mapped_type, key_compare, allocator_type> rep_type;
+			rep_type t;
+
+			// the greater half of a split
+			explicit map(rep_type&& x) : t(std::move(x)) {}
+
+		public:
+			typedef typename rep_type::iterator iterator;
+			typedef typename rep_type::const_iterator const_iterator;
+			typedef typename rep_type::reverse_iterator reverse_iterator;
+			typedef typename rep_type::const_reverse_iterator const_reverse_iterator;
+			typedef typename rep_type::node_handle node_type;
+			typedef typename rep_type::insert_return_type insert_return_type;
+
 			// constructors
-			// explicit map(const key_compare& comp = key_compare(), const allocator_type& alloc = allocator_type()) : t(comp, alloc) {}
-			// template <class InputIterator>
-			// map(InputIterator first, InputIterator last, const key_compare& comp = key_compare(), const allocator_type& alloc = allocator_type()) : t(comp, alloc) {
-			// 	t.insert_unique(first, last);
-			// }
-			// map(const map& x) : t(x.t) {}
-
-		// {	// iterators
-		// 	typedef typename rep_type::iterator iterator;
-		// 	typedef typename rep_type::const_iterator const_iterator;
-		// 	iterator begin() { return t.begin(); }
-		// 	iterator end() { return t.end(); }
-		// 	const_iterator begin() const { return t.begin(); }
-		// 	const_iterator end() const { return t.end(); }
-		// 	// reverse_iterator rbegin() { return t.rbegin(); }
-		// 	// reverse_iterator rend() { return t.rend(); }
-		// 	// const_reverse_iterator rbegin() const { return t.rbegin(); }
-		// 	// const_reverse_iterator rend() const { return t.rend(); }
-
-		// 	// capacity
-		// 	bool empty() const { return t.empty(); }
-		// 	size_type size() const { return t.size(); }
-		// 	size_type max_size() const { return t.max_size(); }
-
-		// 	// element access
-		// 	mapped_type& operator[](const key_type& k) {
-		// 		return (*((insert(ft::make_pair(k, mapped_type()))).first)).second;
-		// 	}
-
-		// 	// modifiers
-		// 	ft::pair<iterator, bool> insert(const value_type& x) { return t.insert_unique(x); }
-		// 	iterator insert(iterator position, const value_type& x) { return t.insert_unique(position, x); }
-		// 	template <class InputIterator>
-		// 	void insert(InputIterator first, InputIterator last) { t.insert_unique(first, last); }
-		// 	void erase(iterator position) { t.erase(position); }
-		// 	size_type erase(const key_type& x) { return t.erase(x); }
-		// 	void erase(iterator first, iterator last) { t.erase(first, last); }
-		// 	void swap(map& x) { t.swap(x.t); }
-		// 	void clear() { t.clear(); }
-
-		// 	// observers
-		// 	key_compare key_comp() const { return t.key_comp(); }
-		// 	value_compare value_comp() const { return t.value_comp(); }
-
-		// 	// operations
-		// 	iterator find(const key_type& x) { return t.find(x); }
-		// 	const_iterator find(const key_type& x) const { return t.find(x); }
-		// 	size_type count(const key_type& x) const { return t.count(x); }
-		// 	iterator lower_bound(const key_type& x) { return t.lower_bound(x); }
-		// 	const_iterator lower_bound(const key_type& x) const { return t.lower_bound(x); }
-		// 	iterator upper_bound(const key_type& x) { return t.upper_bound(x); }
-		// 	const_iterator upper_bound(const key_type& x) const { return t.upper_bound(x); }
-		// 	ft::pair<iterator, iterator> equal_range(const key_type& x) { return t.equal_range(x); }
-		// 	ft::pair<const_iterator, const_iterator> equal_range(const key_type& x) const { return t.equal_range(x); }
-
-		// 	// allocator
-		// 	allocator_type get_allocator() const { return t.get_allocator(); }
-
-		// 	// operators
-		// 	map& operator=(const map& x) {
-		// 		t = x.t;
-		// 		return *this;
-		// 	}
-		// }
+			explicit map(const key_compare& comp = key_compare(), const allocator_type& alloc = allocator_type()) : t(comp, alloc) {}
+			template <class InputIterator>
+			map(InputIterator first, InputIterator last, const key_compare& comp = key_compare(), const allocator_type& alloc = allocator_type()) : t(first, last, comp, alloc) {}
+			map(const map& x) : t(x.t) {}
+			// x is left empty
+			map(map&& x) : t(std::move(x.t)) {}
+
 			// destructor
-			// ~map() {
-			// 	t.clear();
-			// }		
-		
+			~map() {}
+
+			// operators
+			map& operator=(const map& x) {
+				t = x.t;
+				return *this;
+			}
+			map& operator=(map&& x) {
+				t = std::move(x.t);
+				return *this;
+			}
+
+			// iterators
+			iterator begin() { return t.begin(); }
+			iterator end() { return t.end(); }
+			const_iterator begin() const { return t.begin(); }
+			const_iterator end() const { return t.end(); }
+			reverse_iterator rbegin() { return t.rbegin(); }
+			reverse_iterator rend() { return t.rend(); }
+			const_reverse_iterator rbegin() const { return t.rbegin(); }
+			const_reverse_iterator rend() const { return t.rend(); }
+
+			// capacity
+			bool empty() const { return t.empty(); }
+			// O(1), but the first call after a split, or after a join or a
+			// range erase of a split map, counts the elements in O(n)
+			size_type size() const { return t.size(); }
+			size_type max_size() const { return t.max_size(); }
+			// introspection of the tree, see RBTree
+			size_type height() const { return t.height(); }
+			size_type black_height() const { return t.black_height(); }
+			bool validate() const { return t.validate(); }
+
+			// element access
+			mapped_type& operator[](const key_type& k) { return t[k]; }
+			mapped_type& operator[](key_type&& k) { return t[std::move(k)]; }
+			mapped_type& at(const key_type& k) { return t.at(k); }
+			const mapped_type& at(const key_type& k) const { return t.at(k); }
+
+			// modifiers
+			ft::pair<iterator, bool> insert(const value_type& x) { return t.insert(x); }
+			ft::pair<iterator, bool> insert(value_type&& x) { return t.insert(std::move(x)); }
+			iterator insert(iterator position, const value_type& x) { return t.insert(position, x); }
+			iterator insert(iterator position, value_type&& x) { return t.insert(position, std::move(x)); }
+			// the element is built in place in its node
+			template <class... Args>
+			ft::pair<iterator, bool> emplace(Args&&... args) { return t.emplace(std::forward<Args>(args)...); }
+			// nothing is built, and args are not moved from, if k is present
+			template <class... Args>
+			ft::pair<iterator, bool> try_emplace(const key_type& k, Args&&... args) { return t.try_emplace(k, std::forward<Args>(args)...); }
+			template <class... Args>
+			ft::pair<iterator, bool> try_emplace(key_type&& k, Args&&... args) { return t.try_emplace(std::move(k), std::forward<Args>(args)...); }
+			template <class M>
+			ft::pair<iterator, bool> insert_or_assign(const key_type& k, M&& obj) { return t.insert_or_assign(k, std::forward<M>(obj)); }
+			template <class M>
+			ft::pair<iterator, bool> insert_or_assign(key_type&& k, M&& obj) { return t.insert_or_assign(std::move(k), std::forward<M>(obj)); }
+			template <class InputIterator>
+			void insert(InputIterator first, InputIterator last) {
+				// hinting at end() makes sorted input amortized O(1) per element
+				for (; first != last; ++first)
+					t.insert(t.end(), *first);
+			}
+			void erase(iterator position) { t.erase(position); }
+			size_type erase(const key_type& x) { return t.remove(x); }
+			// O(log n + k) for k erased elements
+			void erase(iterator first, iterator last) { t.erase(first, last); }
+			// heterogeneous erase, never chosen for an iterator argument
+			template <class K>
+			typename ft::transparent_lookup<Compare, K, typename std::enable_if<!std::is_convertible<const K&, const_iterator>::value, size_type>::type>::type
+			erase(const K& x) { return t.remove(x); }
+			// node handles, the element is neither copied nor reallocated
+			node_type extract(iterator position) { return t.extract(position); }
+			node_type extract(const key_type& x) { return t.extract(x); }
+			insert_return_type insert(node_type&& nh) { return t.insert(std::move(nh)); }
+			// splice in every element of source whose key is not here yet
+			void merge(map& source) { t.merge(source.t); }
+			// keep the elements whose key is less than x and return the
+			// others, O(log n) without copying any element. neither half
+			// knows its size until size() counts it, see size()
+			map split(const key_type& x) { return map(t.split(x)); }
+			// append greater, all of whose keys must be greater than the
+			// ones here, O(log n). greater is left empty
+			void join(map& greater) { t.join(greater.t); }
+			// bulk set operations in parallel on workers, see RBTree.
+			// add the elements of other whose key isn't here, other is left empty
+			void union_with(map& other, thread_pool& workers = thread_pool::shared()) { t.union_with(other.t, workers); }
+			// keep the elements whose key is in other
+			void intersect(const map& other, thread_pool& workers = thread_pool::shared()) { t.intersect(other.t, workers); }
+			// remove the elements whose key is in other
+			void difference(const map& other, thread_pool& workers = thread_pool::shared()) { t.difference(other.t, workers); }
+			// call fn(value_type&) on every element from the threads of
+			// workers, in no particular order
+			template <class Function>
+			void parallel_for_each(Function fn, thread_pool& workers = thread_pool::shared()) { t.parallel_for_each(fn, workers); }
+			template <class Function>
+			void parallel_for_each(Function fn, thread_pool& workers = thread_pool::shared()) const { t.parallel_for_each(fn, workers); }
+			void swap(map& x) { t.swap(x.t); }
+			// replace the contents, O(n) when the range is sorted by key
+			template <class InputIterator>
+			void assign_sorted(InputIterator first, InputIterator last) { t.assign_sorted(first, last); }
+			// the same built in parallel on workers when the range has random access
+			template <class InputIterator>
+			void assign_sorted(InputIterator first, InputIterator last, thread_pool& workers) { t.assign_sorted(first, last, workers); }
+			// large maps are torn down on the shared pool
+			void clear() { t.clear(); }
+			void clear(thread_pool& workers) { t.clear(workers); }
+
+			// observers
+			key_compare key_comp() const { return t.key_comp(); }
+			value_compare value_comp() const { return value_compare(t.key_comp()); }
+
+			// operations
+			iterator find(const key_type& x) { return t.find(x); }
+			const_iterator find(const key_type& x) const { return t.find(x); }
+			size_type count(const key_type& x) const { return t.contains(x) ? 1 : 0; }
+			bool contains(const key_type& x) const { return t.contains(x); }
+			// one iterator per key of [first, last) to out, end() when absent.
+			// the searches are interleaved, which hides the cache misses of
+			// large maps
+			template <class ForwardIterator, class OutputIterator>
+			OutputIterator find_batch(ForwardIterator first, ForwardIterator last, OutputIterator out) { return t.find_batch(first, last, out); }
+			template <class ForwardIterator, class OutputIterator>
+			OutputIterator find_batch(ForwardIterator first, ForwardIterator last, OutputIterator out) const { return t.find_batch(first, last, out); }
+			iterator lower_bound(const key_type& x) { return t.lower_bound(x); }
+			const_iterator lower_bound(const key_type& x) const { return t.lower_bound(x); }
+			iterator upper_bound(const key_type& x) { return t.upper_bound(x); }
+			const_iterator upper_bound(const key_type& x) const { return t.upper_bound(x); }
+			ft::pair<iterator, iterator> equal_range(const key_type& x) { return t.equal_range(x); }
+			ft::pair<const_iterator, const_iterator> equal_range(const key_type& x) const { return t.equal_range(x); }
+
+			// heterogeneous lookups, for comparators with is_transparent
+			// (std::less<>, ...): x is anything the comparator orders against
+			// key_type, so no key_type temporary is built
+			template <class K>
+			typename ft::transparent_lookup<Compare, K, iterator>::type find(const K& x) { return t.find(x); }
+			template <class K>
+			typename ft::transparent_lookup<Compare, K, const_iterator>::type find(const K& x) const { return t.find(x); }
+			template <class K>
+			typename ft::transparent_lookup<Compare, K, size_type>::type count(const K& x) const { return t.contains(x) ? 1 : 0; }
+			template <class K>
+			typename ft::transparent_lookup<Compare, K, bool>::type contains(const K& x) const { return t.contains(x); }
+			template <class K>
+			typename ft::transparent_lookup<Compare, K, iterator>::type lower_bound(const K& x) { return t.lower_bound(x); }
+			template <class K>
+			typename ft::transparent_lookup<Compare, K, const_iterator>::type lower_bound(const K& x) const { return t.lower_bound(x); }
+			template <class K>
+			typename ft::transparent_lookup<Compare, K, iterator>::type upper_bound(const K& x) { return t.upper_bound(x); }
+			template <class K>
+			typename ft::transparent_lookup<Compare, K, const_iterator>::type upper_bound(const K& x) const { return t.upper_bound(x); }
+			template <class K>
+			typename ft::transparent_lookup<Compare, K, ft::pair<iterator, iterator> >::type equal_range(const K& x) { return t.equal_range(x); }
+			template <class K>
+			typename ft::transparent_lookup<Compare, K, ft::pair<const_iterator, const_iterator> >::type equal_range(const K& x) const { return t.equal_range(x); }
+
+			// allocator
+			allocator_type get_allocator() const { return t.get_allocator(); }
 	};
-}
\ No newline at end of file
+
+	template <class Key, class T, class Compare, class Allocator>
+	bool operator==(const map<Key, T, Compare, Allocator> &lhs, const map<Key, T, Compare, Allocator> &rhs) {
+		return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+	}
+
+	template <class Key, class T, class Compare, class Allocator>
+	bool operator!=(const map<Key, T, Compare, Allocator> &lhs, const map<Key, T, Compare, Allocator> &rhs) {
+		return !(lhs == rhs);
+	}
+
+	template <class Key, class T, class Compare, class Allocator>
+	bool operator<(const map<Key, T, Compare, Allocator> &lhs, const map<Key, T, Compare, Allocator> &rhs) {
+		return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+	}
+
+	template <class Key, class T, class Compare, class Allocator>
+	bool operator<=(const map<Key, T, Compare, Allocator> &lhs, const map<Key, T, Compare, Allocator> &rhs) {
+		return !(rhs < lhs);
+	}
+
+	template <class Key, class T, class Compare, class Allocator>
+	bool operator>(const map<Key, T, Compare, Allocator> &lhs, const map<Key, T, Compare, Allocator> &rhs) {
+		return rhs < lhs;
+	}
+
+	template <class Key, class T, class Compare, class Allocator>
+	bool operator>=(const map<Key, T, Compare, Allocator> &lhs, const map<Key, T, Compare, Allocator> &rhs) {
+		return !(lhs < rhs);
+	}
+
+	template <class Key, class T, class Compare, class Allocator>
+	void swap(map<Key, T, Compare, Allocator> &lhs, map<Key, T, Compare, Allocator> &rhs) {
+		lhs.swap(rhs);
+	}
+
+	// call fn on every element of m from the threads of workers, in no
+	// particular order. fn must be safe to call concurrently
+	template <class Key, class T, class Compare, class Allocator, class Function>
+	void parallel_for_each(map<Key, T, Compare, Allocator> &m, Function fn, thread_pool &workers = thread_pool::shared()) {
+		m.parallel_for_each(fn, workers);
+	}
+
+	template <class Key, class T, class Compare, class Allocator, class Function>
+	void parallel_for_each(const map<Key, T, Compare, Allocator> &m, Function fn, thread_pool &workers = thread_pool::shared()) {
+		m.parallel_for_each(fn, workers);
+	}
+}
@@ -0,0 +1,416 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "./pair.hpp"
+#include "./map.hpp"
+#include "./simd_lower_bound.hpp"
+
+namespace ft {
+
+	// read-only map over a file written by save_map(), mapped into memory
+	// and searched where it lies: opening it reads the header only (and the
+	// whole file once when verifying the checksum), the pages of the keys a
+	// lookup touches come from the page cache as it goes. the keys and the
+	// values are two sorted arrays, searched like flat_map's.
+	//
+	// the file holds trivially copyable keys and values as they are in
+	// memory, so it is only read back by the same build on the same kind
+	// of machine, which the header checks as far as it can (format version,
+	// byte order, sizes and alignments), and with the same Compare.
+	//
+	// layout, every offset a multiple of 64:
+	//   header, keys[count], padding, values[count], padding
+	template<
+			class Key,
+			class T,
+			class Compare = std::less<Key>
+			>
+	class mapped_map : private CompareHolder<Compare> {
+		public:
+			typedef Key key_type;
+			typedef T mapped_type;
+			typedef ft::pair<const key_type, mapped_type> value_type;
+			typedef Compare key_compare;
+			typedef ft::pair<const key_type&, const mapped_type&> reference;
+			typedef reference const_reference;
+			typedef std::ptrdiff_t difference_type;
+			typedef std::size_t size_type;
+
+			// bumped whenever the layout changes, older files are refused
+			static const std::uint32_t format_version = 1;
+
+		private:
+			struct file_header {
+				char magic[8];
+				std::uint32_t version;
+				std::uint32_t byteOrder;
+				std::uint32_t keySize;
+				std::uint32_t keyAlign;
+				std::uint32_t valueSize;
+				std::uint32_t valueAlign;
+				std::uint64_t count;
+				std::uint64_t keysOffset;
+				std::uint64_t valuesOffset;
+				std::uint64_t fileSize;
+				// of everything after the header
+				std::uint64_t payloadChecksum;
+				// of the fields above
+				std::uint64_t headerChecksum;
+			};
+
+			static const std::uint32_t byteOrderMark = 0x01020304;
+			static const std::size_t sectionAlign = 64;
+
+			const void *_data;
+			std::size_t _length;
+			const Key *_keys;
+			const T *_values;
+			size_type _size;
+
+			static void checkTypes() {
+				static_assert(std::is_trivially_copyable<Key>::value, "mapped_map keys must be trivially copyable");
+				static_assert(std::is_trivially_copyable<T>::value, "mapped_map values must be trivially copyable");
+			}
+			static std::uint64_t alignUp(std::uint64_t n) { return (n + sectionAlign - 1) / sectionAlign * sectionAlign; }
+			// word at a time multiply and shift mix, len a multiple of 8
+			static std::uint64_t checksum(std::uint64_t h, const unsigned char *p, std::size_t len) {
+				for (std::size_t i = 0; i < len; i += 8) {
+					std::uint64_t w;
+					std::memcpy(&w, p + i, 8);
+					h = (h ^ w) * 0x9e3779b97f4a7c15ull;
+					h ^= h >> 29;
+				}
+				return h;
+			}
+			static std::uint64_t headerChecksumOf(const file_header &h) {
+				return checksum(0, reinterpret_cast<const unsigned char *>(&h), offsetof(file_header, headerChecksum));
+			}
+			static void fail(const char *what) { throw std::runtime_error(std::string("mapped_map: ") + what); }
+
+			// buffered file output that checksums what it writes
+			class file_writer {
+				public:
+					std::uint64_t sum;
+
+					explicit file_writer(std::FILE *f) : sum(0), _file(f), _used(0) {}
+					void write(const void *p, std::size_t n) {
+						const unsigned char *bytes = static_cast<const unsigned char *>(p);
+						while (n > 0) {
+							std::size_t chunk = std::min(n, sizeof(_buffer) - _used);
+							std::memcpy(_buffer + _used, bytes, chunk);
+							_used += chunk;
+							bytes += chunk;
+							n -= chunk;
+							if (_used == sizeof(_buffer))
+								flush();
+						}
+					}
+					void pad(std::uint64_t written) {
+						static const unsigned char zeros[sectionAlign] = {};
+						write(zeros, alignUp(written) - written);
+					}
+					void flush() {
+						sum = checksum(sum, _buffer, _used);
+						if (_used != 0 && std::fwrite(_buffer, 1, _used, _file) != _used)
+							fail("write failed");
+						_used = 0;
+					}
+
+				private:
+					std::FILE *_file;
+					std::size_t _used;
+					unsigned char _buffer[1 << 16];
+			};
+
+			void open(const char *path, bool verify);
+			void close() {
+				if (_data != NULL)
+					::munmap(const_cast<void *>(_data), _length);
+				_data = NULL;
+				_length = 0;
+				_keys = NULL;
+				_values = NULL;
+				_size = 0;
+			}
+
+			// holds a pair of references so that it->first works
+			struct arrow_proxy {
+				reference ref;
+				arrow_proxy(const reference &ref) : ref(ref) {}
+				reference* operator->() { return &ref; }
+			};
+
+			// index of the first key not less than key
+			size_type lowerBound(const Key &key) const {
+				return ft::sorted_lower_bound(_keys, _size, key, this->compare());
+			}
+			// index of the first key greater than key
+			size_type upperBound(const Key &key) const {
+				size_type i = lowerBound(key);
+				return (i < _size && !this->compare()(key, _keys[i])) ? i + 1 : i;
+			}
+			// index of key, size() if absent
+			size_type indexOf(const Key &key) const {
+				size_type i = lowerBound(key);
+				return (i < _size && !this->compare()(key, _keys[i])) ? i : _size;
+			}
+
+		public:
+		class const_iterator {
+			public:
+				typedef std::ptrdiff_t difference_type;
+				typedef typename mapped_map::value_type value_type;
+				typedef typename mapped_map::const_reference reference;
+				typedef arrow_proxy pointer;
+				typedef std::random_access_iterator_tag iterator_category;
+
+				// default constructor
+				const_iterator() : key(NULL), value(NULL) {}
+
+				reference operator*() const { return reference(*key, *value); }
+				pointer operator->() const { return pointer(**this); }
+				reference operator[](difference_type n) const { return reference(key[n], value[n]); }
+
+				const_iterator& operator++() { ++key; ++value; return *this; }
+				const_iterator operator++(int) { const_iterator tmp(*this); ++*this; return tmp; }
+				const_iterator& operator--() { --key; --value; return *this; }
+				const_iterator operator--(int) { const_iterator tmp(*this); --*this; return tmp; }
+				const_iterator& operator+=(difference_type n) { key += n; value += n; return *this; }
+				const_iterator& operator-=(difference_type n) { key -= n; value -= n; return *this; }
+				const_iterator operator+(difference_type n) const { const_iterator tmp(*this); return tmp += n; }
+				const_iterator operator-(difference_type n) const { const_iterator tmp(*this); return tmp -= n; }
+				difference_type operator-(const const_iterator &other) const { return key - other.key; }
+
+				bool operator==(const const_iterator &other) const { return key == other.key; }
+				bool operator!=(const const_iterator &other) const { return key != other.key; }
+				bool operator<(const const_iterator &other) const { return key < other.key; }
+				bool operator>(const const_iterator &other) const { return key > other.key; }
+				bool operator<=(const const_iterator &other) const { return key <= other.key; }
+				bool operator>=(const const_iterator &other) const { return key >= other.key; }
+
+			private:
+				const Key *key;
+				const T *value;
+
+				const_iterator(const Key *key, const T *value) : key(key), value(value) {}
+
+				friend class mapped_map;
+		};
+
+			// the file can't be modified, both iterators are constant
+			typedef const_iterator iterator;
+			typedef std::reverse_iterator<const_iterator> reverse_iterator;
+			typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+			// constructors
+			mapped_map() : CompareHolder<Compare>(key_compare()), _data(NULL), _length(0), _keys(NULL), _values(NULL), _size(0) {}
+			// map the file at path, throws std::runtime_error if it can't be
+			// read or isn't a map of these types. verify reads it through to
+			// check the payload checksum, without it only the header is
+			// checked and the pages are read on demand
+			explicit mapped_map(const char *path, bool verify = true, const key_compare& comp = key_compare())
+				: CompareHolder<Compare>(comp), _data(NULL), _length(0), _keys(NULL), _values(NULL), _size(0) {
+				open(path, verify);
+			}
+			mapped_map(mapped_map&& x)
+				: CompareHolder<Compare>(x.compare()), _data(x._data), _length(x._length), _keys(x._keys), _values(x._values), _size(x._size) {
+				x._data = NULL;
+				x.close();
+			}
+			mapped_map(const mapped_map&) = delete;
+
+			// destructor
+			~mapped_map() { close(); }
+
+			// operators
+			mapped_map& operator=(mapped_map&& x) {
+				if (this != &x) {
+					close();
+					swap(x);
+				}
+				return *this;
+			}
+			mapped_map& operator=(const mapped_map&) = delete;
+
+			// writes the elements of [first, last), n of them in strictly
+			// increasing key order, to path. the file is written next to
+			// path and renamed over it once complete, so a reader never
+			// sees half of it
+			template <class ForwardIterator>
+			static void write(ForwardIterator first, ForwardIterator last, size_type n, const char *path);
+
+			// iterators
+			const_iterator begin() const { return const_iterator(_keys, _values); }
+			const_iterator end() const { return const_iterator(_keys + _size, _values + _size); }
+			const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+			const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+			// capacity
+			bool empty() const { return _size == 0; }
+			size_type size() const { return _size; }
+
+			// element access
+			const mapped_type& at(const key_type& k) const {
+				size_type i = indexOf(k);
+				if (i == _size)
+					throw std::out_of_range("Key not found");
+				return _values[i];
+			}
+
+			// modifiers
+			void swap(mapped_map& x) {
+				std::swap(this->compare(), x.compare());
+				std::swap(_data, x._data);
+				std::swap(_length, x._length);
+				std::swap(_keys, x._keys);
+				std::swap(_values, x._values);
+				std::swap(_size, x._size);
+			}
+
+			// observers
+			key_compare key_comp() const { return this->compare(); }
+
+			// operations
+			const_iterator find(const key_type& x) const { return begin() + indexOf(x); }
+			size_type count(const key_type& x) const { return indexOf(x) != _size ? 1 : 0; }
+			bool contains(const key_type& x) const { return indexOf(x) != _size; }
+			const_iterator lower_bound(const key_type& x) const { return begin() + lowerBound(x); }
+			const_iterator upper_bound(const key_type& x) const { return begin() + upperBound(x); }
+			ft::pair<const_iterator, const_iterator> equal_range(const key_type& x) const { return ft::pair<const_iterator, const_iterator>(lower_bound(x), upper_bound(x)); }
+	};
+
+	template <class Key, class T, class Compare>
+	template <class ForwardIterator>
+	void mapped_map<Key, T, Compare>::write(ForwardIterator first, ForwardIterator last, size_type n, const char *path) {
+		checkTypes();
+		std::string tmp = std::string(path) + ".tmp";
+		std::FILE *f = std::fopen(tmp.c_str(), "wb");
+		if (f == NULL)
+			fail("can't create the file");
+
+		file_header h;
+		std::memset(&h, 0, sizeof(h));
+		std::memcpy(h.magic, "ftmap\0\0\0", sizeof(h.magic));
+		h.version = format_version;
+		h.byteOrder = byteOrderMark;
+		h.keySize = sizeof(Key);
+		h.keyAlign = alignof(Key);
+		h.valueSize = sizeof(T);
+		h.valueAlign = alignof(T);
+		h.count = n;
+		h.keysOffset = alignUp(sizeof(file_header));
+		h.valuesOffset = h.keysOffset + alignUp(n * sizeof(Key));
+		h.fileSize = h.valuesOffset + alignUp(n * sizeof(T));
+
+		try {
+			// the header goes in last, once the checksum is known
+			static const unsigned char zeros[sectionAlign * 2] = {};
+			static_assert(sizeof(file_header) <= sizeof(zeros), "header larger than its section");
+			if (std::fwrite(zeros, 1, h.keysOffset, f) != h.keysOffset)
+				fail("write failed");
+			file_writer out(f);
+			for (ForwardIterator it = first; it != last; ++it)
+				out.write(&(*it).first, sizeof(Key));
+			out.pad(n * sizeof(Key));
+			for (ForwardIterator it = first; it != last; ++it)
+				out.write(&(*it).second, sizeof(T));
+			out.pad(n * sizeof(T));
+			out.flush();
+			h.payloadChecksum = out.sum;
+			h.headerChecksum = headerChecksumOf(h);
+			if (std::fseek(f, 0, SEEK_SET) != 0 || std::fwrite(&h, 1, sizeof(h), f) != sizeof(h))
+				fail("write failed");
+			if (std::fflush(f) != 0 || ::fsync(::fileno(f)) != 0)
+				fail("write failed");
+		} catch (...) {
+			std::fclose(f);
+			std::remove(tmp.c_str());
+			throw;
+		}
+		if (std::fclose(f) != 0 || std::rename(tmp.c_str(), path) != 0) {
+			std::remove(tmp.c_str());
+			fail("write failed");
+		}
+	}
+
+	template <class Key, class T, class Compare>
+	void mapped_map<Key, T, Compare>::open(const char *path, bool verify) {
+		checkTypes();
+		int fd = ::open(path, O_RDONLY);
+		if (fd < 0)
+			fail("can't open the file");
+		struct stat st;
+		if (::fstat(fd, &st) != 0 || static_cast<std::uint64_t>(st.st_size) < sizeof(file_header)) {
+			::close(fd);
+			fail("not a map file");
+		}
+		_length = static_cast<std::size_t>(st.st_size);
+		void *p = ::mmap(NULL, _length, PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd);
+		if (p == MAP_FAILED) {
+			_length = 0;
+			fail("mmap failed");
+		}
+		_data = p;
+
+		file_header h;
+		std::memcpy(&h, _data, sizeof(h));
+		const char *error = NULL;
+		if (std::memcmp(h.magic, "ftmap\0\0\0", sizeof(h.magic)) != 0 || h.headerChecksum != headerChecksumOf(h))
+			error = "not a map file";
+		else if (h.version != format_version)
+			error = "unsupported format version";
+		else if (h.byteOrder != byteOrderMark)
+			error = "written with another byte order";
+		else if (h.keySize != sizeof(Key) || h.keyAlign != alignof(Key) || h.valueSize != sizeof(T) || h.valueAlign != alignof(T))
+			error = "written for other key or value types";
+		else if (h.fileSize != _length || h.keysOffset != alignUp(sizeof(file_header))
+				|| h.count > _length / (sizeof(Key) + sizeof(T))
+				|| h.valuesOffset != h.keysOffset + alignUp(h.count * sizeof(Key))
+				|| h.fileSize != h.valuesOffset + alignUp(h.count * sizeof(T)))
+			error = "truncated or inconsistent file";
+		else if (verify && checksum(0, static_cast<const unsigned char *>(_data) + h.keysOffset, _length - h.keysOffset) != h.payloadChecksum)
+			error = "checksum mismatch";
+		if (error != NULL) {
+			close();
+			fail(error);
+		}
+		_keys = reinterpret_cast<const Key *>(static_cast<const char *>(_data) + h.keysOffset);
+		_values = reinterpret_cast<const T *>(static_cast<const char *>(_data) + h.valuesOffset);
+		_size = static_cast<size_type>(h.count);
+	}
+
+	template <class Key, class T, class Compare>
+	void swap(mapped_map<Key, T, Compare> &lhs, mapped_map<Key, T, Compare> &rhs) {
+		lhs.swap(rhs);
+	}
+
+	// write the elements of a map in the format mapped_map reads
+	template <class Key, class T, class Compare, class Allocator>
+	void save_map(const map<Key, T, Compare, Allocator> &m, const char *path) {
+		mapped_map<Key, T, Compare>::write(m.begin(), m.end(), m.size(), path);
+	}
+	template <class Key, class T, class Compare, class Allocator, class Augment, class Stats>
+	void save_map(const RBTree<Key, T, Compare, Allocator, Augment, Stats> &t, const char *path) {
+		mapped_map<Key, T, Compare>::write(t.begin(), t.end(), t.size(), path);
+	}
+
+	// read a file written by save_map back into a map, in O(n)
+	template <class Key, class T, class Compare, class Allocator>
+	void load_map(const char *path, map<Key, T, Compare, Allocator> &m, bool verify = true) {
+		mapped_map<Key, T, Compare> file(path, verify, m.key_comp());
+		m.assign_sorted(file.begin(), file.end());
+	}
+}
@@ -0,0 +1,243 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <cstddef>
+#include <algorithm>
+
+namespace ft {
+	// slab allocator for fixed-size tree nodes.
+	// storage is carved out of chunks obtained from Alloc (rebound to the
+	// slot type), released nodes are recycled through an intrusive free list,
+	// and every chunk is handed back to Alloc at once by release().
+	//
+	// the chunks belong to a reference counted arena rather than to the pool
+	// itself, so that nodes can move to another pool (node handles, merge):
+	// the receiving pool adopts the arena, the two arenas become one and its
+	// chunks live until the last pool or node handle using it is gone.
+	// pools that exchanged nodes must have equal allocators.
+	template <typename T, typename Alloc = std::allocator<T> >
+	class node_pool {
+		private:
+			union slot {
+				slot *next;
+				struct {
+					slot *next_chunk;
+					std::size_t count;
+				} chunk;
+				alignas(T) unsigned char storage[sizeof(T)];
+			};
+
+			typedef typename std::allocator_traits<Alloc>::template rebind_alloc<slot> slot_allocator;
+			typedef std::allocator_traits<slot_allocator> slot_traits;
+
+		public:
+			struct arena;
+			// keeps the chunks a node was carved from alive
+			typedef std::shared_ptr<arena> arena_ref;
+
+			// the chunks of one or more pools. adopting an arena moves its
+			// chunks into the adopting one and makes it point there, so
+			// every arena leads to the one owning the chunks (its root)
+			struct arena {
+				slot_allocator alloc;
+				slot *chunks;
+				slot *spare;		// slots of node handles destroyed outside any pool
+				arena_ref parent;	// root it was merged into, NULL for a root
+
+				explicit arena(const slot_allocator &alloc) : alloc(alloc), chunks(NULL), spare(NULL) {}
+				~arena() {
+					while (chunks != NULL) {
+						slot *next = chunks->chunk.next_chunk;
+						slot_traits::deallocate(alloc, chunks, chunks->chunk.count);
+						chunks = next;
+					}
+				}
+			};
+
+		private:
+			typedef typename std::allocator_traits<Alloc>::template rebind_alloc<arena> arena_allocator;
+
+			static const std::size_t min_chunk = 16;
+			static const std::size_t max_chunk = 4096;
+
+			slot_allocator _alloc;
+			arena_ref _arena;	// owns the chunks, created by the first grow
+			slot *_free;		// recycled slots
+			slot *_cursor;		// next never-used slot of the newest chunk
+			slot *_end;			// one past the newest chunk
+			std::size_t _next_chunk;
+			std::size_t _capacity;
+
+			// arenas of every pool are linked and changed under one lock,
+			// which is only taken to add chunks and to move nodes around
+			static std::mutex &arenaLock() {
+				static std::mutex lock;
+				return lock;
+			}
+			// arena owning the chunks of a, arenaLock held
+			static arena *rootOf(arena *a) {
+				while (a->parent)
+					a = a->parent.get();
+				return a;
+			}
+
+			// take the slots node handles gave back to the arena, false if none
+			bool takeSpare() {
+				if (!_arena)
+					return false;
+				std::lock_guard<std::mutex> guard(arenaLock());
+				arena *root = rootOf(_arena.get());
+				if (root->spare == NULL)
+					return false;
+				_free = root->spare;
+				root->spare = NULL;
+				return true;
+			}
+
+			// get a new chunk able to hold at least n objects
+			void grow(std::size_t n) {
+				if (!_arena)
+					_arena = std::allocate_shared<arena>(arena_allocator(_alloc), _alloc);
+				slot *c = slot_traits::allocate(_alloc, n + 1);
+				c->chunk.count = n + 1;
+				{
+					std::lock_guard<std::mutex> guard(arenaLock());
+					arena *root = rootOf(_arena.get());
+					c->chunk.next_chunk = root->chunks;
+					root->chunks = c;
+				}
+				_cursor = c + 1;
+				_end = c + n + 1;
+				_capacity += n;
+			}
+
+			node_pool(const node_pool &);
+			node_pool &operator=(const node_pool &);
+
+		public:
+			typedef T value_type;
+			typedef Alloc allocator_type;
+			typedef std::size_t size_type;
+
+			explicit node_pool(const Alloc &alloc = Alloc())
+				: _alloc(alloc), _arena(), _free(NULL), _cursor(NULL), _end(NULL),
+				  _next_chunk(min_chunk), _capacity(0) {}
+
+			~node_pool() { release(); }
+
+			// raw storage for one T, the caller constructs the object
+			T *allocate() {
+				if (_free == NULL && _cursor == _end && !takeSpare()) {
+					grow(_next_chunk);
+					if (_next_chunk < max_chunk)
+						_next_chunk *= 2;
+				}
+				slot *s;
+				if (_free != NULL) {
+					s = _free;
+					_free = s->next;
+				} else {
+					s = _cursor++;
+				}
+				return reinterpret_cast<T *>(s->storage);
+			}
+
+			// raw storage for n objects in consecutive slots of one chunk,
+			// the i-th is at(first, i). threads can construct into them
+			// without going through the pool
+			T *allocate_block(size_type n) {
+				reserve(n);
+				slot *s = _cursor;
+				_cursor += n;
+				return reinterpret_cast<T *>(s->storage);
+			}
+			static T *at(T *first, size_type i) {
+				return reinterpret_cast<T *>((reinterpret_cast<slot *>(first) + i)->storage);
+			}
+
+			// give back the storage of an already destroyed T
+			void deallocate(T *p) {
+				slot *s = reinterpret_cast<slot *>(p);
+				s->next = _free;
+				_free = s;
+			}
+
+			// make room for n more objects with a single call to the allocator
+			void reserve(size_type n) {
+				if (static_cast<size_type>(_end - _cursor) >= n)
+					return;
+				// the unused tail of the current chunk goes on the free list
+				while (_cursor != _end)
+					deallocate(reinterpret_cast<T *>((_cursor++)->storage));
+				grow(n);
+			}
+
+			// drop every chunk, all objects must be destroyed. the chunks go
+			// back to the allocator unless another pool or a node handle
+			// still uses the arena
+			void release() {
+				_arena.reset();
+				_free = _cursor = _end = NULL;
+				_next_chunk = min_chunk;
+				_capacity = 0;
+			}
+
+			void swap(node_pool &other) {
+				std::swap(_alloc, other._alloc);
+				_arena.swap(other._arena);
+				std::swap(_free, other._free);
+				std::swap(_cursor, other._cursor);
+				std::swap(_end, other._end);
+				std::swap(_next_chunk, other._next_chunk);
+				std::swap(_capacity, other._capacity);
+			}
+
+			// number of objects the chunks this pool obtained can hold
+			size_type capacity() const { return _capacity; }
+
+			// reference that keeps the storage of this pool's objects alive,
+			// NULL while the pool holds no chunk
+			arena_ref share() const { return _arena; }
+
+			// objects allocated from the pools sharing a may be given back
+			// to this pool from now on
+			void adopt(const arena_ref &a) {
+				if (!a || a == _arena)
+					return;
+				if (!_arena) {
+					_arena = a;
+					return;
+				}
+				std::lock_guard<std::mutex> guard(arenaLock());
+				arena *mine = rootOf(_arena.get());
+				arena *theirs = rootOf(a.get());
+				if (mine != theirs) {
+					// splice their chunk and spare lists into ours
+					slot **tail = &mine->chunks;
+					while (*tail != NULL)
+						tail = &(*tail)->chunk.next_chunk;
+					*tail = theirs->chunks;
+					theirs->chunks = NULL;
+					tail = &mine->spare;
+					while (*tail != NULL)
+						tail = &(*tail)->next;
+					*tail = theirs->spare;
+					theirs->spare = NULL;
+					theirs->parent = _arena;
+				}
+			}
+
+			// give back the storage of a destroyed object that left its pool,
+			// it is reused by the next pool of the arena that runs out
+			static void give_back(const arena_ref &a, T *p) {
+				slot *s = reinterpret_cast<slot *>(p);
+				std::lock_guard<std::mutex> guard(arenaLock());
+				arena *root = rootOf(a.get());
+				s->next = root->spare;
+				root->spare = s;
+			}
+
+			allocator_type get_allocator() const { return allocator_type(_alloc); }
+	};
+}
@@ -1,5 +1,10 @@
 #pragma once
 
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
 namespace ft {
 	template <typename KeyType, typename ValueType>
 	class pair {
@@ -14,11 +19,28 @@ namespace ft {
 		pair() : first(), second() {}
 
 		// Copy constructor
+		pair(const pair &p) : first(p.first), second(p.second) {}
+
+		// Move constructor (a const first is still copied)
+		pair(pair &&p) : first(std::forward<key_type>(p.first)), second(std::forward<value_type>(p.second)) {}
+
+		// Converting constructors
 		template <typename U, typename V>
 		pair(const pair<U, V> &p) : first(p.first), second(p.second) {}
+		template <typename U, typename V>
+		pair(pair<U, V> &&p) : first(std::forward<U>(p.first)), second(std::forward<V>(p.second)) {}
 
-		// Parameterized constructor
+		// Parameterized constructors, the second one forwards its arguments
 		pair(const key_type &k, const value_type &v) : first(k), second(v) {}
+		template <typename U, typename V, typename = typename std::enable_if<
+			std::is_constructible<key_type, U&&>::value && std::is_constructible<value_type, V&&>::value>::type>
+		pair(U &&k, V &&v) : first(std::forward<U>(k)), second(std::forward<V>(v)) {}
+
+		// Piecewise constructor: first and second are built in place from
+		// the arguments packed in each tuple (std::forward_as_tuple)
+		template <typename... Args1, typename... Args2>
+		pair(std::piecewise_construct_t, std::tuple<Args1...> a, std::tuple<Args2...> b)
+			: pair(a, b, std::index_sequence_for<Args1...>(), std::index_sequence_for<Args2...>()) {}
 
 		// Assignment operator
 		pair &operator=(const pair &p) {
@@ -28,11 +50,24 @@ namespace ft {
 			}
 			return *this;
 		}
+
+		// Move assignment operator
+		pair &operator=(pair &&p) {
+			first = std::forward<key_type>(p.first);
+			second = std::forward<value_type>(p.second);
+			return *this;
+		}
+
+	private:
+		template <typename Tuple1, typename Tuple2, std::size_t... I1, std::size_t... I2>
+		pair(Tuple1 &a, Tuple2 &b, std::index_sequence<I1...>, std::index_sequence<I2...>)
+			: first(std::forward<typename std::tuple_element<I1, Tuple1>::type>(std::get<I1>(a))...),
+			  second(std::forward<typename std::tuple_element<I2, Tuple2>::type>(std::get<I2>(b))...) {}
 	};
 
 	template <typename KeyType, typename ValueType>
 	pair<KeyType, ValueType> make_pair(KeyType k, ValueType v) {
-		return (pair<KeyType, ValueType>(k, v));
+		return (pair<KeyType, ValueType>(std::move(k), std::move(v)));
 	}
 
 	template <typename KeyType, typename ValueType>
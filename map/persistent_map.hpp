@@ -0,0 +1,526 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <cassert>
+#include "./pair.hpp"
+#include "./RBTree.hpp"
+
+namespace ft {
+
+	// red-black tree whose nodes are never changed once two versions share
+	// them: an update copies the path from the root to the node it changes
+	// (O(log n) new nodes) and leaves every other version as it was, so a
+	// copy of the map is O(1) and behaves like a frozen snapshot of it.
+	//
+	// nodes are reference counted, atomically, so a snapshot can be read and
+	// dropped on any thread without locking while the map it came from goes
+	// on changing. the map object itself is not thread safe: the writer
+	// takes snapshot()s and hands them to readers. nodes only the updating
+	// version holds are changed in place instead of copied.
+	//
+	// the balancing follows Okasaki's insertion and Kahrs' deletion for
+	// functional red-black trees. elements are copied along the path, keep
+	// the mapped type cheap to copy (or behind a shared pointer).
+	template<
+			class Key,
+			class T,
+			class Compare = std::less<Key>,
+			class Allocator = std::allocator<ft::pair<const Key, T> >
+			>
+	class persistent_map : private CompareHolder<Compare> {
+		public:
+			typedef Key key_type;
+			typedef T mapped_type;
+			typedef ft::pair<const key_type, mapped_type> value_type;
+			typedef Compare key_compare;
+			typedef Allocator allocator_type;
+			typedef const value_type& reference;
+			typedef const value_type& const_reference;
+			typedef std::ptrdiff_t difference_type;
+			typedef std::size_t size_type;
+
+		private:
+			struct node {
+				std::atomic<size_type> refs;
+				node *left;		// both children are counted references
+				node *right;
+				Color color;
+				value_type data;
+
+				template <typename... Args>
+				node(Color color, node *left, node *right, Args&&... args)
+					: refs(1), left(left), right(right), color(color), data(std::forward<Args>(args)...) {}
+			};
+
+			typedef typename std::allocator_traits<Allocator>::template rebind_alloc<node> node_allocator;
+			typedef std::allocator_traits<node_allocator> node_traits;
+
+			node *_root;
+			size_type _size;
+			node_allocator _alloc;
+
+			static bool isRed(const node *x) { return x != NULL && x->color == RED; }
+			static bool isBlack(const node *x) { return x != NULL && x->color == BLACK; }
+			bool keyLess(const Key &a, const Key &b) const { return this->compare()(a, b); }
+
+			// reference counting, every function below takes and returns
+			// owned references unless a parameter is const
+			static node* share(node *x) {
+				if (x != NULL)
+					x->refs.fetch_add(1, std::memory_order_relaxed);
+				return x;
+			}
+			void drop(node *x);
+			template <typename... Args>
+			node* make(Color color, node *left, node *right, Args&&... args);
+			// a child of x for reuse: taken out of x when x is ours alone,
+			// shared otherwise
+			static node* takeLeft(node *x);
+			static node* takeRight(node *x);
+			// x with a new color and children, in place when x is ours alone,
+			// as a copy otherwise. x's previous children are dropped
+			node* remake(node *x, Color color, node *left, node *right);
+			node* blacken(node *x) { return remake(x, BLACK, takeLeft(x), takeRight(x)); }
+			node* redden(node *x) { return remake(x, RED, takeLeft(x), takeRight(x)); }
+
+			// balance a black node x of children a and b, one of which may
+			// have a red child under a red root
+			node* balance(node *a, node *x, node *b);
+			// rebalance x after its left (balLeft) or right (balRight)
+			// subtree lost one black level
+			node* balLeft(node *a, node *x, node *b);
+			node* balRight(node *a, node *x, node *b);
+			// concatenation of two subtrees of the same black height
+			node* append(node *a, node *b);
+
+			// the path to the new element copied from s
+			node* insertPath(const node *s, const value_type &v);
+			// the path to key copied from s, key's node without it
+			node* erasePath(const node *s, const Key &key);
+			// the path to key copied from s, key's node holding v
+			template <typename M>
+			node* assignPath(const node *s, const Key &key, M &&obj);
+			// node of key or NULL
+			const node* findNode(const Key &key) const;
+
+		public:
+			class const_iterator {
+				public:
+					typedef std::ptrdiff_t difference_type;
+					typedef typename persistent_map::value_type value_type;
+					typedef const value_type* pointer;
+					typedef const value_type& reference;
+					typedef std::forward_iterator_tag iterator_category;
+
+					const_iterator() : depth(0) {}
+					const_iterator(const const_iterator &other) : depth(other.depth) {
+						for (size_type i = 0; i < depth; ++i)
+							path[i] = other.path[i];
+					}
+					const_iterator& operator=(const const_iterator &other) {
+						depth = other.depth;
+						for (size_type i = 0; i < depth; ++i)
+							path[i] = other.path[i];
+						return *this;
+					}
+
+					reference operator*() const { return path[depth - 1]->data; }
+					pointer operator->() const { return &path[depth - 1]->data; }
+					const_iterator& operator++() {
+						const node *x = path[--depth]->right;
+						pushLeft(x);
+						return *this;
+					}
+					const_iterator operator++(int) { const_iterator tmp(*this); ++*this; return tmp; }
+
+					bool operator==(const const_iterator &other) const {
+						return depth == other.depth && (depth == 0 || path[depth - 1] == other.path[depth - 1]);
+					}
+					bool operator!=(const const_iterator &other) const { return !(*this == other); }
+
+				private:
+					// the nodes still to visit above the current one, which is
+					// on top: an iterator doesn't need parent links
+					static const size_type maxDepth = 2 * std::numeric_limits<size_type>::digits;
+					const node *path[maxDepth];
+					size_type depth;
+
+					void pushLeft(const node *x) {
+						for (; x != NULL; x = x->left)
+							path[depth++] = x;
+					}
+
+					friend class persistent_map;
+			};
+			typedef const_iterator iterator;
+
+			// constructors
+			explicit persistent_map(const key_compare& comp = key_compare(), const allocator_type& alloc = allocator_type())
+				: CompareHolder<Compare>(comp), _root(NULL), _size(0), _alloc(alloc) {}
+			// O(1), the two maps share every node until either changes
+			persistent_map(const persistent_map& x)
+				: CompareHolder<Compare>(x.compare()), _root(share(x._root)), _size(x._size), _alloc(x._alloc) {}
+			persistent_map(persistent_map&& x)
+				: CompareHolder<Compare>(x.compare()), _root(x._root), _size(x._size), _alloc(x._alloc) {
+				x._root = NULL;
+				x._size = 0;
+			}
+
+			// destructor
+			~persistent_map() { drop(_root); }
+
+			// operators
+			persistent_map& operator=(const persistent_map& x) {
+				node *old = _root;
+				_root = share(x._root);
+				_size = x._size;
+				this->compare() = x.compare();
+				drop(old);
+				return *this;
+			}
+			persistent_map& operator=(persistent_map&& x) {
+				if (this != &x) {
+					drop(_root);
+					_root = x._root;
+					_size = x._size;
+					this->compare() = x.compare();
+					x._root = NULL;
+					x._size = 0;
+				}
+				return *this;
+			}
+
+			// the current version, O(1). it doesn't see later updates
+			persistent_map snapshot() const { return *this; }
+
+			// iterators
+			const_iterator begin() const {
+				const_iterator it;
+				it.pushLeft(_root);
+				return it;
+			}
+			const_iterator end() const { return const_iterator(); }
+
+			// capacity
+			bool empty() const { return _size == 0; }
+			size_type size() const { return _size; }
+
+			// modifiers, O(log n) new nodes each
+			// false, and nothing changed, if the key is already there
+			bool insert(const value_type& x) {
+				if (findNode(x.first) != NULL)
+					return false;
+				node *updated = blacken(insertPath(_root, x));
+				drop(_root);
+				_root = updated;
+				++_size;
+				return true;
+			}
+			// true if inserted, false if assigned
+			template <class M>
+			bool insert_or_assign(const key_type& k, M&& obj) {
+				if (findNode(k) == NULL)
+					return insert(value_type(k, std::forward<M>(obj)));
+				node *updated = assignPath(_root, k, std::forward<M>(obj));
+				drop(_root);
+				_root = updated;
+				return false;
+			}
+			size_type erase(const key_type& k) {
+				if (findNode(k) == NULL)
+					return 0;
+				node *updated = erasePath(_root, k);
+				if (updated != NULL)
+					updated = blacken(updated);
+				drop(_root);
+				_root = updated;
+				--_size;
+				return 1;
+			}
+			void swap(persistent_map& x) {
+				std::swap(_root, x._root);
+				std::swap(_size, x._size);
+				std::swap(this->compare(), x.compare());
+			}
+			void clear() {
+				drop(_root);
+				_root = NULL;
+				_size = 0;
+			}
+
+			// lookup
+			const mapped_type& at(const key_type& k) const {
+				const node *x = findNode(k);
+				if (x == NULL)
+					throw std::out_of_range("Key not found");
+				return x->data.second;
+			}
+			bool contains(const key_type& k) const { return findNode(k) != NULL; }
+			size_type count(const key_type& k) const { return contains(k) ? 1 : 0; }
+			const_iterator find(const key_type& k) const {
+				const_iterator it = lower_bound(k);
+				return (it != end() && !keyLess(k, it->first)) ? it : end();
+			}
+			const_iterator lower_bound(const key_type& k) const {
+				// the stack holds the nodes where the search went left
+				const_iterator it;
+				for (const node *x = _root; x != NULL; ) {
+					if (keyLess(x->data.first, k)) {
+						x = x->right;
+					} else {
+						it.path[it.depth++] = x;
+						x = x->left;
+					}
+				}
+				return it;
+			}
+			const_iterator upper_bound(const key_type& k) const {
+				const_iterator it;
+				for (const node *x = _root; x != NULL; ) {
+					if (!keyLess(k, x->data.first)) {
+						x = x->right;
+					} else {
+						it.path[it.depth++] = x;
+						x = x->left;
+					}
+				}
+				return it;
+			}
+
+			// observers
+			key_compare key_comp() const { return this->compare(); }
+			allocator_type get_allocator() const { return allocator_type(_alloc); }
+	};
+
+	template <class Key, class T, class Compare, class Allocator>
+	void persistent_map<Key, T, Compare, Allocator>::drop(node *x) {
+		// the last reference frees the node and drops its children, the
+		// recursion goes no deeper than the tree
+		if (x == NULL || x->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+			return;
+		drop(x->left);
+		drop(x->right);
+		node_traits::destroy(_alloc, x);
+		node_traits::deallocate(_alloc, x, 1);
+	}
+
+	template <class Key, class T, class Compare, class Allocator>
+	template <typename... Args>
+	typename persistent_map<Key, T, Compare, Allocator>::node* persistent_map<Key, T, Compare, Allocator>::make(Color color, node *left, node *right, Args&&... args) {
+		node *x = node_traits::allocate(_alloc, 1);
+		try {
+			node_traits::construct(_alloc, x, color, left, right, std::forward<Args>(args)...);
+		} catch (...) {
+			node_traits::deallocate(_alloc, x, 1);
+			drop(left);
+			drop(right);
+			throw;
+		}
+		return x;
+	}
+
+	template <class Key, class T, class Compare, class Allocator>
+	typename persistent_map<Key, T, Compare, Allocator>::node* persistent_map<Key, T, Compare, Allocator>::takeLeft(node *x) {
+		if (x->refs.load(std::memory_order_acquire) != 1)
+			return share(x->left);
+		node *left = x->left;
+		x->left = NULL;
+		return left;
+	}
+
+	template <class Key, class T, class Compare, class Allocator>
+	typename persistent_map<Key, T, Compare, Allocator>::node* persistent_map<Key, T, Compare, Allocator>::takeRight(node *x) {
+		if (x->refs.load(std::memory_order_acquire) != 1)
+			return share(x->right);
+		node *right = x->right;
+		x->right = NULL;
+		return right;
+	}
+
+	template <class Key, class T, class Compare, class Allocator>
+	typename persistent_map<Key, T, Compare, Allocator>::node* persistent_map<Key, T, Compare, Allocator>::remake(node *x, Color color, node *left, node *right) {
+		if (x->refs.load(std::memory_order_acquire) != 1) {
+			node *copy = make(color, left, right, x->data);
+			drop(x);
+			return copy;
+		}
+		node *oldLeft = x->left;
+		node *oldRight = x->right;
+		x->color = color;
+		x->left = left;
+		x->right = right;
+		drop(oldLeft);
+		drop(oldRight);
+		return x;
+	}
+
+	template <class Key, class T, class Compare, class Allocator>
+	typename persistent_map<Key, T, Compare, Allocator>::node* persistent_map<Key, T, Compare, Allocator>::balance(node *a, node *x, node *b) {
+		if (isRed(a) && isRed(b))
+			return remake(x, RED, blacken(a), blacken(b));
+		if (isRed(a) && isRed(a->left)) {
+			node *inner = takeLeft(a);
+			node *c = takeRight(a);
+			return remake(a, RED, blacken(inner), remake(x, BLACK, c, b));
+		}
+		if (isRed(a) && isRed(a->right)) {
+			node *a1 = takeLeft(a);
+			node *inner = takeRight(a);
+			node *b1 = takeLeft(inner);
+			node *c1 = takeRight(inner);
+			return remake(inner, RED, remake(a, BLACK, a1, b1), remake(x, BLACK, c1, b));
+		}
+		if (isRed(b) && isRed(b->right)) {
+			node *b1 = takeLeft(b);
+			node *inner = takeRight(b);
+			return remake(b, RED, remake(x, BLACK, a, b1), blacken(inner));
+		}
+		if (isRed(b) && isRed(b->left)) {
+			node *inner = takeLeft(b);
+			node *d = takeRight(b);
+			node *b1 = takeLeft(inner);
+			node *c = takeRight(inner);
+			return remake(inner, RED, remake(x, BLACK, a, b1), remake(b, BLACK, c, d));
+		}
+		return remake(x, BLACK, a, b);
+	}
+
+	template <class Key, class T, class Compare, class Allocator>
+	typename persistent_map<Key, T, Compare, Allocator>::node* persistent_map<Key, T, Compare, Allocator>::balLeft(node *a, node *x, node *b) {
+		if (isRed(a))
+			return remake(x, RED, blacken(a), b);
+		if (isBlack(b))
+			return balance(a, x, redden(b));
+		// b is red with a black left child
+		assert(isRed(b) && isBlack(b->left));
+		node *inner = takeLeft(b);
+		node *c = takeRight(b);
+		node *b1 = takeLeft(inner);
+		node *b2 = takeRight(inner);
+		return remake(inner, RED, remake(x, BLACK, a, b1), balance(b2, b, redden(c)));
+	}
+
+	template <class Key, class T, class Compare, class Allocator>
+	typename persistent_map<Key, T, Compare, Allocator>::node* persistent_map<Key, T, Compare, Allocator>::balRight(node *a, node *x, node *b) {
+		if (isRed(b))
+			return remake(x, RED, a, blacken(b));
+		if (isBlack(a))
+			return balance(redden(a), x, b);
+		// a is red with a black right child
+		assert(isRed(a) && isBlack(a->right));
+		node *a1 = takeLeft(a);
+		node *inner = takeRight(a);
+		node *a2 = takeLeft(inner);
+		node *c = takeRight(inner);
+		return remake(inner, RED, balance(redden(a1), a, a2), remake(x, BLACK, c, b));
+	}
+
+	template <class Key, class T, class Compare, class Allocator>
+	typename persistent_map<Key, T, Compare, Allocator>::node* persistent_map<Key, T, Compare, Allocator>::append(node *a, node *b) {
+		if (a == NULL)
+			return b;
+		if (b == NULL)
+			return a;
+		if (a->color == b->color) {
+			Color color = a->color;
+			node *a1 = takeLeft(a);
+			node *a2 = takeRight(a);
+			node *b1 = takeLeft(b);
+			node *b2 = takeRight(b);
+			node *middle = append(a2, b1);
+			if (isRed(middle)) {
+				node *m1 = takeLeft(middle);
+				node *m2 = takeRight(middle);
+				return remake(middle, RED, remake(a, color, a1, m1), remake(b, color, m2, b2));
+			}
+			if (color == RED)
+				return remake(a, RED, a1, remake(b, RED, middle, b2));
+			return balLeft(a1, a, remake(b, BLACK, middle, b2));
+		}
+		if (isRed(b)) {
+			node *b1 = takeLeft(b);
+			node *b2 = takeRight(b);
+			return remake(b, RED, append(a, b1), b2);
+		}
+		node *a1 = takeLeft(a);
+		node *a2 = takeRight(a);
+		return remake(a, RED, a1, append(a2, b));
+	}
+
+	template <class Key, class T, class Compare, class Allocator>
+	typename persistent_map<Key, T, Compare, Allocator>::node* persistent_map<Key, T, Compare, Allocator>::insertPath(const node *s, const value_type &v) {
+		if (s == NULL)
+			return make(RED, NULL, NULL, v);
+		// red nodes are copied as they are, black ones rebalanced
+		node *x;
+		if (keyLess(v.first, s->data.first)) {
+			node *left = insertPath(s->left, v);
+			x = make(s->color, left, share(s->right), s->data);
+		} else {
+			node *right = insertPath(s->right, v);
+			x = make(s->color, share(s->left), right, s->data);
+		}
+		if (x->color == RED)
+			return x;
+		return balance(takeLeft(x), x, takeRight(x));
+	}
+
+	template <class Key, class T, class Compare, class Allocator>
+	typename persistent_map<Key, T, Compare, Allocator>::node* persistent_map<Key, T, Compare, Allocator>::erasePath(const node *s, const Key &key) {
+		if (keyLess(key, s->data.first)) {
+			// a black child loses a level on the way down
+			bool shorter = isBlack(s->left);
+			node *left = erasePath(s->left, key);
+			node *x = make(s->color, left, share(s->right), s->data);
+			left = takeLeft(x);
+			node *right = takeRight(x);
+			return shorter ? balLeft(left, x, right) : remake(x, RED, left, right);
+		}
+		if (keyLess(s->data.first, key)) {
+			bool shorter = isBlack(s->right);
+			node *right = erasePath(s->right, key);
+			node *x = make(s->color, share(s->left), right, s->data);
+			node *left = takeLeft(x);
+			right = takeRight(x);
+			return shorter ? balRight(left, x, right) : remake(x, RED, left, right);
+		}
+		return append(share(s->left), share(s->right));
+	}
+
+	template <class Key, class T, class Compare, class Allocator>
+	template <typename M>
+	typename persistent_map<Key, T, Compare, Allocator>::node* persistent_map<Key, T, Compare, Allocator>::assignPath(const node *s, const Key &key, M &&obj) {
+		if (keyLess(key, s->data.first)) {
+			node *left = assignPath(s->left, key, std::forward<M>(obj));
+			return make(s->color, left, share(s->right), s->data);
+		}
+		if (keyLess(s->data.first, key)) {
+			node *right = assignPath(s->right, key, std::forward<M>(obj));
+			return make(s->color, share(s->left), right, s->data);
+		}
+		return make(s->color, share(s->left), share(s->right), s->data.first, std::forward<M>(obj));
+	}
+
+	template <class Key, class T, class Compare, class Allocator>
+	const typename persistent_map<Key, T, Compare, Allocator>::node* persistent_map<Key, T, Compare, Allocator>::findNode(const Key &key) const {
+		const node *x = _root;
+		while (x != NULL) {
+			if (keyLess(key, x->data.first))
+				x = x->left;
+			else if (keyLess(x->data.first, key))
+				x = x->right;
+			else
+				return x;
+		}
+		return NULL;
+	}
+
+	template <class Key, class T, class Compare, class Allocator>
+	void swap(persistent_map<Key, T, Compare, Allocator> &lhs, persistent_map<Key, T, Compare, Allocator> &rhs) {
+		lhs.swap(rhs);
+	}
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <cstddef>
+#include <optional>
+
+namespace ft {
+
+	// resumable in-order reader over an ordered container (RBTree, map,
+	// btree_map, flat_map, frozen_map, mapped_map, persistent_map, or a
+	// std::map), for jobs that stream a range out in batches: seek() to a
+	// key, optionally until() another, then every next(out, n) copies the
+	// next n elements or fewer to out, with no intermediate container.
+	//
+	// next() walks on from where the previous call stopped, so the
+	// container must not change between calls. if it did, resume() finds
+	// the place again from the last key handed out, in O(log n): elements
+	// inserted after that key are seen, erased ones are not.
+	template <class Container>
+	class range_cursor {
+		public:
+			typedef typename Container::key_type key_type;
+			typedef typename Container::key_compare key_compare;
+			typedef typename Container::const_iterator const_iterator;
+			typedef typename Container::size_type size_type;
+
+		private:
+			const Container *_c;
+			const_iterator _pos;
+			key_compare _comp;
+			// where resume() restarts: the first key not less than the
+			// anchor when inclusive, the first greater one otherwise, the
+			// beginning when there is none
+			std::optional<key_type> _anchor;
+			bool _inclusive;
+			// exclusive upper bound, none for the end of the container
+			std::optional<key_type> _limit;
+
+		public:
+			// at the first element of c
+			explicit range_cursor(const Container &c) : _c(&c), _pos(c.begin()), _comp(c.key_comp()), _inclusive(true) {}
+
+			// positioning, O(log n)
+			void rewind() {
+				_anchor.reset();
+				_pos = _c->begin();
+			}
+			// at the first key not less than k
+			void seek(const key_type &k) {
+				_anchor = k;
+				_inclusive = true;
+				_pos = _c->lower_bound(k);
+			}
+			// at the first key greater than k
+			void seek_after(const key_type &k) {
+				_anchor = k;
+				_inclusive = false;
+				_pos = _c->upper_bound(k);
+			}
+			// back in the container after it changed, see above
+			void resume() {
+				if (!_anchor)
+					_pos = _c->begin();
+				else
+					_pos = _inclusive ? _c->lower_bound(*_anchor) : _c->upper_bound(*_anchor);
+			}
+
+			// stop before the first key not less than k
+			void until(const key_type &k) { _limit = k; }
+			// stop at the end of the container
+			void unbounded() { _limit.reset(); }
+
+			// nothing left before the end or the limit
+			bool done() const { return _pos == _c->end() || (_limit && !_comp(_pos->first, *_limit)); }
+			// the next element next() hands out, if !done()
+			const_iterator position() const { return _pos; }
+
+			// copy up to n elements to out, e.g. a pointer into a buffer of
+			// n pairs or a back_inserter, and move past them. returns how
+			// many, fewer than n only once done()
+			template <class OutputIterator>
+			size_type next(OutputIterator out, size_type n) {
+				const_iterator end = _c->end();
+				const key_type *last = NULL;
+				size_type count = 0;
+				for (; count < n && _pos != end; ++_pos, ++count) {
+					if (_limit && !_comp(_pos->first, *_limit))
+						break;
+					last = &_pos->first;
+					*out = *_pos;
+					++out;
+				}
+				if (last != NULL) {
+					_anchor = *last;
+					_inclusive = false;
+				}
+				return count;
+			}
+	};
+}
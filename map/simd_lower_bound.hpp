@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#if defined(__SSE2__)
+# include <immintrin.h>
+#endif
+
+namespace ft {
+	// lower_bound over a sorted array without data dependent branches.
+	// the search range is halved with conditional moves until it fits in
+	// a couple of cache lines, then the keys less than key in that window
+	// are counted with SIMD compares (SSE2/AVX2 when the compiler targets
+	// them) for ints, 64-bit ints, floats and doubles ordered by std::less,
+	// and with a scalar loop for everything else.
+
+	// number of elements of a[0, n) less than key
+	template <typename T>
+	inline std::size_t count_less(const T *a, std::size_t n, const T &key) {
+		std::size_t count = 0;
+		for (std::size_t i = 0; i < n; ++i)
+			count += a[i] < key;
+		return count;
+	}
+
+	inline std::size_t count_less(const std::int32_t *a, std::size_t n, const std::int32_t &key) {
+		std::size_t i = 0;
+		std::size_t count = 0;
+#if defined(__AVX2__)
+		__m256i k8 = _mm256_set1_epi32(key);
+		for (; i + 8 <= n; i += 8) {
+			__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+			count += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(k8, v))));
+		}
+#endif
+#if defined(__SSE2__)
+		__m128i k4 = _mm_set1_epi32(key);
+		for (; i + 4 <= n; i += 4) {
+			__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+			count += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(v, k4))));
+		}
+#endif
+		for (; i < n; ++i)
+			count += a[i] < key;
+		return count;
+	}
+
+	inline std::size_t count_less(const std::uint32_t *a, std::size_t n, const std::uint32_t &key) {
+		std::size_t i = 0;
+		std::size_t count = 0;
+#if defined(__SSE2__)
+		// flipping the sign bit turns the unsigned order into the signed one
+		__m128i bias = _mm_set1_epi32(INT32_MIN);
+		__m128i k4 = _mm_xor_si128(_mm_set1_epi32(static_cast<std::int32_t>(key)), bias);
+		for (; i + 4 <= n; i += 4) {
+			__m128i v = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i)), bias);
+			count += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(v, k4))));
+		}
+#endif
+		for (; i < n; ++i)
+			count += a[i] < key;
+		return count;
+	}
+
+	inline std::size_t count_less(const std::int64_t *a, std::size_t n, const std::int64_t &key) {
+		std::size_t i = 0;
+		std::size_t count = 0;
+#if defined(__AVX2__)
+		__m256i k4 = _mm256_set1_epi64x(key);
+		for (; i + 4 <= n; i += 4) {
+			__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+			count += __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(k4, v))));
+		}
+#endif
+		for (; i < n; ++i)
+			count += a[i] < key;
+		return count;
+	}
+
+	inline std::size_t count_less(const float *a, std::size_t n, const float &key) {
+		std::size_t i = 0;
+		std::size_t count = 0;
+#if defined(__AVX2__)
+		__m256 k8 = _mm256_set1_ps(key);
+		for (; i + 8 <= n; i += 8)
+			count += __builtin_popcount(_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(a + i), k8, _CMP_LT_OQ)));
+#endif
+#if defined(__SSE2__)
+		__m128 k4 = _mm_set1_ps(key);
+		for (; i + 4 <= n; i += 4)
+			count += __builtin_popcount(_mm_movemask_ps(_mm_cmplt_ps(_mm_loadu_ps(a + i), k4)));
+#endif
+		for (; i < n; ++i)
+			count += a[i] < key;
+		return count;
+	}
+
+	inline std::size_t count_less(const double *a, std::size_t n, const double &key) {
+		std::size_t i = 0;
+		std::size_t count = 0;
+#if defined(__AVX2__)
+		__m256d k4 = _mm256_set1_pd(key);
+		for (; i + 4 <= n; i += 4)
+			count += __builtin_popcount(_mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(a + i), k4, _CMP_LT_OQ)));
+#endif
+#if defined(__SSE2__)
+		__m128d k2 = _mm_set1_pd(key);
+		for (; i + 2 <= n; i += 2)
+			count += __builtin_popcount(_mm_movemask_pd(_mm_cmplt_pd(_mm_loadu_pd(a + i), k2)));
+#endif
+		for (; i < n; ++i)
+			count += a[i] < key;
+		return count;
+	}
+
+	// the fixed width type a key of this size and signedness is searched as
+	template <typename T, bool Integral = std::is_integral<T>::value, std::size_t Size = sizeof(T)>
+	struct simd_key { typedef T type; };
+	template <typename T>
+	struct simd_key<T, true, 4> { typedef typename std::conditional<std::is_signed<T>::value, std::int32_t, std::uint32_t>::type type; };
+	template <typename T>
+	struct simd_key<T, true, 8> { typedef typename std::conditional<std::is_signed<T>::value, std::int64_t, T>::type type; };
+
+	// any comparator: branchless binary search down to one element
+	template <typename T, typename Compare>
+	inline std::size_t sorted_lower_bound(const T *a, std::size_t n, const T &key, const Compare &comp) {
+		if (n == 0)
+			return 0;
+		const T *base = a;
+		while (n > 1) {
+			std::size_t half = n / 2;
+			base = comp(base[half - 1], key) ? base + half : base;
+			n -= half;
+		}
+		return (base - a) + comp(*base, key);
+	}
+
+	// std::less on arithmetic keys: narrow to a window, then count it with SIMD
+	template <typename T>
+	inline std::size_t sorted_lower_bound(const T *a, std::size_t n, const T &key, const std::less<T> &comp) {
+		if (!std::is_arithmetic<T>::value)
+			return sorted_lower_bound<T, std::less<T> >(a, n, key, comp);
+		typedef typename simd_key<T>::type search_type;
+		// two cache lines of keys
+		const std::size_t window = (128 / sizeof(T) > 8) ? 128 / sizeof(T) : 8;
+		const T *base = a;
+		while (n > window) {
+			std::size_t half = n / 2;
+			base = (base[half - 1] < key) ? base + half : base;
+			n -= half;
+		}
+		return (base - a) + count_less(reinterpret_cast<const search_type *>(base), n, *reinterpret_cast<const search_type *>(&key));
+	}
+}
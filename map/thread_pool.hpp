@@ -0,0 +1,225 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace ft {
+	// fork-join pool of std::threads with work stealing, for divide and
+	// conquer over trees. invoke(f, g) queues g on the calling thread's
+	// deque and runs f; the caller then runs queued tasks until g is done,
+	// most of the time g itself since a deque is popped from the back,
+	// while idle threads steal from the front, i.e. the biggest pieces.
+	//
+	// a pool of n threads runs n - 1 of its own, the thread calling invoke
+	// from outside is the n-th. while it waits, that thread only runs the
+	// tasks it forked itself, never one of another thread, so it may hold
+	// locks that no task takes. the pool's own threads run any task while
+	// they wait: tasks must not block on anything but other tasks of the
+	// pool, in particular not on a lock.
+	class thread_pool {
+		private:
+			struct task {
+				std::atomic<bool> done;
+				std::exception_ptr error;
+				// threadTag() of the thread that forked it
+				const void *owner;
+
+				task() : done(false), owner(NULL) {}
+				virtual ~task() {}
+				virtual void run() = 0;
+			};
+
+			template <typename F>
+			struct function_task : task {
+				F &f;
+
+				explicit function_task(F &f) : f(f) {}
+				void run() { f(); }
+			};
+
+			// one per thread, padded so that neighbours don't share a line
+			struct alignas(64) queue {
+				std::mutex lock;
+				std::deque<task *> tasks;
+			};
+
+			// the last queue is shared by the threads that aren't workers
+			std::vector<std::unique_ptr<queue> > _queues;
+			std::vector<std::thread> _threads;
+			std::atomic<std::size_t> _pending;
+			std::mutex _sleepLock;
+			std::condition_variable _wake;
+			bool _stop;
+
+			// the pool the current thread works for and its queue there
+			static const thread_pool*& currentPool() {
+				static thread_local const thread_pool *pool = NULL;
+				return pool;
+			}
+			static std::size_t& currentQueue() {
+				static thread_local std::size_t index = 0;
+				return index;
+			}
+			std::size_t ownQueue() const {
+				return currentPool() == this ? currentQueue() : _queues.size() - 1;
+			}
+			// tells the threads outside the pool apart in the shared queue
+			static const void* threadTag() {
+				static thread_local char tag;
+				return &tag;
+			}
+
+			void push(task *t) {
+				t->owner = threadTag();
+				queue &q = *_queues[ownQueue()];
+				{
+					std::lock_guard<std::mutex> guard(q.lock);
+					q.tasks.push_back(t);
+				}
+				{
+					std::lock_guard<std::mutex> guard(_sleepLock);
+					++_pending;
+				}
+				_wake.notify_one();
+			}
+
+			// run the newest task of our queue or steal the oldest of another,
+			// false if there was none
+			bool runOne() {
+				std::size_t own = ownQueue();
+				task *t = NULL;
+				for (std::size_t i = 0; i < _queues.size() && t == NULL; ++i) {
+					queue &q = *_queues[(own + i) % _queues.size()];
+					std::lock_guard<std::mutex> guard(q.lock);
+					if (q.tasks.empty())
+						continue;
+					if (i == 0) {
+						t = q.tasks.back();
+						q.tasks.pop_back();
+					} else {
+						t = q.tasks.front();
+						q.tasks.pop_front();
+					}
+				}
+				if (t == NULL)
+					return false;
+				execute(t);
+				return true;
+			}
+
+			// for a thread outside the pool: run the newest task it forked
+			// itself that is still queued, false if there is none
+			bool runOwn() {
+				queue &q = *_queues.back();
+				task *t = NULL;
+				{
+					std::lock_guard<std::mutex> guard(q.lock);
+					for (std::size_t i = q.tasks.size(); i-- > 0; ) {
+						if (q.tasks[i]->owner == threadTag()) {
+							t = q.tasks[i];
+							q.tasks.erase(q.tasks.begin() + i);
+							break;
+						}
+					}
+				}
+				if (t == NULL)
+					return false;
+				execute(t);
+				return true;
+			}
+
+			void execute(task *t) {
+				--_pending;
+				try {
+					t->run();
+				} catch (...) {
+					t->error = std::current_exception();
+				}
+				// the owner may destroy t as soon as it sees done
+				t->done.store(true, std::memory_order_release);
+			}
+
+			void work(std::size_t index) {
+				currentPool() = this;
+				currentQueue() = index;
+				for (;;) {
+					if (runOne())
+						continue;
+					std::unique_lock<std::mutex> guard(_sleepLock);
+					_wake.wait(guard, [this] { return _stop || _pending.load() > 0; });
+					if (_stop)
+						return;
+				}
+			}
+
+		public:
+			explicit thread_pool(std::size_t threads = std::thread::hardware_concurrency())
+				: _pending(0), _stop(false) {
+				if (threads == 0)
+					threads = 1;
+				for (std::size_t i = 0; i < threads; ++i)
+					_queues.push_back(std::unique_ptr<queue>(new queue));
+				for (std::size_t i = 0; i + 1 < threads; ++i)
+					_threads.push_back(std::thread(&thread_pool::work, this, i));
+			}
+			~thread_pool() {
+				{
+					std::lock_guard<std::mutex> guard(_sleepLock);
+					_stop = true;
+				}
+				_wake.notify_all();
+				for (std::size_t i = 0; i < _threads.size(); ++i)
+					_threads[i].join();
+			}
+			thread_pool(const thread_pool &) = delete;
+			thread_pool& operator=(const thread_pool &) = delete;
+
+			// threads working on invoke, the caller included
+			std::size_t concurrency() const { return _queues.size(); }
+
+			// run f and g, in parallel when a thread is free, and return once
+			// both are done. an exception of either is rethrown, f's first
+			template <typename F, typename G>
+			void invoke(F &&f, G &&g) {
+				if (_threads.empty()) {
+					f();
+					g();
+					return;
+				}
+				function_task<G> right(g);
+				push(&right);
+				std::exception_ptr error;
+				try {
+					f();
+				} catch (...) {
+					error = std::current_exception();
+				}
+				// right lives on this stack, wait for it in any case. a thread
+				// outside the pool may hold locks unknown to other tasks
+				bool worker = currentPool() == this;
+				while (!right.done.load(std::memory_order_acquire))
+					if (!(worker ? runOne() : runOwn()))
+						std::this_thread::yield();
+				if (error)
+					std::rethrow_exception(error);
+				if (right.error)
+					std::rethrow_exception(right.error);
+			}
+
+			// pool with one thread per hardware thread, created on first use.
+			// it is never destroyed, so that containers destroyed at exit
+			// can still use it
+			static thread_pool& shared() {
+				static thread_pool *pool = new thread_pool;
+				return *pool;
+			}
+	};
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <functional>
+
+namespace ft {
+	struct NodeBase;
+
+	// augmentation policies for RBTree.
+	// a policy adds node_data to every node and recomputes it in update()
+	// from the node and its (possibly NULL) children. the tree calls update()
+	// bottom-up after every structural change: along the path of an inserted
+	// or erased node, on both nodes of a rotation and while building.
+	//
+	// policies that fold a value over their subtree also provide value_type,
+	// identity(), combine(), lift() (the value of one node) and get() (the
+	// value of a whole subtree), which RBTree::range_aggregate() relies on.
+	//
+	// folds_values says whether node_data depends on the mapped values and
+	// not only on the keys. the tree can't see a value change through a
+	// reference, so for such a policy its iterators give read-only
+	// elements, operator[] and the non-const at() don't compile, and a
+	// value is changed with RBTree::update() or insert_or_assign().
+	struct no_augment {
+		struct node_data {};
+		typedef void value_type;
+		static const bool enabled = false;
+		// whether node_data holds subtree_size (rank, select, distance)
+		static const bool sized = false;
+		static const bool folds_values = false;
+
+		template <typename NodeType>
+		static std::size_t size(const NodeBase *) { return 0; }
+
+		template <typename NodeType>
+		static void update(NodeType *) {}
+	};
+
+	// number of nodes in every subtree: O(log n) rank, select and distance,
+	// range_aggregate() counts the keys in a range
+	struct order_statistic {
+		struct node_data {
+			std::size_t subtree_size;
+		};
+		typedef std::size_t value_type;
+		static const bool enabled = true;
+		static const bool sized = true;
+		static const bool folds_values = false;
+
+		template <typename NodeType>
+		static std::size_t size(const NodeBase *x) {
+			return x != NULL ? static_cast<const NodeType *>(x)->subtree_size : 0;
+		}
+
+		static value_type identity() { return 0; }
+		static value_type combine(value_type a, value_type b) { return a + b; }
+
+		template <typename NodeType>
+		static value_type lift(const NodeType *) { return 1; }
+
+		template <typename NodeType>
+		static value_type get(const NodeBase *x) { return size<NodeType>(x); }
+
+		template <typename NodeType>
+		static void update(NodeType *x) {
+			x->subtree_size = 1 + size<NodeType>(x->left) + size<NodeType>(x->right);
+		}
+	};
+
+	// associative operations for subtree_aggregate, identity() is the
+	// value of an empty range
+	template <typename T>
+	struct sum_op {
+		T operator()(const T &a, const T &b) const { return a + b; }
+		static T identity() { return T(); }
+	};
+
+	template <typename T>
+	struct min_op {
+		T operator()(const T &a, const T &b) const { return b < a ? b : a; }
+		static T identity() { return std::numeric_limits<T>::max(); }
+	};
+
+	template <typename T>
+	struct max_op {
+		T operator()(const T &a, const T &b) const { return a < b ? b : a; }
+		static T identity() { return std::numeric_limits<T>::lowest(); }
+	};
+
+	// fold of the mapped values of every subtree with an associative Op
+	template <typename T, typename Op>
+	struct subtree_aggregate {
+		struct node_data {
+			T aggregate;
+		};
+		typedef T value_type;
+		static const bool enabled = true;
+		static const bool sized = false;
+		static const bool folds_values = true;
+
+		template <typename NodeType>
+		static std::size_t size(const NodeBase *) { return 0; }
+
+		static T identity() { return Op::identity(); }
+		static T combine(const T &a, const T &b) { return Op()(a, b); }
+
+		template <typename NodeType>
+		static T lift(const NodeType *x) { return T(x->data.second); }
+
+		template <typename NodeType>
+		static T get(const NodeBase *x) {
+			return x != NULL ? static_cast<const NodeType *>(x)->aggregate : identity();
+		}
+
+		template <typename NodeType>
+		static void update(NodeType *x) {
+			x->aggregate = combine(combine(get<NodeType>(x->left), lift(x)), get<NodeType>(x->right));
+		}
+	};
+
+	template <typename T>
+	struct subtree_sum : subtree_aggregate<T, sum_op<T> > {};
+
+	template <typename T>
+	struct subtree_min : subtree_aggregate<T, min_op<T> > {};
+
+	template <typename T>
+	struct subtree_max : subtree_aggregate<T, max_op<T> > {};
+
+	// largest high end in every subtree of a tree keyed by intervals (any
+	// key with a high member), what an interval tree prunes its overlap
+	// searches with. Compare must be stateless, the policy default-constructs it
+	template <typename Bound, typename Compare = std::less<Bound> >
+	struct max_interval_end {
+		struct node_data {
+			Bound max_end;
+		};
+		typedef void value_type;
+		static const bool enabled = true;
+		static const bool sized = false;
+		static const bool folds_values = false;
+
+		template <typename NodeType>
+		static std::size_t size(const NodeBase *) { return 0; }
+
+		template <typename NodeType>
+		static void update(NodeType *x) {
+			Compare comp;
+			x->max_end = x->data.first.high;
+			if (x->left != NULL && comp(x->max_end, static_cast<NodeType *>(x->left)->max_end))
+				x->max_end = static_cast<NodeType *>(x->left)->max_end;
+			if (x->right != NULL && comp(x->max_end, static_cast<NodeType *>(x->right)->max_end))
+				x->max_end = static_cast<NodeType *>(x->right)->max_end;
+		}
+	};
+}
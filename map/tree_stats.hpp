@@ -0,0 +1,181 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+namespace ft {
+	// instrumentation policies for RBTree. the tree reports to its policy
+	// every key comparison, every search (one per walk down from the root),
+	// insertion, erasure, rotation, node allocation and fixDoubleBlack step.
+	//
+	// no_stats, the default, does nothing and compiles away. tree_stats
+	// counts into counters of the calling thread, with plain loads and
+	// stores, that collect() sums over every thread that ever counted, from
+	// any thread at any time: the hook a benchmark or an exporter polls.
+	struct no_stats {
+		static const bool enabled = false;
+
+		static void comparison() {}
+		static void search() {}
+		static void insertion() {}
+		static void erasure() {}
+		static void rotation() {}
+		static void allocation(std::size_t) {}
+		static void double_black() {}
+	};
+
+	// counts since program start, of one thread or summed
+	struct tree_counters {
+		std::uint64_t comparisons;
+		std::uint64_t searches;
+		std::uint64_t insertions;
+		std::uint64_t erasures;
+		std::uint64_t rotations;
+		std::uint64_t allocations;
+		// fixDoubleBlack calls, and the most a single erasure made, i.e.
+		// the deepest its recursion went
+		std::uint64_t double_black_steps;
+		std::uint64_t double_black_max_depth;
+	};
+
+	// what happened between two collect()s, the max depth is the later one's
+	inline tree_counters operator-(const tree_counters &a, const tree_counters &b) {
+		tree_counters d = {
+			a.comparisons - b.comparisons,
+			a.searches - b.searches,
+			a.insertions - b.insertions,
+			a.erasures - b.erasures,
+			a.rotations - b.rotations,
+			a.allocations - b.allocations,
+			a.double_black_steps - b.double_black_steps,
+			a.double_black_max_depth
+		};
+		return d;
+	}
+
+	// one "<prefix><name> <value>" line per counter, the text format of
+	// most metrics scrapers
+	inline void write_counters(std::ostream &os, const tree_counters &c, const char *prefix = "ft_rbtree_") {
+		os << prefix << "comparisons " << c.comparisons << '\n'
+			<< prefix << "searches " << c.searches << '\n'
+			<< prefix << "insertions " << c.insertions << '\n'
+			<< prefix << "erasures " << c.erasures << '\n'
+			<< prefix << "rotations " << c.rotations << '\n'
+			<< prefix << "allocations " << c.allocations << '\n'
+			<< prefix << "double_black_steps " << c.double_black_steps << '\n'
+			<< prefix << "double_black_max_depth " << c.double_black_max_depth << '\n';
+	}
+
+	class tree_stats {
+		private:
+			enum {
+				comparisonsAt,
+				searchesAt,
+				insertionsAt,
+				erasuresAt,
+				rotationsAt,
+				allocationsAt,
+				stepsAt,
+				maxDepthAt,
+				counterCount
+			};
+
+			// counters of a thread, linked in a list that only grows. a
+			// record is reused, counts included, by the next thread once
+			// its owner exits, so the sums never go down
+			struct alignas(64) record {
+				// written by the owner only, atomic so collect() can read them
+				std::atomic<std::uint64_t> counters[counterCount];
+				std::atomic<bool> inUse;
+				record *next;
+				// fixDoubleBlack steps of the erasure in progress, owner only
+				std::uint64_t depth;
+
+				record() : inUse(true), next(NULL), depth(0) {
+					for (int i = 0; i < counterCount; ++i)
+						counters[i].store(0, std::memory_order_relaxed);
+				}
+			};
+
+			static std::atomic<record *>& records() {
+				static std::atomic<record *> head(NULL);
+				return head;
+			}
+
+			// claims a free record for the thread, gives it back at exit
+			struct owner {
+				record *rec;
+
+				owner() {
+					for (rec = records().load(std::memory_order_acquire); rec != NULL; rec = rec->next) {
+						bool free = false;
+						if (!rec->inUse.load(std::memory_order_relaxed) && rec->inUse.compare_exchange_strong(free, true))
+							return;
+					}
+					rec = new record;
+					record *head = records().load(std::memory_order_relaxed);
+					do {
+						rec->next = head;
+					} while (!records().compare_exchange_weak(head, rec, std::memory_order_release, std::memory_order_relaxed));
+				}
+				~owner() { rec->inUse.store(false, std::memory_order_release); }
+			};
+
+			static record& local() {
+				static thread_local owner o;
+				return *o.rec;
+			}
+
+			// the owner is the only writer, no read-modify-write needed
+			static void add(record &r, int i, std::uint64_t n) {
+				r.counters[i].store(r.counters[i].load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+			}
+
+		public:
+			static const bool enabled = true;
+
+			static void comparison() { add(local(), comparisonsAt, 1); }
+			static void search() { add(local(), searchesAt, 1); }
+			static void insertion() { add(local(), insertionsAt, 1); }
+			static void rotation() { add(local(), rotationsAt, 1); }
+			static void allocation(std::size_t n) { add(local(), allocationsAt, n); }
+			static void double_black() {
+				record &r = local();
+				++r.depth;
+				add(r, stepsAt, 1);
+			}
+			// after the rebalancing, which closes its fixDoubleBlack chain
+			static void erasure() {
+				record &r = local();
+				add(r, erasuresAt, 1);
+				if (r.depth > r.counters[maxDepthAt].load(std::memory_order_relaxed))
+					r.counters[maxDepthAt].store(r.depth, std::memory_order_relaxed);
+				r.depth = 0;
+			}
+
+			// sums of every thread's counters, the max depth is the largest
+			static tree_counters collect() {
+				std::uint64_t sum[counterCount] = {};
+				for (record *r = records().load(std::memory_order_acquire); r != NULL; r = r->next) {
+					for (int i = 0; i < counterCount; ++i) {
+						std::uint64_t v = r->counters[i].load(std::memory_order_relaxed);
+						if (i == maxDepthAt)
+							sum[i] = v > sum[i] ? v : sum[i];
+						else
+							sum[i] += v;
+					}
+				}
+				tree_counters c = {
+					sum[comparisonsAt], sum[searchesAt], sum[insertionsAt], sum[erasuresAt],
+					sum[rotationsAt], sum[allocationsAt], sum[stepsAt], sum[maxDepthAt]
+				};
+				return c;
+			}
+			// write_counters of collect()
+			static void dump(std::ostream &os, const char *prefix = "ft_rbtree_") {
+				write_counters(os, collect(), prefix);
+			}
+	};
+}